@@ -2,19 +2,52 @@
 #define ALGORITHM_HPP
 
 #include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "details/argmax_kernels.hpp"
+#include "details/copy_kernels.hpp"
+#include "details/mismatch_kernels.hpp"
+#include "details/permute.hpp"
+#include "details/radix_sort.hpp"
+#include "details/segmented_argmax.hpp"
+#include "details/topk.hpp"
+#include "execution.hpp"
+#include "type_traits.hpp"
 
 namespace utils {
   /**
    * Finds the index of the maximum element in a range.
    *
+   * If several elements are equal to the maximum, the index of the first one is
+   * returned. For contiguous ranges of float, double and 32/64-bit signed
+   * integers the search runs on SSE4.2, AVX2 or AVX-512 kernels chosen at run
+   * time; other ranges use std::max_element.
+   *
+   * NaN elements compare unordered and are never selected, except when the
+   * first element is NaN: like std::max_element, 0 is then returned.
+   *
    * @tparam Iterator Type of the input iterator.
    * @param first Iterator to the beginning of the range.
    * @param last Iterator to the end of the range.
-   * @return The index of the maximum element in the range.
+   * @return The index of the maximum element in the range, 0 for an empty range.
    */
   template<typename Iterator>
   std::size_t argmax(Iterator first, Iterator last) {
-    return std::distance(first, std::max_element(first, last));
+    using value_type = typename std::iterator_traits<Iterator>::value_type;
+    if constexpr (is_contiguous_iterator_v<Iterator> &&
+                  details::has_simd_lane_v<value_type>) {
+      const auto n{static_cast<std::size_t>(std::distance(first, last))};
+      if (!n || details::is_unordered(*first)) { return 0; }
+      return details::argmax_ordered(std::addressof(*first), n);
+    } else {
+      return std::distance(first, std::max_element(first, last));
+    }
   }
 
   template<typename InputIt1, typename InputIt2, typename UnaryPred>
@@ -43,6 +76,116 @@ namespace utils {
     return std::make_pair(max_cond != last1, arg_max_cond);
   }
 
+  /**
+   * Finds the index of the maximum element in a range using an execution
+   * policy.
+   *
+   * With execution::parallel_policy the range is split into chunks whose
+   * winners are merged in chunk order, so the result is always equal to
+   * argmax(first, last), including the choice of the lowest index among equal
+   * maxima and the NaN rules.
+   *
+   * @tparam ExecutionPolicy execution::sequenced_policy or
+   * execution::parallel_policy.
+   * @tparam RandomIt Type of the random access iterator.
+   * @param policy The execution policy to use.
+   * @param first Iterator to the beginning of the range.
+   * @param last Iterator to the end of the range.
+   * @return The index of the maximum element in the range, 0 for an empty range.
+   */
+  template<typename ExecutionPolicy, typename RandomIt>
+  std::enable_if_t<execution::is_execution_policy_v<remove_cvref_t<ExecutionPolicy>>, std::size_t>
+  argmax(ExecutionPolicy &&policy, RandomIt first, RandomIt last) {
+    if constexpr (std::is_same_v<remove_cvref_t<ExecutionPolicy>, execution::sequenced_policy>) {
+      return argmax(first, last);
+    } else {
+      const auto n{static_cast<std::size_t>(std::distance(first, last))};
+      if (!n || details::is_unordered(*first)) { return 0; }
+      const auto chunk{details::chunk_size(policy, n, std::size_t{1} << 16)};
+      const auto tasks{(n + chunk - 1) / chunk};
+      std::vector<std::size_t> winners(tasks);
+      details::parallel_for(policy, tasks, [&](const std::size_t task) {
+        const auto begin{task * chunk};
+        const auto size{std::min(chunk, n - begin)};
+        const auto local{details::argmax_range(std::next(first, begin), size)};
+        winners[task] = local == size ? n : begin + local;
+      });
+      std::size_t best{0};
+      for (const auto winner: winners) {
+        if (winner != n && *std::next(first, best) < *std::next(first, winner)) {
+          best = winner;
+        }
+      }
+      return best;
+    }
+  }
+
+  /**
+   * Finds the index of the maximum element in a range that satisfies a given
+   * predicate, using an execution policy.
+   *
+   * The result is always equal to argmax_conditional(first1, last1, first2, p).
+   * The predicate may be called concurrently from several threads.
+   *
+   * @tparam ExecutionPolicy execution::sequenced_policy or
+   * execution::parallel_policy.
+   * @tparam RandomIt1 Type of the first random access iterator.
+   * @tparam RandomIt2 Type of the second random access iterator.
+   * @tparam UnaryPred Type of the unary predicate.
+   * @param policy The execution policy to use.
+   * @param first1 Iterator to the beginning of the first range.
+   * @param last1 Iterator to the end of the first range.
+   * @param first2 Iterator to the beginning of the second range.
+   * @param p Unary predicate that returns true for the elements to be considered.
+   * @return A pair where the first element is a boolean indicating if a valid
+   * maximum element was found, and the second element is the index of the maximum
+   * element in the first range that satisfies the predicate.
+   */
+  template<typename ExecutionPolicy, typename RandomIt1, typename RandomIt2, typename UnaryPred>
+  std::enable_if_t<execution::is_execution_policy_v<remove_cvref_t<ExecutionPolicy>>,
+                   std::pair<bool, std::size_t>>
+  argmax_conditional(ExecutionPolicy &&policy, RandomIt1 first1, RandomIt1 last1,
+                     RandomIt2 first2, UnaryPred p) {
+    if constexpr (std::is_same_v<remove_cvref_t<ExecutionPolicy>, execution::sequenced_policy>) {
+      return argmax_conditional(first1, last1, first2, p);
+    } else {
+      const auto n{static_cast<std::size_t>(std::distance(first1, last1))};
+      const auto chunk{details::chunk_size(policy, n, std::size_t{1} << 16)};
+      const auto tasks{(n + chunk - 1) / chunk};
+      // For every chunk: the first eligible element and the first maximum among
+      // the eligible ordered elements, n meaning none.
+      std::vector<std::pair<std::size_t, std::size_t>> winners(tasks, {n, n});
+      details::parallel_for(policy, tasks, [&](const std::size_t task) {
+        const auto begin{task * chunk};
+        const auto end{std::min(n, begin + chunk)};
+        auto it1{std::next(first1, begin)};
+        auto it2{std::next(first2, begin)};
+        auto &[first_match, best]{winners[task]};
+        for (auto i{begin}; i < end; ++i, ++it1, ++it2) {
+          if (!p(*it2)) { continue; }
+          if (first_match == n) { first_match = i; }
+          if (details::is_unordered(*it1)) { continue; }
+          if (best == n || *it1 > *std::next(first1, best)) { best = i; }
+        }
+      });
+      // A NaN as the first eligible element is never replaced, as in the
+      // sequential algorithm.
+      const auto first_chunk{std::find_if(winners.begin(), winners.end(),
+                                          [n](const auto &w) { return w.first != n; })};
+      if (first_chunk == winners.end()) { return std::make_pair(false, n); }
+      if (details::is_unordered(*std::next(first1, first_chunk->first))) {
+        return std::make_pair(true, first_chunk->first);
+      }
+      auto best{n};
+      for (auto it{first_chunk}; it != winners.end(); ++it) {
+        if (it->second != n && (best == n || *std::next(first1, it->second) > *std::next(first1, best))) {
+          best = it->second;
+        }
+      }
+      return std::make_pair(true, best);
+    }
+  }
+
   /**
    * @brief Copies a range of elements multiple times to a destination.
    *
@@ -50,6 +193,11 @@ namespace utils {
    * range starting at d_first, n times. The destination range must be large enough
    * to hold n copies of the input range.
    *
+   * When both ranges are contiguous over the same trivially copyable type, the
+   * source is copied once and the written region is then doubled with memcpy,
+   * so only about log2(n) copies are issued. Outputs larger than the last level
+   * cache are written with non-temporal stores instead.
+   *
    * @tparam InputIt Input iterator type for the source range.
    * @tparam OutputIt Output iterator type for the destination range.
    *
@@ -66,16 +214,89 @@ namespace utils {
   OutputIt copy_range_n_times(InputIt first, InputIt last, OutputIt d_first,
                               std::size_t n) {
     if (!n) { return d_first; }
-    auto size{std::distance(first, last)};
-    for (auto i{0}; i < n - 1; ++i) {
-      std::copy(first, last, std::next(d_first, i * size));
+    if constexpr (details::is_memcpy_copyable_v<InputIt, OutputIt>) {
+      using value_type = typename std::iterator_traits<OutputIt>::value_type;
+      const auto size{std::distance(first, last)};
+      if (!size) { return d_first; }
+      const auto bytes{static_cast<std::size_t>(size) * sizeof(value_type)};
+      const auto total{bytes * n};
+      details::fill_repeated(reinterpret_cast<char *>(std::addressof(*d_first)),
+                             reinterpret_cast<const char *>(std::addressof(*first)),
+                             bytes, 0, total, total > details::nontemporal_threshold().load());
+      return std::next(d_first, size * static_cast<std::ptrdiff_t>(n));
+    } else {
+      for (std::size_t i{0}; i < n; ++i) {
+        d_first = std::copy(first, last, d_first);
+      }
+      return d_first;
+    }
+  }
+
+  /**
+   * @brief Copies a range of elements multiple times to a destination using an
+   * execution policy.
+   *
+   * With execution::parallel_policy the destination is split into disjoint
+   * slices filled concurrently. Contiguous trivially copyable ranges are split
+   * at byte granularity, each slice using the doubling and non-temporal paths
+   * of copy_range_n_times(); other random access destinations are split at
+   * copy granularity.
+   *
+   * @tparam ExecutionPolicy execution::sequenced_policy or
+   * execution::parallel_policy.
+   * @tparam ForwardIt Forward iterator type for the source range.
+   * @tparam OutputIt Output iterator type for the destination range.
+   * @param policy The execution policy to use.
+   * @param first The beginning of the source range.
+   * @param last The end of the source range.
+   * @param d_first The beginning of the destination range.
+   * @param n The number of times to copy the source range.
+   * @return OutputIt Iterator to the end of the last copied range.
+   */
+  template<typename ExecutionPolicy, typename ForwardIt, typename OutputIt>
+  std::enable_if_t<execution::is_execution_policy_v<remove_cvref_t<ExecutionPolicy>>, OutputIt>
+  copy_range_n_times(ExecutionPolicy &&policy, ForwardIt first, ForwardIt last,
+                     OutputIt d_first, std::size_t n) {
+    using output_category = typename std::iterator_traits<OutputIt>::iterator_category;
+    if constexpr (std::is_same_v<remove_cvref_t<ExecutionPolicy>, execution::sequenced_policy> ||
+                  !std::is_base_of_v<std::random_access_iterator_tag, output_category>) {
+      return copy_range_n_times(first, last, d_first, n);
+    } else {
+      const auto size{std::distance(first, last)};
+      if (!n || !size) { return d_first; }
+      if constexpr (details::is_memcpy_copyable_v<ForwardIt, OutputIt>) {
+        using value_type = typename std::iterator_traits<OutputIt>::value_type;
+        const auto bytes{static_cast<std::size_t>(size) * sizeof(value_type)};
+        const auto total{bytes * n};
+        const auto stream{total > details::nontemporal_threshold().load()};
+        const auto dst{reinterpret_cast<char *>(std::addressof(*d_first))};
+        const auto src{reinterpret_cast<const char *>(std::addressof(*first))};
+        const auto chunk{details::chunk_size(policy, total, std::size_t{1} << 20)};
+        details::parallel_for(policy, (total + chunk - 1) / chunk, [&](const std::size_t task) {
+          const auto begin{task * chunk};
+          details::fill_repeated(dst, src, bytes, begin, std::min(total, begin + chunk), stream);
+        });
+      } else {
+        const auto chunk{details::chunk_size(policy, n, 1)};
+        details::parallel_for(policy, (n + chunk - 1) / chunk, [&](const std::size_t task) {
+          const auto begin{task * chunk};
+          const auto end{std::min(n, begin + chunk)};
+          for (auto i{begin}; i < end; ++i) {
+            std::copy(first, last, std::next(d_first, static_cast<std::ptrdiff_t>(i) * size));
+          }
+        });
+      }
+      return std::next(d_first, size * static_cast<std::ptrdiff_t>(n));
     }
-    return std::copy(first, last, std::next(d_first, (n - 1) * size));
   }
 
   /**
    * Finds the maximum element in a range that satisfies a given predicate.
    *
+   * The ranges are traversed once. For arithmetic element types eligibility and
+   * comparison are folded into selects, so random predicate results do not
+   * cause branch mispredictions.
+   *
    * @tparam InputIt1 Type of the first input iterator.
    * @tparam InputIt2 Type of the second input iterator.
    * @tparam UnaryPred Type of the unary predicate.
@@ -89,25 +310,530 @@ namespace utils {
   template<typename InputIt1, typename InputIt2, typename UnaryPred>
   InputIt1 max_element_conditional(InputIt1 first1, InputIt1 last1,
                                    InputIt2 first2, UnaryPred p) {
-    first2 = std::find_if(first2, std::next(first2, std::distance(first1, last1)),
-                          [&first1, &p](const auto &e) {
-                            if (p(e))
-                              return true;
-                            ++first1;
-                            return false;
-                          });
-    auto max_element{first1};
-    for (; first1 != last1; ++first1, ++first2) {
-      if (*first1 > *max_element && p(*first2)) {
-        max_element = first1;
+    using value_type = typename std::iterator_traits<InputIt1>::value_type;
+    auto max_element{last1};
+    if constexpr (std::is_arithmetic_v<value_type>) {
+      value_type max_value{};
+      bool found{false};
+      for (; first1 != last1; ++first1, ++first2) {
+        const bool eligible{static_cast<bool>(p(*first2))};
+        const value_type value{*first1};
+        const bool take{static_cast<bool>(eligible & (!found | (value > max_value)))};
+        max_value = take ? value : max_value;
+        max_element = take ? first1 : max_element;
+        found |= eligible;
+      }
+    } else {
+      for (; first1 != last1; ++first1, ++first2) {
+        if (p(*first2) && (max_element == last1 || *first1 > *max_element)) {
+          max_element = first1;
+        }
       }
     }
     return max_element;
   }
 
+  /**
+   * Finds the maximum element in a range whose bit is set in a packed bitmask.
+   *
+   * Element i is eligible when bit (i % 64) of mask[i / 64] is set. Contiguous
+   * ranges of float, double and 32/64-bit signed integers skip all-zero mask
+   * words and consume the others on SIMD kernels chosen at run time.
+   *
+   * @tparam InputIt Type of the input iterator.
+   * @param first Iterator to the beginning of the range.
+   * @param last Iterator to the end of the range.
+   * @param mask Pointer to at least ceil(std::distance(first, last) / 64) words.
+   * @return Iterator to the maximum eligible element, last if there is none.
+   */
+  template<typename InputIt>
+  InputIt max_element_conditional(InputIt first, InputIt last,
+                                  const std::uint64_t *mask) {
+    using value_type = typename std::iterator_traits<InputIt>::value_type;
+    if constexpr (is_contiguous_iterator_v<InputIt> &&
+                  details::has_simd_lane_v<value_type>) {
+      const auto n{static_cast<std::size_t>(std::distance(first, last))};
+      if (!n) { return last; }
+      return std::next(first, details::argmax_masked(std::addressof(*first), n, mask));
+    } else {
+      auto max_element{last};
+      for (std::size_t i{0}; first != last; ++first, ++i) {
+        if (details::mask_bit(mask, i) && (max_element == last || *first > *max_element)) {
+          max_element = first;
+        }
+      }
+      return max_element;
+    }
+  }
+
+  /**
+   * Finds the index of the maximum element in a range whose bit is set in a
+   * packed bitmask.
+   *
+   * @tparam InputIt Type of the input iterator.
+   * @param first Iterator to the beginning of the range.
+   * @param last Iterator to the end of the range.
+   * @param mask Pointer to at least ceil(std::distance(first, last) / 64) words,
+   * element i is eligible when bit (i % 64) of mask[i / 64] is set.
+   * @return A pair where the first element is a boolean indicating if a valid
+   * maximum element was found, and the second element is its index.
+   */
+  template<typename InputIt>
+  std::pair<bool, std::size_t> argmax_conditional(InputIt first, InputIt last,
+                                                  const std::uint64_t *mask) {
+    const auto max_cond{max_element_conditional(first, last, mask)};
+    const auto arg_max_cond{std::distance(first, max_cond)};
+    return std::make_pair(max_cond != last, arg_max_cond);
+  }
+
+  /**
+   * @brief Computes the argmax of every segment of a CSR-style layout.
+   *
+   * Segment s covers values [offsets_first[s], offsets_first[s + 1]), so
+   * std::distance(offsets_first, offsets_last) - 1 indices are written, each
+   * relative to the start of its segment and equal to argmax() over the
+   * segment (0 for an empty one). For contiguous values of float, double and
+   * 32/64-bit signed integers, short segments are batched into the lanes of
+   * AVX2 or AVX-512 gathers, one segment per lane, instead of paying the set-up
+   * cost of a full argmax per segment.
+   *
+   * @tparam RandomIt1 Type of the random access iterator for the values.
+   * @tparam RandomIt2 Type of the random access iterator for the offsets.
+   * @tparam OutputIt Type of the output iterator, accepting std::size_t.
+   * @param values Iterator to the beginning of the values.
+   * @param offsets_first Iterator to the beginning of the offsets.
+   * @param offsets_last Iterator to the end of the offsets.
+   * @param d_first Iterator to the beginning of the destination range.
+   * @return Iterator past the last index written.
+   */
+  template<typename RandomIt1, typename RandomIt2, typename OutputIt>
+  OutputIt segmented_argmax(RandomIt1 values, RandomIt2 offsets_first, RandomIt2 offsets_last,
+                            OutputIt d_first) {
+    using value_type = typename std::iterator_traits<RandomIt1>::value_type;
+    const auto offsets{static_cast<std::size_t>(std::distance(offsets_first, offsets_last))};
+    if (offsets < 2) { return d_first; }
+    if constexpr (is_contiguous_iterator_v<RandomIt1> && details::has_simd_lane_v<value_type>) {
+      if (offsets_first[offsets - 1] != offsets_first[0]) {
+        details::segmented_argmax_range(std::addressof(*values), 0, offsets - 1, [offsets_first](const std::size_t s) {
+          const auto start{static_cast<std::size_t>(offsets_first[s])};
+          return std::make_pair(start, static_cast<std::size_t>(offsets_first[s + 1]) - start);
+        }, [&d_first](std::size_t, const std::size_t index) { *d_first++ = index; });
+        return d_first;
+      }
+    }
+    for (std::size_t s{0}; s + 1 < offsets; ++s) {
+      *d_first++ = argmax(std::next(values, offsets_first[s]), std::next(values, offsets_first[s + 1]));
+    }
+    return d_first;
+  }
+
+  /**
+   * @brief Computes the argmax of every segment of a CSR-style layout using an
+   * execution policy.
+   *
+   * With execution::parallel_policy the segments are split into chunks
+   * processed concurrently; the result is the same as the sequential overload.
+   *
+   * @tparam ExecutionPolicy execution::sequenced_policy or
+   * execution::parallel_policy.
+   * @tparam RandomIt1 Type of the random access iterator for the values.
+   * @tparam RandomIt2 Type of the random access iterator for the offsets.
+   * @tparam RandomIt3 Type of the random access iterator for the destination.
+   * @param policy The execution policy to use.
+   * @param values Iterator to the beginning of the values.
+   * @param offsets_first Iterator to the beginning of the offsets.
+   * @param offsets_last Iterator to the end of the offsets.
+   * @param d_first Iterator to the beginning of the destination range.
+   * @return Iterator past the last index written.
+   */
+  template<typename ExecutionPolicy, typename RandomIt1, typename RandomIt2, typename RandomIt3>
+  std::enable_if_t<execution::is_execution_policy_v<remove_cvref_t<ExecutionPolicy>>, RandomIt3>
+  segmented_argmax(ExecutionPolicy &&policy, RandomIt1 values, RandomIt2 offsets_first,
+                   RandomIt2 offsets_last, RandomIt3 d_first) {
+    if constexpr (std::is_same_v<remove_cvref_t<ExecutionPolicy>, execution::sequenced_policy>) {
+      return segmented_argmax(values, offsets_first, offsets_last, d_first);
+    } else {
+      const auto offsets{static_cast<std::size_t>(std::distance(offsets_first, offsets_last))};
+      if (offsets < 2) { return d_first; }
+      const auto segments{offsets - 1};
+      const auto chunk{details::chunk_size(policy, segments, std::size_t{1} << 10)};
+      details::parallel_for(policy, (segments + chunk - 1) / chunk, [&](const std::size_t task) {
+        const auto begin{task * chunk};
+        const auto end{std::min(segments, begin + chunk)};
+        segmented_argmax(values, std::next(offsets_first, begin), std::next(offsets_first, end + 1),
+                         std::next(d_first, begin));
+      });
+      return std::next(d_first, segments);
+    }
+  }
+
+  /**
+   * @brief Computes the argmax of every row of a dense row-major matrix.
+   *
+   * Row r covers [data + r * stride, data + r * stride + cols). One index per
+   * row is written, equal to argmax() over the row. Matrices of short rows
+   * are batched into SIMD lanes as in segmented_argmax().
+   *
+   * @tparam RandomIt Type of the random access iterator for the matrix.
+   * @tparam OutputIt Type of the output iterator, accepting std::size_t.
+   * @param data Iterator to the first element of the matrix.
+   * @param rows Number of rows.
+   * @param cols Number of columns.
+   * @param stride Distance in elements between the starts of two rows, at
+   * least cols.
+   * @param d_first Iterator to the beginning of the destination range.
+   * @return Iterator past the last index written.
+   */
+  template<typename RandomIt, typename OutputIt>
+  OutputIt rowwise_argmax(RandomIt data, const std::size_t rows, const std::size_t cols,
+                          const std::size_t stride, OutputIt d_first) {
+    using value_type = typename std::iterator_traits<RandomIt>::value_type;
+    if constexpr (is_contiguous_iterator_v<RandomIt> && details::has_simd_lane_v<value_type>) {
+      if (rows && cols) {
+        details::segmented_argmax_range(std::addressof(*data), 0, rows, [cols, stride](const std::size_t r) {
+          return std::make_pair(r * stride, cols);
+        }, [&d_first](std::size_t, const std::size_t index) { *d_first++ = index; });
+        return d_first;
+      }
+    }
+    for (std::size_t r{0}; r < rows; ++r) {
+      const auto row{std::next(data, static_cast<std::ptrdiff_t>(r * stride))};
+      *d_first++ = argmax(row, std::next(row, static_cast<std::ptrdiff_t>(cols)));
+    }
+    return d_first;
+  }
+
+  /**
+   * @brief Computes the argmax of every row of a dense row-major matrix using
+   * an execution policy.
+   *
+   * With execution::parallel_policy the rows are split into chunks processed
+   * concurrently; the result is the same as the sequential overload.
+   *
+   * @tparam ExecutionPolicy execution::sequenced_policy or
+   * execution::parallel_policy.
+   * @tparam RandomIt1 Type of the random access iterator for the matrix.
+   * @tparam RandomIt2 Type of the random access iterator for the destination.
+   * @param policy The execution policy to use.
+   * @param data Iterator to the first element of the matrix.
+   * @param rows Number of rows.
+   * @param cols Number of columns.
+   * @param stride Distance in elements between the starts of two rows.
+   * @param d_first Iterator to the beginning of the destination range.
+   * @return Iterator past the last index written.
+   */
+  template<typename ExecutionPolicy, typename RandomIt1, typename RandomIt2>
+  std::enable_if_t<execution::is_execution_policy_v<remove_cvref_t<ExecutionPolicy>>, RandomIt2>
+  rowwise_argmax(ExecutionPolicy &&policy, RandomIt1 data, const std::size_t rows,
+                 const std::size_t cols, const std::size_t stride, RandomIt2 d_first) {
+    if constexpr (std::is_same_v<remove_cvref_t<ExecutionPolicy>, execution::sequenced_policy>) {
+      return rowwise_argmax(data, rows, cols, stride, d_first);
+    } else {
+      const auto min_grain{std::max<std::size_t>(1, (std::size_t{1} << 16) / std::max<std::size_t>(1, cols))};
+      const auto chunk{details::chunk_size(policy, rows, min_grain)};
+      details::parallel_for(policy, (rows + chunk - 1) / chunk, [&](const std::size_t task) {
+        const auto begin{task * chunk};
+        rowwise_argmax(std::next(data, static_cast<std::ptrdiff_t>(begin * stride)),
+                       std::min(chunk, rows - begin), cols, stride, std::next(d_first, begin));
+      });
+      return std::next(d_first, rows);
+    }
+  }
+
+  /**
+   * @brief Streaming argmax over data received in chunks.
+   *
+   * Each update consumes the next chunk and advances a running global offset,
+   * so result() equals argmax() (or argmax_conditional() for the conditional
+   * updates) over the concatenation of all chunks, including the lowest index
+   * rule for equal maxima and the NaN rules. Contiguous chunks of float,
+   * double and 32/64-bit signed integers use the same SIMD kernels as the
+   * range overloads.
+   *
+   * Accumulators fed with disjoint parts of the same sequence, e.g. one per
+   * thread with offsets set by the constructor, are combined with merge().
+   * An accumulator should use either the plain or the conditional updates,
+   * since the first considered element has different rules in each case.
+   *
+   * @tparam T The element type.
+   */
+  template<typename T>
+  class argmax_accumulator {
+  public:
+    argmax_accumulator() = default;
+
+    /**
+     * @brief Constructs an accumulator whose first chunk starts at the given
+     * global index.
+     *
+     * @param offset Global index of the first element of the first chunk.
+     */
+    explicit argmax_accumulator(const std::size_t offset) noexcept : offset_{offset} {}
+
+    /**
+     * @brief Consumes the next chunk.
+     *
+     * @tparam InputIt Type of the input iterator.
+     * @param first Iterator to the beginning of the chunk.
+     * @param last Iterator to the end of the chunk.
+     */
+    template<typename InputIt>
+    void update(InputIt first, InputIt last) {
+      using value_type = typename std::iterator_traits<InputIt>::value_type;
+      if constexpr (is_contiguous_iterator_v<InputIt> && details::has_simd_lane_v<T> &&
+                    std::is_same_v<std::remove_cv_t<value_type>, T>) {
+        const auto n{static_cast<std::size_t>(std::distance(first, last))};
+        if (!n) { return; }
+        const auto data{std::addressof(*first)};
+        observe_first(data[0], offset_);
+        const auto best{details::argmax_ordered(data, n)};
+        if (best != n) { observe_ordered(data[best], offset_ + best); }
+        offset_ += n;
+      } else {
+        for (; first != last; ++first, ++offset_) {
+          observe(*first, offset_);
+        }
+      }
+    }
+
+    /**
+     * @brief Consumes the next chunk, considering only the elements for which
+     * a predicate on a second range returns true.
+     *
+     * @tparam InputIt1 Type of the first input iterator.
+     * @tparam InputIt2 Type of the second input iterator.
+     * @tparam UnaryPred Type of the unary predicate.
+     * @param first1 Iterator to the beginning of the chunk.
+     * @param last1 Iterator to the end of the chunk.
+     * @param first2 Iterator to the beginning of the second range.
+     * @param p Unary predicate that returns true for the elements to be considered.
+     */
+    template<typename InputIt1, typename InputIt2, typename UnaryPred>
+    void update_conditional(InputIt1 first1, InputIt1 last1, InputIt2 first2, UnaryPred p) {
+      for (; first1 != last1; ++first1, ++first2, ++offset_) {
+        if (p(*first2)) { observe(*first1, offset_); }
+      }
+    }
+
+    /**
+     * @brief Consumes the next chunk, considering only the elements whose bit
+     * is set in a packed bitmask.
+     *
+     * @tparam InputIt Type of the input iterator.
+     * @param first Iterator to the beginning of the chunk.
+     * @param last Iterator to the end of the chunk.
+     * @param mask Pointer to at least ceil(std::distance(first, last) / 64) words,
+     * bit 0 of mask[0] standing for the first element of the chunk.
+     */
+    template<typename InputIt>
+    void update_conditional(InputIt first, InputIt last, const std::uint64_t *mask) {
+      using value_type = typename std::iterator_traits<InputIt>::value_type;
+      if constexpr (is_contiguous_iterator_v<InputIt> && details::has_simd_lane_v<T> &&
+                    std::is_same_v<std::remove_cv_t<value_type>, T>) {
+        const auto n{static_cast<std::size_t>(std::distance(first, last))};
+        const auto data{std::addressof(*first)};
+        const auto eligible{details::next_mask_bit(mask, 0, n)};
+        if (eligible == n) {
+          offset_ += n;
+          return;
+        }
+        observe_first(data[eligible], offset_ + eligible);
+        const auto best{details::argmax_masked_ordered(data, n, mask, eligible)};
+        if (best != n) { observe_ordered(data[best], offset_ + best); }
+        offset_ += n;
+      } else {
+        for (std::size_t i{0}; first != last; ++first, ++i, ++offset_) {
+          if (details::mask_bit(mask, i)) { observe(*first, offset_); }
+        }
+      }
+    }
+
+    /**
+     * @brief Combines the result of an accumulator fed with another part of
+     * the same sequence, which may come before or after this one.
+     *
+     * @param other The accumulator to merge into this one.
+     */
+    void merge(const argmax_accumulator &other) {
+      if (!other.has_first_) { return; }
+      if (!has_first_ || other.first_index_ < first_index_) {
+        has_first_ = true;
+        first_index_ = other.first_index_;
+        first_value_ = other.first_value_;
+      }
+      if (other.has_best_) { observe_ordered(other.best_value_, other.best_index_); }
+      offset_ = std::max(offset_, other.offset_);
+    }
+
+    /**
+     * @brief Returns the result over all the elements consumed so far.
+     *
+     * @return A pair where the first element is a boolean indicating if an
+     * element was considered, and the second element is the global index of
+     * the maximum, 0 if there is none.
+     */
+    std::pair<bool, std::size_t> result() const noexcept {
+      if (!has_first_) { return std::make_pair(false, std::size_t{0}); }
+      return std::make_pair(true, first_wins() ? first_index_ : best_index_);
+    }
+
+    /**
+     * @brief Returns the element at result().second, which must exist.
+     */
+    const T &value() const noexcept { return first_wins() ? first_value_ : best_value_; }
+
+    /**
+     * @brief Returns the global index of the next element to be consumed.
+     */
+    std::size_t offset() const noexcept { return offset_; }
+
+  private:
+    bool first_wins() const noexcept { return !has_best_ || details::is_unordered(first_value_); }
+
+    void observe_first(const T &value, const std::size_t index) {
+      if (!has_first_) {
+        has_first_ = true;
+        first_index_ = index;
+        first_value_ = value;
+      }
+    }
+
+    // Keeps the larger value, or the lower index between equal values.
+    void observe_ordered(const T &value, const std::size_t index) {
+      if (!has_best_ || best_value_ < value || (!(value < best_value_) && index < best_index_)) {
+        has_best_ = true;
+        best_index_ = index;
+        best_value_ = value;
+      }
+    }
+
+    void observe(const T &value, const std::size_t index) {
+      observe_first(value, index);
+      if (!details::is_unordered(value)) { observe_ordered(value, index); }
+    }
+
+    std::size_t offset_{0};
+    bool has_first_{false};
+    std::size_t first_index_{0};
+    T first_value_{};
+    bool has_best_{false};
+    std::size_t best_index_{0};
+    T best_value_{};
+  };
+
+  /**
+   * @brief Writes the indices of the k largest elements of a range.
+   *
+   * The result holds min(k, m) indices, m being the number of elements that
+   * are not NaN, which are skipped. Ties are broken towards the lower index,
+   * so with sorted output the first index is the one returned by argmax(),
+   * unless the range starts with NaN: argmax() then returns 0, as
+   * std::max_element does, while argtopk() still skips the NaN and writes the
+   * index of the largest other element first.
+   *
+   * When k is small relative to the range a bounded heap of k entries is kept:
+   * for contiguous ranges of float, double and 32/64-bit signed integers, SIMD
+   * kernels chosen at run time skip every element not greater than the
+   * current k-th value. Larger k use std::nth_element on an index array.
+   *
+   * @tparam RandomIt Type of the random access iterator.
+   * @tparam OutputIt Type of the output iterator, accepting std::size_t.
+   * @param first Iterator to the beginning of the range.
+   * @param last Iterator to the end of the range.
+   * @param k Number of indices to select.
+   * @param d_first Iterator to the beginning of the destination range.
+   * @param sorted If true, the indices are written by decreasing value,
+   * otherwise in unspecified order.
+   * @return Iterator past the last index written.
+   */
+  template<typename RandomIt, typename OutputIt>
+  OutputIt argtopk(RandomIt first, RandomIt last, std::size_t k,
+                   OutputIt d_first, const bool sorted = true) {
+    using value_type = typename std::iterator_traits<RandomIt>::value_type;
+    const auto n{static_cast<std::size_t>(std::distance(first, last))};
+    k = std::min(k, n);
+    if (!k) { return d_first; }
+    if (k * 16 > n) {
+      return details::topk_select_if(first, n, k, d_first, sorted, [first](std::size_t i) {
+        return !details::is_unordered(first[i]);
+      });
+    }
+
+    details::topk_heap<value_type> heap{k};
+    std::size_t i{0};
+    for (; i < n && !heap.full(); ++i) {
+      if (!details::is_unordered(first[i])) { heap.push(first[i], i); }
+    }
+    if constexpr (is_contiguous_iterator_v<RandomIt> &&
+                  details::has_simd_lane_v<value_type>) {
+      const auto data{std::addressof(*first)};
+      while ((i = details::find_greater(data, i, n, heap.threshold())) < n) {
+        heap.push(data[i], i);
+        ++i;
+      }
+    } else {
+      for (; i < n; ++i) {
+        if (heap.threshold() < first[i]) { heap.push(first[i], i); }
+      }
+    }
+    return heap.write(d_first, sorted);
+  }
+
+  /**
+   * @brief Writes the indices of the k largest elements of a range among those
+   * for which a predicate on a second range returns true.
+   *
+   * Selection, NaN handling and ordering follow argtopk(): eligible NaN
+   * elements are never selected, even the first one, which
+   * argmax_conditional() returns.
+   *
+   * @tparam RandomIt Type of the random access iterator.
+   * @tparam InputIt Type of the input iterator of the second range.
+   * @tparam OutputIt Type of the output iterator, accepting std::size_t.
+   * @tparam UnaryPred Type of the unary predicate.
+   * @param first1 Iterator to the beginning of the first range.
+   * @param last1 Iterator to the end of the first range.
+   * @param first2 Iterator to the beginning of the second range.
+   * @param k Number of indices to select.
+   * @param d_first Iterator to the beginning of the destination range.
+   * @param p Unary predicate that returns true for the elements to be considered.
+   * @param sorted If true, the indices are written by decreasing value,
+   * otherwise in unspecified order.
+   * @return Iterator past the last index written.
+   */
+  template<typename RandomIt, typename InputIt, typename OutputIt, typename UnaryPred>
+  OutputIt argtopk_conditional(RandomIt first1, RandomIt last1, InputIt first2,
+                               std::size_t k, OutputIt d_first, UnaryPred p,
+                               const bool sorted = true) {
+    using value_type = typename std::iterator_traits<RandomIt>::value_type;
+    const auto n{static_cast<std::size_t>(std::distance(first1, last1))};
+    k = std::min(k, n);
+    if (!k) { return d_first; }
+    if (k * 16 > n) {
+      // The second range is only an input range, so the predicate is
+      // evaluated in order up front rather than from the selection.
+      std::vector<unsigned char> eligible(n);
+      for (std::size_t i{0}; i < n; ++i, ++first2) {
+        eligible[i] = p(*first2) && !details::is_unordered(first1[i]);
+      }
+      return details::topk_select_if(first1, n, k, d_first, sorted,
+                                     [&eligible](std::size_t i) { return eligible[i] != 0; });
+    }
+
+    details::topk_heap<value_type> heap{k};
+    for (std::size_t i{0}; i < n; ++i, ++first2) {
+      if (p(*first2) && !details::is_unordered(first1[i])) { heap.push(first1[i], i); }
+    }
+    return heap.write(d_first, sorted);
+  }
+
   /**
   * @brief Finds the first position where two ranges differ, starting from the end.
   *
+  * Contiguous ranges of the same integral, enumeration or pointer type are
+  * compared as bytes, 16, 32 or 64 at a time on SIMD kernels chosen at run
+  * time; other ranges are compared element by element.
+  *
   * @tparam BidirIt1 Bidirectional iterator type for the first range.
   * @tparam BidirIt2 Bidirectional iterator type for the second range.
   *
@@ -120,47 +846,180 @@ namespace utils {
   std::pair<BidirIt1, BidirIt2>
   mismatch_from_end(BidirIt1 first1, BidirIt1 last1,
                     BidirIt2 last2) {
-    auto pair{
-      std::mismatch(
-        std::reverse_iterator(last1), std::reverse_iterator(first1),
-        std::reverse_iterator(last2))
-    };
-    return std::pair(pair.first.base(), pair.second.base());
+    if constexpr (details::is_bytewise_comparable_v<BidirIt1, BidirIt2>) {
+      using value_type = typename std::iterator_traits<BidirIt1>::value_type;
+      const auto n{std::distance(first1, last1)};
+      if (!n) { return std::pair(last1, last2); }
+      const auto suffix_bytes{details::common_suffix(
+          reinterpret_cast<const char *>(std::addressof(*std::prev(last1)) + 1),
+          reinterpret_cast<const char *>(std::addressof(*std::prev(last2)) + 1),
+          static_cast<std::size_t>(n) * sizeof(value_type))};
+      const auto suffix{static_cast<std::ptrdiff_t>(suffix_bytes / sizeof(value_type))};
+      return std::pair(std::prev(last1, suffix), std::prev(last2, suffix));
+    } else {
+      auto pair{
+        std::mismatch(
+          std::reverse_iterator(last1), std::reverse_iterator(first1),
+          std::reverse_iterator(last2))
+      };
+      return std::pair(pair.first.base(), pair.second.base());
+    }
   }
 
   /**
    * @brief Reorders elements in a range based on given indices.
    *
    * This function reorders the elements in the range [first1, last1) according to the
-   * indices provided in the range starting at indices_first2. The indices specify the
-   * new positions of the elements.
+   * indices provided in the range starting at indices_first: after the call the
+   * element at position j is the one previously at position indices_first[j].
+   *
+   * The permutation is applied with the given strategy: in place along its cycles,
+   * visited positions being tracked in a side bit-vector; out of place through a
+   * scratch buffer; or, for data much larger than the caches, through a gather
+   * partitioned by source block. reorder_strategy::automatic picks one from the
+   * size of the range and the element type.
    *
-   * @note It is assumed that the indices are valid and within the range [0, std::distance(first1, last1)).
-   * @remark Range [indices_first2, std::next(indices_first2, std::distance(first1, last1))) is modified.
+   * @note It is assumed that the indices are a permutation of [0, std::distance(first1, last1)).
+   * @remark The indices are not modified.
    *
    * @tparam RandomIt1 Type of the random access iterator for the elements.
    * @tparam RandomIt2 Type of the random access iterator for the indices.
    * @param first1 Iterator to the beginning of the elements range.
    * @param last1 Iterator to the end of the elements range.
    * @param indices_first Iterator to the beginning of the indices range.
+   * @param strategy The permutation strategy to use.
    */
   template<typename RandomIt1, typename RandomIt2>
-  void reorder_elements_by_indices(RandomIt1 first1, RandomIt1 last1, RandomIt2 indices_first) {
-    using integer_type = typename std::iterator_traits<RandomIt2>::value_type;
-    auto distance{std::distance(first1, last1)};
-
-    for (integer_type i{0}; i < distance; ++i) {
-      integer_type current{i};
-      auto current_it{std::next(indices_first, current)};
-
-      while (i != *current_it) {
-        auto next{*current_it};
-        std::swap(*std::next(first1, current), *std::next(first1, next));
-        *current_it = current;
-        current = next;
-        current_it = std::next(indices_first, current);
-      }
-      *current_it = current;
+  void reorder_elements_by_indices(RandomIt1 first1, RandomIt1 last1, RandomIt2 indices_first,
+                                   reorder_strategy strategy = reorder_strategy::automatic) {
+    using value_type = typename std::iterator_traits<RandomIt1>::value_type;
+    const auto n{static_cast<std::size_t>(std::distance(first1, last1))};
+    if (strategy == reorder_strategy::automatic) {
+      strategy = details::choose_reorder_strategy<value_type>(n);
+    }
+    switch (strategy) {
+    case reorder_strategy::blocked:
+      if constexpr (std::is_default_constructible_v<value_type>) {
+        return details::reorder_blocked(execution::seq, first1, n, indices_first);
+      }
+      [[fallthrough]];
+    case reorder_strategy::gather:
+      return details::reorder_gather(first1, n, indices_first);
+    default:
+      return details::reorder_cycles(first1, n, indices_first);
+    }
+  }
+
+  /**
+   * @brief Reorders elements in a range based on given indices using an
+   * execution policy.
+   *
+   * With execution::parallel_policy the cycles strategy moves independent
+   * cycles concurrently once their leaders are known, the gather strategy
+   * splits the destination positions and the blocked strategy processes source
+   * blocks concurrently. The result is the same as the sequential overload.
+   * The gather and blocked strategies require default constructible elements,
+   * other types are permuted along their cycles.
+   *
+   * @tparam ExecutionPolicy execution::sequenced_policy or
+   * execution::parallel_policy.
+   * @tparam RandomIt1 Type of the random access iterator for the elements.
+   * @tparam RandomIt2 Type of the random access iterator for the indices.
+   * @param policy The execution policy to use.
+   * @param first1 Iterator to the beginning of the elements range.
+   * @param last1 Iterator to the end of the elements range.
+   * @param indices_first Iterator to the beginning of the indices range.
+   * @param strategy The permutation strategy to use.
+   */
+  template<typename ExecutionPolicy, typename RandomIt1, typename RandomIt2>
+  std::enable_if_t<execution::is_execution_policy_v<remove_cvref_t<ExecutionPolicy>>>
+  reorder_elements_by_indices(ExecutionPolicy &&policy, RandomIt1 first1, RandomIt1 last1,
+                              RandomIt2 indices_first,
+                              reorder_strategy strategy = reorder_strategy::automatic) {
+    using value_type = typename std::iterator_traits<RandomIt1>::value_type;
+    if constexpr (std::is_same_v<remove_cvref_t<ExecutionPolicy>, execution::sequenced_policy>) {
+      reorder_elements_by_indices(first1, last1, indices_first, strategy);
+    } else {
+      const auto n{static_cast<std::size_t>(std::distance(first1, last1))};
+      if (strategy == reorder_strategy::automatic) {
+        strategy = details::choose_reorder_strategy<value_type>(n);
+      }
+      if constexpr (std::is_default_constructible_v<value_type>) {
+        if (strategy == reorder_strategy::blocked) {
+          return details::reorder_blocked(policy, first1, n, indices_first);
+        }
+        if (strategy == reorder_strategy::gather) {
+          return details::reorder_gather(policy, first1, n, indices_first);
+        }
+      }
+      details::reorder_cycles(policy, first1, n, indices_first);
+    }
+  }
+
+  /**
+   * @brief Writes the indices that stably sort a range with a comparator.
+   *
+   * The indices are written in the order of the elements they refer to, equal
+   * elements keeping their relative order, so that passing them to
+   * reorder_elements_by_indices() sorts the range. Indices are 32-bit
+   * internally when the range has fewer than 2^32 elements.
+   *
+   * @tparam RandomIt Type of the random access iterator.
+   * @tparam OutputIt Type of the output iterator, accepting std::size_t.
+   * @tparam Compare Type of the comparator.
+   * @param first Iterator to the beginning of the range.
+   * @param last Iterator to the end of the range.
+   * @param d_first Iterator to the beginning of the destination range.
+   * @param comp Comparator returning true if its first argument is ordered
+   * before its second.
+   * @return Iterator past the last index written.
+   */
+  template<typename RandomIt, typename OutputIt, typename Compare>
+  OutputIt argsort(RandomIt first, RandomIt last, OutputIt d_first, Compare comp) {
+    const auto n{static_cast<std::size_t>(std::distance(first, last))};
+    const auto run{[&](auto index_tag) {
+      using Index = decltype(index_tag);
+      std::vector<Index> indices(n);
+      std::iota(indices.begin(), indices.end(), Index{0});
+      std::stable_sort(indices.begin(), indices.end(), [first, &comp](const Index a, const Index b) {
+        return comp(first[a], first[b]);
+      });
+      return std::transform(indices.begin(), indices.end(), d_first, [](const Index i) {
+        return static_cast<std::size_t>(i);
+      });
+    }};
+    if (n <= std::size_t{0xFFFFFFFF}) { return run(std::uint32_t{}); }
+    return run(std::size_t{});
+  }
+
+  /**
+   * @brief Writes the indices that stably sort a range in ascending order.
+   *
+   * Integral keys and IEEE 754 float and double keys are sorted with an LSD
+   * radix sort on (key, index) pairs, 32-bit indices being used when the range
+   * has fewer than 2^32 elements. Floating point keys follow the IEEE 754 total
+   * order: -0.0 is ordered before +0.0 and NaNs go to the ends according to
+   * their sign. Other types are sorted with argsort(first, last, d_first,
+   * std::less<>{}).
+   *
+   * @tparam RandomIt Type of the random access iterator.
+   * @tparam OutputIt Type of the output iterator, accepting std::size_t.
+   * @param first Iterator to the beginning of the range.
+   * @param last Iterator to the end of the range.
+   * @param d_first Iterator to the beginning of the destination range.
+   * @return Iterator past the last index written.
+   */
+  template<typename RandomIt, typename OutputIt>
+  OutputIt argsort(RandomIt first, RandomIt last, OutputIt d_first) {
+    using value_type = typename std::iterator_traits<RandomIt>::value_type;
+    if constexpr (details::has_radix_key_v<value_type>) {
+      const auto n{static_cast<std::size_t>(std::distance(first, last))};
+      if (n <= std::size_t{0xFFFFFFFF}) {
+        return details::radix_argsort<std::uint32_t>(first, n, d_first);
+      }
+      return details::radix_argsort<std::size_t>(first, n, d_first);
+    } else {
+      return argsort(first, last, d_first, std::less<>{});
     }
   }
 } // namespace utils
@@ -0,0 +1,494 @@
+#ifndef DETAILS_ARGMAX_KERNELS_HPP
+#define DETAILS_ARGMAX_KERNELS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+
+#include "../type_traits.hpp"
+#include "simd_ops.hpp"
+
+namespace utils {
+namespace details {
+/**
+ * @brief Returns the index of the first element of [data, data + n) that is
+ * not unordered (NaN), or n if there is none.
+ */
+template <typename T>
+std::size_t first_ordered(const T *data, const std::size_t n) noexcept {
+  if constexpr (std::is_floating_point_v<T>) {
+    for (std::size_t i{0}; i < n; ++i) {
+      if (!is_unordered(data[i])) {
+        return i;
+      }
+    }
+    return n;
+  } else {
+    return 0;
+  }
+}
+
+/**
+ * @brief Reduces SIMD lanes to the largest value, ties going to the lowest
+ * index.
+ */
+template <typename L, typename I>
+std::pair<L, std::size_t> reduce_lanes(const L *values, const I *indices,
+                                       const std::size_t lanes) noexcept {
+  L best_value{values[0]};
+  auto best{static_cast<std::size_t>(indices[0])};
+  for (std::size_t k{1}; k < lanes; ++k) {
+    const auto index{static_cast<std::size_t>(indices[k])};
+    if (values[k] > best_value || (values[k] == best_value && index < best)) {
+      best_value = values[k];
+      best = index;
+    }
+  }
+  return {best_value, best};
+}
+
+/**
+ * @brief Picks the winner among SIMD lanes and scans the remaining elements.
+ *
+ * [i, n) is scanned with a strict comparison so that the first maximum wins.
+ */
+template <typename L, typename I, typename T>
+std::size_t argmax_finish(const L *values, const I *indices,
+                          const std::size_t lanes, const T *data, std::size_t i,
+                          const std::size_t n) noexcept {
+  auto [best_value, best]{reduce_lanes(values, indices, lanes)};
+  for (; i < n; ++i) {
+    if (data[i] > best_value) {
+      best_value = data[i];
+      best = i;
+    }
+  }
+  return best;
+}
+
+/**
+ * @brief Returns bit i of a packed bitmask.
+ */
+inline bool mask_bit(const std::uint64_t *mask, const std::size_t i) noexcept {
+  return (mask[i / 64] >> (i % 64)) & 1u;
+}
+
+/**
+ * @brief Picks the winner among SIMD lanes and scans the remaining elements
+ * whose bit is set in mask.
+ */
+template <typename L, typename I, typename T>
+std::size_t argmax_masked_finish(const L *values, const I *indices,
+                                 const std::size_t lanes, const T *data,
+                                 const std::uint64_t *mask, std::size_t i,
+                                 const std::size_t n) noexcept {
+  auto [best_value, best]{reduce_lanes(values, indices, lanes)};
+  for (; i < n; ++i) {
+    const bool take{
+        static_cast<bool>(mask_bit(mask, i) & (data[i] > best_value))};
+    best_value = take ? data[i] : best_value;
+    best = take ? i : best;
+  }
+  return best;
+}
+
+/**
+ * @brief Scalar argmax over [data + start, data + n), where data[start] is
+ * ordered. Unordered elements are never selected.
+ */
+template <typename T>
+std::size_t argmax_scalar(const T *data, const std::size_t start,
+                          const std::size_t n) noexcept {
+  auto best{start};
+  for (auto i{start + 1}; i < n; ++i) {
+    if (data[i] > data[best]) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+#if LIBUTILS_X86_SIMD
+/*
+ * Defines argmax_<ISA>(data, start, n) for one instruction set. The kernel
+ * keeps `unroll` independent (value, index) accumulators to hide the
+ * compare/blend latency; every lane starts at (data[start], start) and only
+ * moves on a strict `greater`, so each lane holds the first maximum of the
+ * positions it visited and NaNs are never taken.
+ */
+#define LIBUTILS_DEFINE_ARGMAX_KERNEL(ISA, TARGET)                            \
+  template <typename Ops, typename T>                                          \
+  TARGET std::size_t argmax_##ISA(const T *data, const std::size_t start,      \
+                                  const std::size_t n) noexcept {              \
+    using L = simd_lane_t<T>;                                                  \
+    using I = typename Ops::index_type;                                        \
+    constexpr std::size_t lanes{Ops::width};                                   \
+    constexpr std::size_t unroll{4};                                           \
+    typename Ops::vector best[unroll];                                         \
+    typename Ops::index_vector best_index[unroll];                             \
+    typename Ops::index_vector index[unroll];                                  \
+    for (std::size_t k{0}; k < unroll; ++k) {                                  \
+      best[k] = Ops::broadcast(static_cast<L>(data[start]));                   \
+      best_index[k] = Ops::index_broadcast(static_cast<I>(start));             \
+      index[k] = Ops::index_iota(static_cast<I>(start + k * lanes));           \
+    }                                                                          \
+    const auto step{Ops::index_broadcast(static_cast<I>(lanes * unroll))};     \
+    auto i{start};                                                             \
+    for (; i + lanes * unroll <= n; i += lanes * unroll) {                     \
+      for (std::size_t k{0}; k < unroll; ++k) {                                \
+        const auto v{Ops::load(data + i + k * lanes)};                         \
+        const auto m{Ops::greater(v, best[k])};                                \
+        best[k] = Ops::select(m, v, best[k]);                                  \
+        best_index[k] = Ops::index_select(m, index[k], best_index[k]);         \
+        index[k] = Ops::index_add(index[k], step);                             \
+      }                                                                        \
+    }                                                                          \
+    const auto single_step{Ops::index_broadcast(static_cast<I>(lanes))};       \
+    for (; i + lanes <= n; i += lanes) {                                       \
+      const auto v{Ops::load(data + i)};                                       \
+      const auto m{Ops::greater(v, best[0])};                                  \
+      best[0] = Ops::select(m, v, best[0]);                                    \
+      best_index[0] = Ops::index_select(m, index[0], best_index[0]);           \
+      index[0] = Ops::index_add(index[0], single_step);                        \
+    }                                                                          \
+    L values[lanes * unroll];                                                  \
+    I indices[lanes * unroll];                                                 \
+    for (std::size_t k{0}; k < unroll; ++k) {                                  \
+      Ops::store(values + k * lanes, best[k]);                                 \
+      Ops::index_store(indices + k * lanes, best_index[k]);                    \
+    }                                                                          \
+    return argmax_finish(values, indices, lanes * unroll, data, i, n);         \
+  }
+
+LIBUTILS_DEFINE_ARGMAX_KERNEL(sse42, LIBUTILS_TARGET_SSE42)
+LIBUTILS_DEFINE_ARGMAX_KERNEL(avx2, LIBUTILS_TARGET_AVX2)
+LIBUTILS_DEFINE_ARGMAX_KERNEL(avx512, LIBUTILS_TARGET_AVX512)
+
+#undef LIBUTILS_DEFINE_ARGMAX_KERNEL
+#endif // LIBUTILS_X86_SIMD
+
+/**
+ * @brief Scalar masked argmax over [data + start, data + n), where
+ * data[start] is ordered and eligible. Uses selects instead of branches.
+ */
+template <typename T>
+std::size_t argmax_masked_scalar(const T *data, const std::size_t start,
+                                 const std::size_t n,
+                                 const std::uint64_t *mask) noexcept {
+  T best_value{data[start]};
+  auto best{start};
+  for (auto i{start + 1}; i < n; ++i) {
+    const bool take{
+        static_cast<bool>(mask_bit(mask, i) & (data[i] > best_value))};
+    best_value = take ? data[i] : best_value;
+    best = take ? i : best;
+  }
+  return best;
+}
+
+#if LIBUTILS_X86_SIMD
+/*
+ * Defines argmax_masked_<ISA>(data, start, n, mask). Elements are consumed one
+ * mask word (64 elements) at a time: all-zero words are skipped, the others
+ * are split into groups of `width` bits that are expanded to lane masks and
+ * and-ed with the comparison, so eligibility never causes a branch.
+ * Eligible elements before `start` are all NaN and are never taken.
+ */
+#define LIBUTILS_DEFINE_ARGMAX_MASKED_KERNEL(ISA, TARGET)                     \
+  template <typename Ops, typename T>                                          \
+  TARGET std::size_t argmax_masked_##ISA(                                      \
+      const T *data, const std::size_t start, const std::size_t n,             \
+      const std::uint64_t *mask) noexcept {                                    \
+    using L = simd_lane_t<T>;                                                  \
+    using I = typename Ops::index_type;                                        \
+    constexpr std::size_t lanes{Ops::width};                                   \
+    constexpr std::size_t groups{64 / lanes};                                  \
+    constexpr std::size_t unroll{groups < 4 ? groups : 4};                     \
+    constexpr std::uint64_t group_bits{(std::uint64_t{1} << lanes) - 1};       \
+    typename Ops::vector best[unroll];                                         \
+    typename Ops::index_vector best_index[unroll];                             \
+    for (std::size_t k{0}; k < unroll; ++k) {                                  \
+      best[k] = Ops::broadcast(static_cast<L>(data[start]));                   \
+      best_index[k] = Ops::index_broadcast(static_cast<I>(start));             \
+    }                                                                          \
+    const auto step{Ops::index_broadcast(static_cast<I>(lanes))};              \
+    auto word{start / 64};                                                     \
+    for (; (word + 1) * 64 <= n; ++word) {                                     \
+      const auto bits{mask[word]};                                             \
+      if (!bits) {                                                             \
+        continue;                                                              \
+      }                                                                        \
+      const auto base{word * 64};                                              \
+      auto index{Ops::index_iota(static_cast<I>(base))};                       \
+      for (std::size_t g{0}; g < groups; ++g) {                                \
+        const auto k{g % unroll};                                              \
+        const auto v{Ops::load(data + base + g * lanes)};                      \
+        const auto m{Ops::mask_and(                                            \
+            Ops::greater(v, best[k]),                                          \
+            Ops::mask_from_bits(                                               \
+                static_cast<unsigned>((bits >> (g * lanes)) & group_bits)))};  \
+        best[k] = Ops::select(m, v, best[k]);                                  \
+        best_index[k] = Ops::index_select(m, index, best_index[k]);            \
+        index = Ops::index_add(index, step);                                   \
+      }                                                                        \
+    }                                                                          \
+    L values[lanes * unroll];                                                  \
+    I indices[lanes * unroll];                                                 \
+    for (std::size_t k{0}; k < unroll; ++k) {                                  \
+      Ops::store(values + k * lanes, best[k]);                                 \
+      Ops::index_store(indices + k * lanes, best_index[k]);                    \
+    }                                                                          \
+    return argmax_masked_finish(values, indices, lanes * unroll, data, mask,   \
+                                std::max(start, word * 64), n);                \
+  }
+
+LIBUTILS_DEFINE_ARGMAX_MASKED_KERNEL(sse42, LIBUTILS_TARGET_SSE42)
+LIBUTILS_DEFINE_ARGMAX_MASKED_KERNEL(avx2, LIBUTILS_TARGET_AVX2)
+LIBUTILS_DEFINE_ARGMAX_MASKED_KERNEL(avx512, LIBUTILS_TARGET_AVX512)
+
+#undef LIBUTILS_DEFINE_ARGMAX_MASKED_KERNEL
+#endif // LIBUTILS_X86_SIMD
+
+#if LIBUTILS_X86_SIMD
+/*
+ * Defines find_greater_<ISA>(data, i, n, threshold), which returns the index
+ * of the first element of [data + i, data + n) greater than threshold, or n.
+ * Four vectors are compared per iteration and their lane masks are combined
+ * into one 64-bit word, so the position is found with a single tzcnt.
+ */
+#define LIBUTILS_DEFINE_FIND_GREATER_KERNEL(ISA, TARGET)                      \
+  template <typename Ops, typename T>                                          \
+  TARGET std::size_t find_greater_##ISA(const T *data, std::size_t i,          \
+                                        const std::size_t n,                   \
+                                        const T threshold) noexcept {          \
+    using L = simd_lane_t<T>;                                                  \
+    constexpr std::size_t lanes{Ops::width};                                   \
+    const auto t{Ops::broadcast(static_cast<L>(threshold))};                   \
+    for (; i + 4 * lanes <= n; i += 4 * lanes) {                               \
+      std::uint64_t bits{0};                                                   \
+      for (std::size_t k{0}; k < 4; ++k) {                                     \
+        bits |= std::uint64_t{Ops::mask_bits(                                  \
+                    Ops::greater(Ops::load(data + i + k * lanes), t))}         \
+                << (k * lanes);                                                \
+      }                                                                        \
+      if (bits) {                                                              \
+        return i + count_trailing_zeros(bits);                                 \
+      }                                                                        \
+    }                                                                          \
+    for (; i < n; ++i) {                                                       \
+      if (data[i] > threshold) {                                               \
+        return i;                                                              \
+      }                                                                        \
+    }                                                                          \
+    return n;                                                                  \
+  }
+
+LIBUTILS_DEFINE_FIND_GREATER_KERNEL(sse42, LIBUTILS_TARGET_SSE42)
+LIBUTILS_DEFINE_FIND_GREATER_KERNEL(avx2, LIBUTILS_TARGET_AVX2)
+LIBUTILS_DEFINE_FIND_GREATER_KERNEL(avx512, LIBUTILS_TARGET_AVX512)
+
+#undef LIBUTILS_DEFINE_FIND_GREATER_KERNEL
+#endif // LIBUTILS_X86_SIMD
+
+/**
+ * @brief Returns the index of the first element of [data + i, data + n)
+ * greater than threshold, or n. Unordered elements never match.
+ */
+template <typename T>
+std::size_t find_greater(const T *data, std::size_t i, const std::size_t n,
+                         const T threshold) noexcept {
+#if LIBUTILS_X86_SIMD
+  if constexpr (has_simd_lane_v<T>) {
+    using L = simd_lane_t<T>;
+    switch (active_simd_level()) {
+    case simd_level::avx512:
+      return find_greater_avx512<avx512_ops<L>>(data, i, n, threshold);
+    case simd_level::avx2:
+      return find_greater_avx2<avx2_ops<L>>(data, i, n, threshold);
+    case simd_level::sse42:
+      return find_greater_sse42<sse42_ops<L>>(data, i, n, threshold);
+    default:
+      break;
+    }
+  }
+#endif
+  for (; i < n; ++i) {
+    if (data[i] > threshold) {
+      return i;
+    }
+  }
+  return n;
+}
+
+/**
+ * @brief Dispatches argmax over [data + start, data + n) to the best kernel
+ * available at run time. data[start] must be ordered and n - start must fit
+ * the 32-bit index lanes.
+ */
+template <typename T>
+std::size_t argmax_block(const T *data, const std::size_t start,
+                         const std::size_t n) noexcept {
+#if LIBUTILS_X86_SIMD
+  if constexpr (has_simd_lane_v<T>) {
+    using L = simd_lane_t<T>;
+    switch (active_simd_level()) {
+    case simd_level::avx512:
+      return argmax_avx512<avx512_ops<L>>(data, start, n);
+    case simd_level::avx2:
+      return argmax_avx2<avx2_ops<L>>(data, start, n);
+    case simd_level::sse42:
+      return argmax_sse42<sse42_ops<L>>(data, start, n);
+    default:
+      break;
+    }
+  }
+#endif
+  return argmax_scalar(data, start, n);
+}
+
+/**
+ * @brief Returns the index of the first maximum among the ordered elements of
+ * [data, data + n), or n if every element is unordered.
+ *
+ * The range is processed in blocks small enough for 32-bit index lanes.
+ */
+template <typename T>
+std::size_t argmax_ordered(const T *data, const std::size_t n) noexcept {
+  constexpr std::size_t block{std::size_t{1} << 30};
+  auto best{n};
+  for (std::size_t base{0}; base < n; base += block) {
+    const auto size{std::min(block, n - base)};
+    const auto start{first_ordered(data + base, size)};
+    if (start == size) {
+      continue;
+    }
+    const auto local{base + argmax_block(data + base, start, size)};
+    if (best == n || data[local] > data[best]) {
+      best = local;
+    }
+  }
+  return best;
+}
+
+/**
+ * @brief Masked counterpart of argmax_block(); data[start] must be ordered and
+ * eligible.
+ */
+template <typename T>
+std::size_t argmax_masked_block(const T *data, const std::size_t start,
+                                const std::size_t n,
+                                const std::uint64_t *mask) noexcept {
+#if LIBUTILS_X86_SIMD
+  if constexpr (has_simd_lane_v<T>) {
+    using L = simd_lane_t<T>;
+    switch (active_simd_level()) {
+    case simd_level::avx512:
+      return argmax_masked_avx512<avx512_ops<L>>(data, start, n, mask);
+    case simd_level::avx2:
+      return argmax_masked_avx2<avx2_ops<L>>(data, start, n, mask);
+    case simd_level::sse42:
+      return argmax_masked_sse42<sse42_ops<L>>(data, start, n, mask);
+    default:
+      break;
+    }
+  }
+#endif
+  return argmax_masked_scalar(data, start, n, mask);
+}
+
+/**
+ * @brief Returns the index of the first set bit of mask in [first, n), or n.
+ */
+inline std::size_t next_mask_bit(const std::uint64_t *mask, std::size_t first,
+                                 const std::size_t n) noexcept {
+  while (first < n) {
+    const auto bits{mask[first / 64] >> (first % 64)};
+    if (bits) {
+      return std::min(n, first + count_trailing_zeros(bits));
+    }
+    first = (first / 64 + 1) * 64;
+  }
+  return n;
+}
+
+/**
+ * @brief Returns the index of the first maximum among the ordered elements of
+ * [data + first, data + n) whose bit is set in mask, or n if there is none.
+ */
+template <typename T>
+std::size_t argmax_masked_ordered(const T *data, const std::size_t n,
+                                  const std::uint64_t *mask,
+                                  const std::size_t first = 0) noexcept {
+  // Blocks are multiples of 64 so that each starts on a mask word.
+  constexpr std::size_t block{std::size_t{1} << 30};
+  auto best{n};
+  for (auto base{first / block * block}; base < n; base += block) {
+    const auto size{std::min(block, n - base)};
+    const auto block_mask{mask + base / 64};
+    auto start{next_mask_bit(block_mask, first > base ? first - base : 0, size)};
+    while (start < size && is_unordered(data[base + start])) {
+      start = next_mask_bit(block_mask, start + 1, size);
+    }
+    if (start == size) {
+      continue;
+    }
+    const auto local{base +
+                     argmax_masked_block(data + base, start, size, block_mask)};
+    if (best == n || data[local] > data[best]) {
+      best = local;
+    }
+  }
+  return best;
+}
+
+/**
+ * @brief Returns the index of the maximum among the elements of
+ * [data, data + n) whose bit is set in mask, or n if there is none.
+ *
+ * Follows max_element_conditional(): the first eligible element is the initial
+ * candidate, and only strictly greater eligible elements replace it. A NaN as
+ * first eligible element is therefore returned.
+ */
+template <typename T>
+std::size_t argmax_masked(const T *data, const std::size_t n,
+                          const std::uint64_t *mask) noexcept {
+  const auto first{next_mask_bit(mask, 0, n)};
+  if (first == n || is_unordered(data[first])) {
+    return first;
+  }
+  return argmax_masked_ordered(data, n, mask, first);
+}
+
+/**
+ * @brief Returns the index of the first maximum among the ordered elements of
+ * [first, first + n), or n if every element is unordered.
+ *
+ * Contiguous ranges go to argmax_ordered(), others are compared with
+ * operator< like std::max_element.
+ */
+template <typename It>
+std::size_t argmax_range(It first, const std::size_t n) {
+  using value_type = typename std::iterator_traits<It>::value_type;
+  if constexpr (is_contiguous_iterator_v<It> && has_simd_lane_v<value_type>) {
+    return n ? argmax_ordered(std::addressof(*first), n) : n;
+  } else {
+    auto best{n};
+    auto best_it{first};
+    for (std::size_t i{0}; i < n; ++i, ++first) {
+      if (is_unordered(*first)) {
+        continue;
+      }
+      if (best == n || *best_it < *first) {
+        best = i;
+        best_it = first;
+      }
+    }
+    return best;
+  }
+}
+} // namespace details
+} // namespace utils
+
+#endif // DETAILS_ARGMAX_KERNELS_HPP
@@ -0,0 +1,151 @@
+#ifndef DETAILS_COPY_KERNELS_HPP
+#define DETAILS_COPY_KERNELS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+#include "../type_traits.hpp"
+#include "cpu.hpp"
+
+namespace utils {
+namespace details {
+/**
+ * @brief True if copying from InputIt to OutputIt can be done with memcpy:
+ * both are contiguous over the same trivially copyable type.
+ */
+template <typename InputIt, typename OutputIt>
+inline constexpr bool is_memcpy_copyable_v =
+    is_contiguous_iterator_v<InputIt> && is_contiguous_iterator_v<OutputIt> &&
+    std::is_same_v<
+        std::remove_cv_t<typename std::iterator_traits<InputIt>::value_type>,
+        typename std::iterator_traits<OutputIt>::value_type> &&
+    std::is_trivially_copyable_v<
+        typename std::iterator_traits<OutputIt>::value_type>;
+
+#if LIBUTILS_X86_SIMD
+/*
+ * Defines stream_copy_<ISA>(dst, src, n), which copies n bytes with
+ * non-temporal stores once dst is aligned to the vector width. The caller
+ * issues the store fence.
+ */
+#define LIBUTILS_DEFINE_STREAM_COPY_KERNEL(ISA, TARGET, VEC, WIDTH, LOAD,      \
+                                           STREAM)                             \
+  TARGET inline void stream_copy_##ISA(char *dst, const char *src,             \
+                                       std::size_t n) noexcept {               \
+    const auto misalignment{reinterpret_cast<std::uintptr_t>(dst) % WIDTH};    \
+    if (misalignment) {                                                        \
+      const auto head{std::min(n, WIDTH - misalignment)};                      \
+      std::memcpy(dst, src, head);                                             \
+      dst += head;                                                             \
+      src += head;                                                             \
+      n -= head;                                                               \
+    }                                                                          \
+    for (; n >= 4 * WIDTH; n -= 4 * WIDTH, dst += 4 * WIDTH,                   \
+                           src += 4 * WIDTH) {                                 \
+      const auto v0{LOAD(reinterpret_cast<const VEC *>(src))};                 \
+      const auto v1{LOAD(reinterpret_cast<const VEC *>(src + WIDTH))};         \
+      const auto v2{LOAD(reinterpret_cast<const VEC *>(src + 2 * WIDTH))};     \
+      const auto v3{LOAD(reinterpret_cast<const VEC *>(src + 3 * WIDTH))};     \
+      STREAM(reinterpret_cast<VEC *>(dst), v0);                                \
+      STREAM(reinterpret_cast<VEC *>(dst + WIDTH), v1);                        \
+      STREAM(reinterpret_cast<VEC *>(dst + 2 * WIDTH), v2);                    \
+      STREAM(reinterpret_cast<VEC *>(dst + 3 * WIDTH), v3);                    \
+    }                                                                          \
+    for (; n >= WIDTH; n -= WIDTH, dst += WIDTH, src += WIDTH) {               \
+      STREAM(reinterpret_cast<VEC *>(dst),                                     \
+             LOAD(reinterpret_cast<const VEC *>(src)));                        \
+    }                                                                          \
+    std::memcpy(dst, src, n);                                                  \
+  }
+
+LIBUTILS_DEFINE_STREAM_COPY_KERNEL(sse42, LIBUTILS_TARGET_SSE42, __m128i,
+                                   std::size_t{16}, _mm_loadu_si128,
+                                   _mm_stream_si128)
+LIBUTILS_DEFINE_STREAM_COPY_KERNEL(avx2, LIBUTILS_TARGET_AVX2, __m256i,
+                                   std::size_t{32}, _mm256_loadu_si256,
+                                   _mm256_stream_si256)
+
+#undef LIBUTILS_DEFINE_STREAM_COPY_KERNEL
+#endif // LIBUTILS_X86_SIMD
+
+/**
+ * @brief Copies n bytes from src to dst, bypassing the cache for the stores
+ * when the CPU allows it.
+ */
+inline void stream_copy(char *dst, const char *src,
+                        const std::size_t n) noexcept {
+#if LIBUTILS_X86_SIMD
+  switch (active_simd_level()) {
+  case simd_level::avx512:
+  case simd_level::avx2:
+    return stream_copy_avx2(dst, src, n);
+  case simd_level::sse42:
+    return stream_copy_sse42(dst, src, n);
+  default:
+    break;
+  }
+#endif
+  std::memcpy(dst, src, n);
+}
+
+/**
+ * @brief Orders the non-temporal stores issued by stream_copy() before any
+ * later store.
+ */
+inline void stream_fence() noexcept {
+#if LIBUTILS_X86_SIMD
+  _mm_sfence();
+#endif
+}
+
+/**
+ * @brief Writes bytes [begin, end) of the infinite repetition of the size
+ * bytes at src into dst.
+ *
+ * After the partial leading copy, one whole copy of src is written and the
+ * written region is then doubled with memcpy until end. With stream set, the
+ * region is only grown to a cache-resident tile of at least 64 KiB, which is
+ * then replicated with non-temporal stores so the output does not evict it.
+ */
+inline void fill_repeated(char *dst, const char *src, const std::size_t size,
+                          std::size_t begin, const std::size_t end,
+                          const bool stream) noexcept {
+  const auto offset{begin % size};
+  if (offset) {
+    const auto count{std::min(size - offset, end - begin)};
+    std::memcpy(dst + begin, src + offset, count);
+    begin += count;
+  }
+  if (begin == end) {
+    return;
+  }
+
+  constexpr std::size_t min_tile{std::size_t{1} << 16};
+  const auto tile_end{
+      stream ? std::min(end, begin + (min_tile + size - 1) / size * size)
+             : end};
+  auto pos{begin + std::min(size, tile_end - begin)};
+  std::memcpy(dst + begin, src, pos - begin);
+  while (pos < tile_end) {
+    const auto count{std::min(pos - begin, tile_end - pos)};
+    std::memcpy(dst + pos, dst + begin, count);
+    pos += count;
+  }
+  if (pos == end) {
+    return;
+  }
+
+  const auto tile{tile_end - begin};
+  for (; pos < end; pos += tile) {
+    stream_copy(dst + pos, dst + begin, std::min(tile, end - pos));
+  }
+  stream_fence();
+}
+} // namespace details
+} // namespace utils
+
+#endif // DETAILS_COPY_KERNELS_HPP
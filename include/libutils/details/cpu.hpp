@@ -0,0 +1,156 @@
+#ifndef DETAILS_CPU_HPP
+#define DETAILS_CPU_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// SIMD kernels are compiled with per-function target attributes and selected
+// at run time, so the library does not require any -m flags from its users.
+// Define LIBUTILS_DISABLE_SIMD to compile the scalar paths only.
+#if (defined(__GNUC__) || defined(__clang__)) &&                              \
+    (defined(__x86_64__) || defined(__i386__)) &&                              \
+    !defined(LIBUTILS_DISABLE_SIMD)
+#define LIBUTILS_X86_SIMD 1
+#include <immintrin.h>
+#define LIBUTILS_TARGET_SSE42 __attribute__((target("sse4.2,popcnt")))
+#define LIBUTILS_TARGET_AVX2                                                   \
+  __attribute__((target("avx2,fma,f16c,bmi,bmi2,lzcnt,popcnt")))
+#define LIBUTILS_TARGET_AVX512                                                 \
+  __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl,avx2,fma,f16c,"  \
+                        "bmi,bmi2,lzcnt,popcnt")))
+#else
+#define LIBUTILS_X86_SIMD 0
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace utils {
+namespace details {
+/**
+ * @brief Instruction set levels for which the library ships kernels.
+ *
+ * Every level implies all the levels below it.
+ */
+enum class simd_level : int { scalar = 0, sse42 = 1, avx2 = 2, avx512 = 3 };
+
+/**
+ * @brief Queries the CPU for the highest supported simd_level.
+ *
+ * The avx2 level requires the Haswell feature set (AVX2, FMA, F16C, BMI1/2),
+ * the avx512 level requires the Skylake-SP feature set (F, BW, DQ, VL).
+ */
+inline simd_level detect_simd_level() noexcept {
+#if LIBUTILS_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+      __builtin_cpu_supports("avx512dq") &&
+      __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx2") &&
+      __builtin_cpu_supports("fma") && __builtin_cpu_supports("bmi2")) {
+    return simd_level::avx512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+      __builtin_cpu_supports("bmi") && __builtin_cpu_supports("bmi2")) {
+    return simd_level::avx2;
+  }
+  if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) {
+    return simd_level::sse42;
+  }
+#endif
+  return simd_level::scalar;
+}
+
+inline std::atomic<int> &simd_level_limit() noexcept {
+  static std::atomic<int> limit{static_cast<int>(simd_level::avx512)};
+  return limit;
+}
+
+/**
+ * @brief Caps the simd_level used by the kernels, e.g. to test every path.
+ *
+ * @param level The highest level that active_simd_level() may return.
+ */
+inline void limit_simd_level(simd_level level) noexcept {
+  simd_level_limit().store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the simd_level the kernels should dispatch to.
+ */
+inline simd_level active_simd_level() noexcept {
+  static const simd_level detected{detect_simd_level()};
+  return static_cast<simd_level>(
+      std::min(static_cast<int>(detected),
+               simd_level_limit().load(std::memory_order_relaxed)));
+}
+
+/**
+ * @brief Returns the size in bytes of the last level data cache.
+ *
+ * Falls back to 8 MiB when the platform does not report it.
+ */
+inline std::size_t detect_last_level_cache_size() noexcept {
+#if defined(_SC_LEVEL3_CACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE)
+  for (const auto name : {_SC_LEVEL3_CACHE_SIZE, _SC_LEVEL2_CACHE_SIZE}) {
+    const auto size{sysconf(name)};
+    if (size > 0) {
+      return static_cast<std::size_t>(size);
+    }
+  }
+#endif
+  return std::size_t{8} << 20;
+}
+
+/**
+ * @brief Returns the cached result of detect_last_level_cache_size().
+ */
+inline std::size_t last_level_cache_size() noexcept {
+  static const std::size_t size{detect_last_level_cache_size()};
+  return size;
+}
+
+/**
+ * @brief Output size in bytes from which copies bypass the cache with
+ * non-temporal stores, the last level cache size unless changed.
+ */
+inline std::atomic<std::size_t> &nontemporal_threshold() noexcept {
+  static std::atomic<std::size_t> threshold{last_level_cache_size()};
+  return threshold;
+}
+
+/**
+ * @brief Returns the number of trailing zero bits of x, which must not be 0.
+ */
+inline unsigned count_trailing_zeros(std::uint64_t x) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned>(__builtin_ctzll(x));
+#else
+  unsigned count{0};
+  for (; !(x & 1u); x >>= 1) {
+    ++count;
+  }
+  return count;
+#endif
+}
+
+/**
+ * @brief Returns the number of leading zero bits of x, which must not be 0.
+ */
+inline unsigned count_leading_zeros(std::uint64_t x) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned>(__builtin_clzll(x));
+#else
+  unsigned count{0};
+  for (; !(x & (std::uint64_t{1} << 63)); x <<= 1) {
+    ++count;
+  }
+  return count;
+#endif
+}
+} // namespace details
+} // namespace utils
+
+#endif // DETAILS_CPU_HPP
@@ -0,0 +1,183 @@
+#ifndef DETAILS_DIRECTORY_WALKER_HPP
+#define DETAILS_DIRECTORY_WALKER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "../execution.hpp"
+
+namespace utils {
+namespace details {
+/**
+ * @brief Pruning predicate of the recursive listings visiting every
+ * subdirectory.
+ */
+struct never_prune {
+  template <typename T> constexpr bool operator()(const T &) const noexcept {
+    return false;
+  }
+};
+
+/**
+ * @brief Directory waiting to be listed, with the depth of its entries.
+ */
+struct walk_task {
+  std::filesystem::path path;
+  std::size_t depth;
+};
+
+/**
+ * @brief Directories waiting to be listed by one thread of walk_directory().
+ *
+ * The owner pushes and pops at the back, so it goes depth first and keeps its
+ * working set small, while idle threads steal from the front, taking the
+ * shallowest directories, which tend to have the largest subtrees.
+ */
+class walk_queue {
+public:
+  void push(walk_task task) {
+    std::lock_guard lock{mutex_};
+    tasks_.push_back(std::move(task));
+  }
+
+  std::optional<walk_task> pop() {
+    std::lock_guard lock{mutex_};
+    if (tasks_.empty()) {
+      return std::nullopt;
+    }
+    auto task{std::move(tasks_.back())};
+    tasks_.pop_back();
+    return task;
+  }
+
+  std::optional<walk_task> steal() {
+    std::lock_guard lock{mutex_};
+    if (tasks_.empty()) {
+      return std::nullopt;
+    }
+    auto task{std::move(tasks_.front())};
+    tasks_.pop_front();
+    return task;
+  }
+
+private:
+  std::mutex mutex_;
+  std::deque<walk_task> tasks_;
+};
+
+/**
+ * @brief Number of entries a thread of walk_directory() collects before
+ * handing them to the sink.
+ */
+inline constexpr std::size_t walk_batch_size{1024};
+
+/**
+ * @brief Lists the directory at path and its subdirectories with the threads
+ * of the policy.
+ *
+ * Entries of path have depth 0. Subdirectories at a depth below max_depth,
+ * that are not symbolic links and for which prune returns false are listed in
+ * turn, with the given directory options. The entries for which p returns
+ * true are passed to sink, as a std::vector<std::filesystem::directory_entry>
+ * of at most walk_batch_size entries that it may move from, one batch at a
+ * time.
+ *
+ * Every thread owns a walk_queue; a thread with an empty queue steals from
+ * the others and, if none has a directory waiting, sleeps until a directory
+ * is queued or the walk ends. p and prune are called concurrently. If listing
+ * a directory throws, the walk stops and the first exception is rethrown.
+ */
+template <typename UnaryPred, typename PrunePred, typename Sink>
+void walk_directory(const execution::parallel_policy &policy,
+                    const std::filesystem::path &path,
+                    const std::size_t max_depth,
+                    const std::filesystem::directory_options options,
+                    UnaryPred &p, PrunePred &prune, Sink &sink) {
+  namespace fs = std::filesystem;
+  const auto threads{policy.threads()};
+  std::vector<walk_queue> queues(threads);
+  // Directories being listed or queued, and directories queued only.
+  std::atomic<std::size_t> pending{1};
+  std::atomic<std::size_t> queued{1};
+  std::atomic<bool> stop{false};
+  std::mutex sink_mutex;
+  std::mutex idle_mutex;
+  std::condition_variable idle;
+  // Taking the mutex between the update and the notification keeps a thread
+  // from missing it between checking its wait condition and sleeping.
+  const auto wake{[&](const bool all) {
+    { std::lock_guard lock{idle_mutex}; }
+    if (all) {
+      idle.notify_all();
+    } else {
+      idle.notify_one();
+    }
+  }};
+  queues[0].push(walk_task{path, 0});
+
+  parallel_for(policy, threads, [&](const std::size_t self) {
+    std::vector<fs::directory_entry> batch;
+    const auto flush{[&] {
+      if (!batch.empty()) {
+        std::lock_guard lock{sink_mutex};
+        sink(batch);
+        batch.clear();
+      }
+    }};
+    try {
+      while (!stop) {
+        auto task{queues[self].pop()};
+        for (std::size_t k{1}; !task && k < threads; ++k) {
+          task = queues[(self + k) % threads].steal();
+        }
+        if (!task) {
+          std::unique_lock lock{idle_mutex};
+          idle.wait(lock, [&] { return queued || !pending || stop; });
+          if (!pending) {
+            break;
+          }
+          continue;
+        }
+        --queued;
+        for (const auto &entry : fs::directory_iterator{task->path, options}) {
+          std::error_code ec;
+          if (task->depth < max_depth && entry.is_directory(ec) &&
+              !entry.is_symlink(ec) && !prune(entry)) {
+            ++pending;
+            ++queued;
+            queues[self].push(walk_task{entry.path(), task->depth + 1});
+            if (threads > 1) {
+              wake(false);
+            }
+          }
+          if (p(entry)) {
+            batch.push_back(entry);
+            if (batch.size() >= walk_batch_size) {
+              flush();
+            }
+          }
+        }
+        if (!--pending) {
+          wake(true);
+        }
+      }
+      flush();
+    } catch (...) {
+      stop = true;
+      wake(true);
+      throw;
+    }
+  });
+}
+} // namespace details
+} // namespace utils
+
+#endif // DETAILS_DIRECTORY_WALKER_HPP
@@ -0,0 +1,313 @@
+#ifndef DETAILS_DIRENT_READER_HPP
+#define DETAILS_DIRENT_READER_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace utils {
+namespace details {
+/**
+ * @brief Size of the blocks the directory entries are read into.
+ */
+inline constexpr std::size_t dirent_block_size{std::size_t{1} << 18};
+
+/**
+ * @brief Returns the error of the last system call as a filesystem_error.
+ */
+inline std::filesystem::filesystem_error dirent_error(const char *what, const std::string &path) {
+  return std::filesystem::filesystem_error(what, path, std::error_code(errno, std::system_category()));
+}
+
+#if defined(__linux__)
+/**
+ * @brief Closes a file descriptor on destruction.
+ */
+struct file_descriptor {
+  int fd;
+  explicit file_descriptor(const int fd) noexcept : fd{fd} {}
+  file_descriptor(const file_descriptor &) = delete;
+  file_descriptor &operator=(const file_descriptor &) = delete;
+  ~file_descriptor() {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+};
+
+/**
+ * @brief Converts a d_type value of readdir to a file type.
+ */
+inline std::filesystem::file_type dirent_type(const unsigned char type) noexcept {
+  using std::filesystem::file_type;
+  switch (type) {
+  case DT_REG:
+    return file_type::regular;
+  case DT_DIR:
+    return file_type::directory;
+  case DT_LNK:
+    return file_type::symlink;
+  case DT_BLK:
+    return file_type::block;
+  case DT_CHR:
+    return file_type::character;
+  case DT_FIFO:
+    return file_type::fifo;
+  case DT_SOCK:
+    return file_type::socket;
+  default:
+    return file_type::unknown;
+  }
+}
+
+/**
+ * @brief Converts the st_mode of lstat to a file type.
+ */
+inline std::filesystem::file_type stat_type(const mode_t mode) noexcept {
+  using std::filesystem::file_type;
+  switch (mode & S_IFMT) {
+  case S_IFREG:
+    return file_type::regular;
+  case S_IFDIR:
+    return file_type::directory;
+  case S_IFLNK:
+    return file_type::symlink;
+  case S_IFBLK:
+    return file_type::block;
+  case S_IFCHR:
+    return file_type::character;
+  case S_IFIFO:
+    return file_type::fifo;
+  case S_IFSOCK:
+    return file_type::socket;
+  default:
+    return file_type::unknown;
+  }
+}
+
+/**
+ * @brief Parses the struct linux_dirent64 at entry, read from the directory
+ * open as dir, and returns its length.
+ *
+ * The layout is u64 d_ino, s64 d_off, u16 d_reclen, u8 d_type, char d_name[].
+ * The type comes from d_type; only on file systems reporting DT_UNKNOWN is the
+ * entry looked up with fstatat relative to dir, without following symbolic
+ * links, type being file_type::unknown if that fails too.
+ */
+inline std::size_t parse_dirent(const int dir, const char *entry, std::string_view &name,
+                                std::filesystem::file_type &type, std::uint64_t &inode) noexcept {
+  std::uint16_t length;
+  std::memcpy(&inode, entry, sizeof(inode));
+  std::memcpy(&length, entry + 16, sizeof(length));
+  name = std::string_view{entry + 19};
+  type = dirent_type(static_cast<unsigned char>(entry[18]));
+  if (type == std::filesystem::file_type::unknown && name != "." && name != "..") {
+    struct stat info;
+    if (!::fstatat(dir, name.data(), &info, AT_SYMLINK_NOFOLLOW)) {
+      type = stat_type(info.st_mode);
+    }
+  }
+  return length;
+}
+
+/**
+ * @brief Reads the entries of the directory at path, except . and .., with
+ * getdents64 and calls keep(name, type, inode) for each of them.
+ *
+ * Types are found as by parse_dirent().
+ *
+ * The kernel writes the entries into blocks of dirent_block_size bytes. The
+ * blocks holding an entry for which keep returned true are appended to blocks,
+ * so that the name it was given stays valid: no name is copied and no memory
+ * is allocated per entry. Other blocks are reused for the next read.
+ */
+template <typename Keep>
+void read_dirents(const std::string &path, std::vector<std::unique_ptr<char[]>> &blocks, Keep &keep) {
+  const file_descriptor dir{::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)};
+  if (dir.fd < 0) {
+    throw dirent_error("cannot open directory", path);
+  }
+  std::unique_ptr<char[]> block;
+  for (;;) {
+    if (!block) {
+      block.reset(new char[dirent_block_size]);
+    }
+    const auto bytes{::syscall(SYS_getdents64, dir.fd, block.get(), dirent_block_size)};
+    if (bytes < 0) {
+      throw dirent_error("cannot read directory", path);
+    }
+    if (!bytes) {
+      return;
+    }
+    bool kept{false};
+    for (std::size_t offset{0}; offset < static_cast<std::size_t>(bytes);) {
+      std::string_view name;
+      std::filesystem::file_type type;
+      std::uint64_t inode;
+      offset += parse_dirent(dir.fd, block.get() + offset, name, type, inode);
+      if (name != "." && name != "..") {
+        kept |= keep(name, type, inode);
+      }
+    }
+    if (kept) {
+      blocks.push_back(std::move(block));
+    }
+  }
+}
+
+/**
+ * @brief Reads the entries of a directory one at a time, with getdents64 into
+ * a single block of dirent_block_size bytes that is reused: its memory does
+ * not grow with the directory.
+ */
+class dirent_stream {
+public:
+  explicit dirent_stream(const std::string &path)
+      : fd_{::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)}, path_{path} {
+    if (fd_ < 0) {
+      throw dirent_error("cannot open directory", path);
+    }
+  }
+
+  dirent_stream(dirent_stream &&other) noexcept
+      : fd_{std::exchange(other.fd_, -1)}, path_{std::move(other.path_)}, block_{std::move(other.block_)},
+        offset_{other.offset_}, bytes_{other.bytes_} {}
+
+  dirent_stream &operator=(dirent_stream &&other) noexcept {
+    if (this != &other) {
+      close();
+      fd_ = std::exchange(other.fd_, -1);
+      path_ = std::move(other.path_);
+      block_ = std::move(other.block_);
+      offset_ = other.offset_;
+      bytes_ = other.bytes_;
+    }
+    return *this;
+  }
+
+  ~dirent_stream() { close(); }
+
+  /**
+   * @brief Calls f(name, type, inode) for the next entry, except . and ..,
+   * typed as by parse_dirent(), and returns true, or returns false at the end
+   * of the directory. The name is valid until the next call.
+   */
+  template <typename F> bool next(F &f) {
+    for (;;) {
+      if (offset_ >= bytes_) {
+        if (fd_ < 0) {
+          return false;
+        }
+        if (!block_) {
+          block_.reset(new char[dirent_block_size]);
+        }
+        const auto bytes{::syscall(SYS_getdents64, fd_, block_.get(), dirent_block_size)};
+        if (bytes < 0) {
+          throw dirent_error("cannot read directory", path_);
+        }
+        if (!bytes) {
+          close();
+          return false;
+        }
+        offset_ = 0;
+        bytes_ = static_cast<std::size_t>(bytes);
+      }
+      std::string_view name;
+      std::filesystem::file_type type;
+      std::uint64_t inode;
+      offset_ += parse_dirent(fd_, block_.get() + offset_, name, type, inode);
+      if (name != "." && name != "..") {
+        f(name, type, inode);
+        return true;
+      }
+    }
+  }
+
+private:
+  void close() noexcept {
+    if (fd_ >= 0) {
+      ::close(std::exchange(fd_, -1));
+    }
+  }
+
+  int fd_;
+  std::string path_;
+  std::unique_ptr<char[]> block_;
+  std::size_t offset_{0};
+  std::size_t bytes_{0};
+};
+#else
+/**
+ * @brief Reads the entries of the directory at path with
+ * std::filesystem::directory_iterator and calls keep(name, type, 0) for each
+ * of them, the names being copied into blocks.
+ */
+template <typename Keep>
+void read_dirents(const std::string &path, std::vector<std::unique_ptr<char[]>> &blocks, Keep &keep) {
+  std::size_t used{dirent_block_size};
+  for (const auto &entry : std::filesystem::directory_iterator{path}) {
+    const auto name{entry.path().filename().string()};
+    if (used + name.size() > dirent_block_size) {
+      blocks.emplace_back(new char[std::max(dirent_block_size, name.size())]);
+      used = 0;
+    }
+    auto *copy{blocks.back().get() + used};
+    std::memcpy(copy, name.data(), name.size());
+    std::error_code ec;
+    if (keep(std::string_view(copy, name.size()), entry.symlink_status(ec).type(), std::uint64_t{0})) {
+      used += name.size();
+    }
+  }
+}
+
+/**
+ * @brief Reads the entries of a directory one at a time with
+ * std::filesystem::directory_iterator.
+ */
+class dirent_stream {
+public:
+  explicit dirent_stream(const std::string &path) : it_{path} {}
+
+  /**
+   * @brief Calls f(name, type, 0) for the next entry and returns true, or
+   * returns false at the end of the directory. The name is valid until the
+   * next call.
+   */
+  template <typename F> bool next(F &f) {
+    if (it_ == std::filesystem::directory_iterator{}) {
+      return false;
+    }
+    name_ = it_->path().filename().string();
+    std::error_code ec;
+    const auto type{it_->symlink_status(ec).type()};
+    ++it_;
+    f(std::string_view(name_), type, std::uint64_t{0});
+    return true;
+  }
+
+private:
+  std::filesystem::directory_iterator it_;
+  std::string name_;
+};
+#endif
+} // namespace details
+} // namespace utils
+
+#endif // DETAILS_DIRENT_READER_HPP
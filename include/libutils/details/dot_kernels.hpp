@@ -0,0 +1,266 @@
+#ifndef DETAILS_DOT_KERNELS_HPP
+#define DETAILS_DOT_KERNELS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "../type_traits.hpp"
+#include "cpu.hpp"
+#include "sum_kernels.hpp"
+#include "tree_reduce.hpp"
+
+namespace utils {
+namespace details {
+/**
+ * @brief True if [first1, last1) and the range at first2 can go through the
+ * dot product kernels: both contiguous and of the same float or double type.
+ */
+template <typename InputIt1, typename InputIt2>
+inline constexpr bool has_dot_kernel_v =
+    is_contiguous_iterator_v<InputIt1> && is_contiguous_iterator_v<InputIt2> &&
+    std::is_same_v<remove_cvref_t<decltype(*std::declval<InputIt1>())>,
+                   remove_cvref_t<decltype(*std::declval<InputIt2>())>> &&
+    (std::is_same_v<remove_cvref_t<decltype(*std::declval<InputIt1>())>, float> ||
+     std::is_same_v<remove_cvref_t<decltype(*std::declval<InputIt1>())>, double>);
+
+/**
+ * @brief Adds a[i] * b[i] for i in [i, n) to the accumulators, and b[i] to
+ * the weight accumulators if Weighted, element i going to lane i % sum_lanes,
+ * then returns both sums in a fixed tree order.
+ */
+template <bool Weighted, typename T>
+std::pair<double, double> dot_lanes_finish(const T *a, const T *b,
+                                           std::size_t i, const std::size_t n,
+                                           double *acc,
+                                           double *weights) noexcept {
+  for (; i < n; ++i) {
+    acc[i % sum_lanes] += static_cast<double>(a[i]) * static_cast<double>(b[i]);
+    if constexpr (Weighted) {
+      weights[i % sum_lanes] += static_cast<double>(b[i]);
+    }
+  }
+  for (auto width{sum_lanes / 2}; width; width /= 2) {
+    for (std::size_t lane{0}; lane < width; ++lane) {
+      acc[lane] += acc[lane + width];
+      if constexpr (Weighted) {
+        weights[lane] += weights[lane + width];
+      }
+    }
+  }
+  return std::make_pair(acc[0], Weighted ? weights[0] : 0.0);
+}
+
+template <bool Weighted, typename T>
+std::pair<double, double> dot_block_scalar(const T *a, const T *b,
+                                           const std::size_t n) noexcept {
+  double acc[sum_lanes]{};
+  double weights[sum_lanes]{};
+  return dot_lanes_finish<Weighted>(a, b, 0, n, acc, weights);
+}
+
+#if LIBUTILS_X86_SIMD
+/*
+ * Defines dot_block_<ISA><Weighted>(a, b, n) for float and double, with the
+ * same lane layout as the summation kernels. MUL_ADD(x, y, acc) returns
+ * x * y + acc, fused on AVX2 and AVX-512. Products of floats are exact in
+ * double, so float results do not depend on the instruction set.
+ */
+#define LIBUTILS_DEFINE_DOT_BLOCK_KERNEL(ISA, TARGET, VEC, LANES, ZERO, ADD,   \
+                                         MUL_ADD, STORE, LOAD_F, LOAD_D)       \
+  template <bool Weighted, typename T>                                         \
+  TARGET std::pair<double, double> dot_block_##ISA(                            \
+      const T *a, const T *b, const std::size_t n) noexcept {                  \
+    constexpr std::size_t regs{sum_lanes / LANES};                             \
+    VEC acc[regs];                                                             \
+    VEC weights[regs];                                                         \
+    for (std::size_t r{0}; r < regs; ++r) {                                    \
+      acc[r] = ZERO();                                                         \
+      weights[r] = ZERO();                                                     \
+    }                                                                          \
+    std::size_t i{0};                                                          \
+    for (; i + sum_lanes <= n; i += sum_lanes) {                               \
+      for (std::size_t r{0}; r < regs; ++r) {                                  \
+        VEC x;                                                                 \
+        VEC w;                                                                 \
+        if constexpr (std::is_same_v<T, float>) {                              \
+          x = LOAD_F(a + i + r * LANES);                                       \
+          w = LOAD_F(b + i + r * LANES);                                       \
+        } else {                                                               \
+          x = LOAD_D(a + i + r * LANES);                                       \
+          w = LOAD_D(b + i + r * LANES);                                       \
+        }                                                                      \
+        acc[r] = MUL_ADD(x, w, acc[r]);                                        \
+        if constexpr (Weighted) {                                              \
+          weights[r] = ADD(weights[r], w);                                     \
+        }                                                                      \
+      }                                                                        \
+    }                                                                          \
+    double acc_lanes[sum_lanes];                                               \
+    double weight_lanes[sum_lanes];                                            \
+    for (std::size_t r{0}; r < regs; ++r) {                                    \
+      STORE(acc_lanes + r * LANES, acc[r]);                                    \
+      STORE(weight_lanes + r * LANES, weights[r]);                             \
+    }                                                                          \
+    return dot_lanes_finish<Weighted>(a, b, i, n, acc_lanes, weight_lanes);    \
+  }
+
+#define LIBUTILS_SSE42_MUL_ADD(x, y, acc) _mm_add_pd(_mm_mul_pd(x, y), acc)
+#define LIBUTILS_AVX2_LOAD_F(p) _mm256_cvtps_pd(_mm_loadu_ps(p))
+#define LIBUTILS_AVX512_LOAD_F(p) _mm512_cvtps_pd(_mm256_loadu_ps(p))
+
+LIBUTILS_DEFINE_DOT_BLOCK_KERNEL(sse42, LIBUTILS_TARGET_SSE42, __m128d, 2,
+                                 _mm_setzero_pd, _mm_add_pd,
+                                 LIBUTILS_SSE42_MUL_ADD, _mm_storeu_pd,
+                                 load_float2_sse42, _mm_loadu_pd)
+LIBUTILS_DEFINE_DOT_BLOCK_KERNEL(avx2, LIBUTILS_TARGET_AVX2, __m256d, 4,
+                                 _mm256_setzero_pd, _mm256_add_pd,
+                                 _mm256_fmadd_pd, _mm256_storeu_pd,
+                                 LIBUTILS_AVX2_LOAD_F, _mm256_loadu_pd)
+LIBUTILS_DEFINE_DOT_BLOCK_KERNEL(avx512, LIBUTILS_TARGET_AVX512, __m512d, 8,
+                                 _mm512_setzero_pd, _mm512_add_pd,
+                                 _mm512_fmadd_pd, _mm512_storeu_pd,
+                                 LIBUTILS_AVX512_LOAD_F, _mm512_loadu_pd)
+
+#undef LIBUTILS_SSE42_MUL_ADD
+#undef LIBUTILS_AVX2_LOAD_F
+#undef LIBUTILS_AVX512_LOAD_F
+#undef LIBUTILS_DEFINE_DOT_BLOCK_KERNEL
+#endif // LIBUTILS_X86_SIMD
+
+/**
+ * @brief Computes the dot product of at most reduce_leaf_size elements, and
+ * the sum of the elements of b if Weighted, on the best kernel.
+ */
+template <bool Weighted, typename T>
+std::pair<double, double> dot_block(const T *a, const T *b,
+                                    const std::size_t n) noexcept {
+#if LIBUTILS_X86_SIMD
+  switch (active_simd_level()) {
+  case simd_level::avx512:
+    return dot_block_avx512<Weighted>(a, b, n);
+  case simd_level::avx2:
+    return dot_block_avx2<Weighted>(a, b, n);
+  case simd_level::sse42:
+    return dot_block_sse42<Weighted>(a, b, n);
+  default:
+    break;
+  }
+#endif
+  return dot_block_scalar<Weighted>(a, b, n);
+}
+
+/**
+ * @brief Computes the dot product of the n elements at a and b in double, and
+ * the sum of the elements of b if Weighted, pairwise over leaves of
+ * reduce_leaf_size elements.
+ */
+template <bool Weighted, typename T>
+std::pair<double, double> pairwise_dot(const T *a, const T *b,
+                                       const std::size_t n) noexcept {
+  if (!n) {
+    return std::make_pair(0.0, 0.0);
+  }
+  auto leaf{[a, b, n](const std::size_t leaf_index) {
+    const auto begin{leaf_index * reduce_leaf_size};
+    return dot_block<Weighted>(a + begin, b + begin,
+                               std::min(reduce_leaf_size, n - begin));
+  }};
+  auto plus{[](const std::pair<double, double> &x,
+               const std::pair<double, double> &y) {
+    return std::make_pair(x.first + y.first, x.second + y.second);
+  }};
+  return tree_reduce(0, reduce_leaf_count(n), leaf, plus);
+}
+
+/**
+ * @brief Returns the sum of the products of [first1, last1) and the range at
+ * first2, and the sum of the second range if Weighted.
+ *
+ * Arithmetic elements are accumulated in sum_accumulator_t of their common
+ * type, through pairwise_dot() when has_dot_kernel_v holds; other elements in
+ * T starting from T(0).
+ */
+template <bool Weighted, typename T, typename InputIt1, typename InputIt2>
+auto weighted_sums(InputIt1 first1, const InputIt1 last1, InputIt2 first2) {
+  using value_type = std::common_type_t<remove_cvref_t<decltype(*first1)>,
+                                        remove_cvref_t<decltype(*first2)>>;
+  if constexpr (has_dot_kernel_v<InputIt1, InputIt2>) {
+    const auto n{static_cast<std::size_t>(std::distance(first1, last1))};
+    return n ? pairwise_dot<Weighted>(std::addressof(*first1),
+                                      std::addressof(*first2), n)
+             : std::make_pair(0.0, 0.0);
+  } else if constexpr (std::is_arithmetic_v<value_type>) {
+    using accumulator = sum_accumulator_t<value_type>;
+    accumulator products(0);
+    accumulator weights(0);
+    for (; first1 != last1; ++first1, ++first2) {
+      products += static_cast<accumulator>(*first1) *
+                  static_cast<accumulator>(*first2);
+      if constexpr (Weighted) {
+        weights += static_cast<accumulator>(*first2);
+      }
+    }
+    return std::make_pair(products, weights);
+  } else {
+    T products(0);
+    T weights(0);
+    for (; first1 != last1; ++first1, ++first2) {
+      products += *first1 * *first2;
+      if constexpr (Weighted) {
+        weights += *first2;
+      }
+    }
+    return std::make_pair(products, weights);
+  }
+}
+
+/**
+ * @brief Returns init plus the sum of the products of [first1, last1) and the
+ * range at first2, see weighted_sums().
+ */
+template <typename T, typename InputIt1, typename InputIt2>
+T sum_of_products(InputIt1 first1, const InputIt1 last1, InputIt2 first2,
+                  const T init) {
+  const auto sum{weighted_sums<false, T>(first1, last1, first2).first};
+  if constexpr (std::is_arithmetic_v<T> &&
+                std::is_arithmetic_v<remove_cvref_t<decltype(sum)>>) {
+    using wide = std::common_type_t<T, remove_cvref_t<decltype(sum)>>;
+    return static_cast<T>(static_cast<wide>(init) + static_cast<wide>(sum));
+  } else {
+    return init + sum;
+  }
+}
+
+/**
+ * @brief Returns the mean of [first1, last1) weighted by the range at first2
+ * as a T, 0 if the weights sum to 0. Arithmetic results are divided as in
+ * mean_from_sum().
+ */
+template <typename T, typename InputIt1, typename InputIt2>
+T weighted_mean(InputIt1 first1, const InputIt1 last1, InputIt2 first2) {
+  const auto [products, weights] =
+      weighted_sums<true, T>(first1, last1, first2);
+  if (weights == decltype(weights)(0)) {
+    return T(0);
+  }
+  using S = remove_cvref_t<decltype(products)>;
+  if constexpr (std::is_arithmetic_v<T> && std::is_arithmetic_v<S>) {
+    if constexpr (std::is_floating_point_v<T>) {
+      using wide = std::common_type_t<T, S, double>;
+      return static_cast<T>(static_cast<wide>(products) /
+                            static_cast<wide>(weights));
+    } else {
+      return static_cast<T>(products / weights);
+    }
+  } else {
+    return products / weights;
+  }
+}
+} // namespace details
+} // namespace utils
+
+#endif // DETAILS_DOT_KERNELS_HPP
@@ -0,0 +1,222 @@
+#ifndef DETAILS_EXACT_MEAN_KERNELS_HPP
+#define DETAILS_EXACT_MEAN_KERNELS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <type_traits>
+
+#include "../type_traits.hpp"
+#include "cpu.hpp"
+
+namespace utils {
+namespace details {
+/**
+ * @brief Two's complement 128-bit integer stored as two 64-bit words, in which
+ * up to 2^64 integers of at most 64 bits are summed without overflow.
+ */
+struct wide_sum {
+  std::uint64_t hi;
+  std::uint64_t lo;
+};
+
+/**
+ * @brief Adds x, sign extended if Signed, to sum.
+ */
+template <bool Signed>
+void wide_add(wide_sum &sum, const std::uint64_t x) noexcept {
+  sum.lo += x;
+  sum.hi += static_cast<std::uint64_t>(sum.lo < x);
+  if constexpr (Signed) {
+    sum.hi -= x >> 63;
+  }
+}
+
+/**
+ * @brief Returns a + b.
+ */
+inline wide_sum wide_add(wide_sum a, const wide_sum b) noexcept {
+  a.lo += b.lo;
+  a.hi += b.hi + static_cast<std::uint64_t>(a.lo < b.lo);
+  return a;
+}
+
+template <bool Signed>
+wide_sum wide_sum_scalar(const std::uint64_t *data, const std::size_t n,
+                         wide_sum sum) noexcept {
+  for (std::size_t i{0}; i < n; ++i) {
+    wide_add<Signed>(sum, data[i]);
+  }
+  return sum;
+}
+
+#if LIBUTILS_X86_SIMD
+/*
+ * Keeps the low words of four sums in one register and their high words in
+ * another. AVX2 has no unsigned 64-bit comparison, so the carries are found
+ * by comparing the low words with their sign bits flipped.
+ */
+template <bool Signed>
+LIBUTILS_TARGET_AVX2 wide_sum wide_sum_avx2(const std::uint64_t *data,
+                                            const std::size_t n) noexcept {
+  const auto sign{_mm256_set1_epi64x(std::numeric_limits<std::int64_t>::min())};
+  auto lo{_mm256_setzero_si256()};
+  auto hi{_mm256_setzero_si256()};
+  std::size_t i{0};
+  for (; i + 4 <= n; i += 4) {
+    const auto x{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i))};
+    lo = _mm256_add_epi64(lo, x);
+    hi = _mm256_sub_epi64(hi, _mm256_cmpgt_epi64(_mm256_xor_si256(x, sign),
+                                                 _mm256_xor_si256(lo, sign)));
+    if constexpr (Signed) {
+      hi = _mm256_add_epi64(hi, _mm256_cmpgt_epi64(_mm256_setzero_si256(), x));
+    }
+  }
+  std::uint64_t lo_lanes[4];
+  std::uint64_t hi_lanes[4];
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(lo_lanes), lo);
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(hi_lanes), hi);
+  wide_sum sum{0, 0};
+  for (std::size_t lane{0}; lane < 4; ++lane) {
+    sum = wide_add(sum, wide_sum{hi_lanes[lane], lo_lanes[lane]});
+  }
+  return wide_sum_scalar<Signed>(data + i, n - i, sum);
+}
+#endif // LIBUTILS_X86_SIMD
+
+/**
+ * @brief Sums the n 64-bit integers at data, signed if Signed, on the best
+ * kernel.
+ */
+template <bool Signed>
+wide_sum wide_sum_block(const std::uint64_t *data, const std::size_t n) noexcept {
+#if LIBUTILS_X86_SIMD
+  if (active_simd_level() >= simd_level::avx2) {
+    return wide_sum_avx2<Signed>(data, n);
+  }
+#endif
+  return wide_sum_scalar<Signed>(data, n, wide_sum{0, 0});
+}
+
+/**
+ * @brief Returns the exact sum of the integers in [first, last).
+ *
+ * Contiguous ranges of 64-bit integers go through wide_sum_block(), other
+ * elements are converted to 64 bits one at a time.
+ */
+template <typename InputIt>
+wide_sum exact_sum(InputIt first, const InputIt last) {
+  using value_type = remove_cvref_t<decltype(*first)>;
+  static_assert(std::is_integral_v<value_type>, "exact sums need integral elements");
+  constexpr bool is_signed{std::is_signed_v<value_type>};
+  if constexpr (is_contiguous_iterator_v<InputIt> && sizeof(value_type) == sizeof(std::uint64_t)) {
+    const auto n{static_cast<std::size_t>(std::distance(first, last))};
+    return n ? wide_sum_block<is_signed>(
+                   reinterpret_cast<const std::uint64_t *>(std::addressof(*first)), n)
+             : wide_sum{0, 0};
+  } else {
+    using wide = std::conditional_t<is_signed, std::int64_t, std::uint64_t>;
+    wide_sum sum{0, 0};
+    for (; first != last; ++first) {
+      wide_add<is_signed>(sum, static_cast<std::uint64_t>(static_cast<wide>(*first)));
+    }
+    return sum;
+  }
+}
+
+/**
+ * @brief Returns the number of bits needed to represent x.
+ */
+inline int bit_width(std::uint64_t x) noexcept {
+  int width{0};
+  for (; x; x >>= 1) {
+    ++width;
+  }
+  return width;
+}
+
+/**
+ * @brief Divides hi * 2^64 + lo by d, which must be greater than hi so that
+ * the quotient fits in 64 bits, and stores the remainder in remainder.
+ */
+inline std::uint64_t divide_wide(const std::uint64_t hi, const std::uint64_t lo,
+                                 const std::uint64_t d, std::uint64_t &remainder) noexcept {
+#if defined(__SIZEOF_INT128__)
+  __extension__ using uint128 = unsigned __int128;
+  const auto n{(static_cast<uint128>(hi) << 64) | lo};
+  remainder = static_cast<std::uint64_t>(n % d);
+  return static_cast<std::uint64_t>(n / d);
+#else
+  std::uint64_t quotient{0};
+  auto r{hi};
+  for (int bit{63}; bit >= 0; --bit) {
+    const bool carry{(r >> 63) != 0};
+    r = (r << 1) | ((lo >> bit) & 1);
+    quotient <<= 1;
+    if (carry || r >= d) {
+      r -= d;
+      quotient |= 1;
+    }
+  }
+  remainder = r;
+  return quotient;
+#endif
+}
+
+/**
+ * @brief Returns sum / n as an R, n > 0.
+ *
+ * Integral results are rounded to nearest, ties to even. Floating point
+ * results are correctly rounded for float and double: the quotient is computed
+ * with 63 or 64 significant bits and a sticky bit standing for the remainder,
+ * so that its single conversion to R rounds as the exact value would.
+ */
+template <typename R>
+R exact_mean(const wide_sum sum, const std::uint64_t n) noexcept {
+  static_assert(std::is_arithmetic_v<R>, "exact means are arithmetic");
+  const bool negative{(sum.hi >> 63) != 0};
+  auto magnitude{sum};
+  if (negative) {
+    magnitude.lo = ~sum.lo + 1;
+    magnitude.hi = ~sum.hi + static_cast<std::uint64_t>(magnitude.lo == 0);
+  }
+  std::uint64_t remainder;
+  if constexpr (std::is_floating_point_v<R>) {
+    if (!magnitude.hi && !magnitude.lo) {
+      return R(0);
+    }
+    const auto width{magnitude.hi ? 64 + bit_width(magnitude.hi) : bit_width(magnitude.lo)};
+    const auto shift{std::max(0, 63 - (width - bit_width(n)))};
+    if (shift >= 64) {
+      magnitude.hi = magnitude.lo << (shift - 64);
+      magnitude.lo = 0;
+    } else if (shift) {
+      magnitude.hi = (magnitude.hi << shift) | (magnitude.lo >> (64 - shift));
+      magnitude.lo <<= shift;
+    }
+    auto quotient{divide_wide(magnitude.hi, magnitude.lo, n, remainder)};
+    R result;
+    if constexpr (std::numeric_limits<R>::digits <= 61) {
+      quotient |= static_cast<std::uint64_t>(remainder != 0);
+      result = std::ldexp(static_cast<R>(quotient), -shift);
+    } else {
+      result = std::ldexp(static_cast<R>(quotient) + static_cast<R>(remainder) / static_cast<R>(n),
+                          -shift);
+    }
+    return negative ? -result : result;
+  } else {
+    auto quotient{divide_wide(magnitude.hi, magnitude.lo, n, remainder)};
+    if (remainder > n - remainder || (remainder == n - remainder && (quotient & 1))) {
+      ++quotient;
+    }
+    return static_cast<R>(negative ? 0 - quotient : quotient);
+  }
+}
+} // namespace details
+} // namespace utils
+
+#endif // DETAILS_EXACT_MEAN_KERNELS_HPP
@@ -0,0 +1,130 @@
+#ifndef DETAILS_INOTIFY_HPP
+#define DETAILS_INOTIFY_HPP
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace utils {
+namespace details {
+/**
+ * @brief Events watched on the directories of a directory_cache: entries
+ * created, deleted or moved, and the directory itself deleted or moved.
+ */
+inline constexpr std::uint32_t directory_watch_mask{IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                                    IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR |
+                                                    IN_EXCL_UNLINK};
+
+/**
+ * @brief Owns an inotify instance and an eventfd used to wake up the thread
+ * waiting for its events.
+ */
+class inotify_handle {
+public:
+  inotify_handle()
+      : fd_{::inotify_init1(IN_NONBLOCK | IN_CLOEXEC)}, wake_{::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)} {
+    if (fd_ < 0 || wake_ < 0) {
+      const auto error{errno};
+      close();
+      throw std::system_error(error, std::system_category(), "cannot create inotify instance");
+    }
+  }
+
+  inotify_handle(const inotify_handle &) = delete;
+  inotify_handle &operator=(const inotify_handle &) = delete;
+
+  ~inotify_handle() { close(); }
+
+  /**
+   * @brief Watches the directory at path and returns the watch descriptor.
+   *
+   * @throws std::filesystem::filesystem_error if the directory cannot be
+   * watched.
+   */
+  int add_watch(const std::string &path) {
+    const auto wd{::inotify_add_watch(fd_, path.c_str(), directory_watch_mask)};
+    if (wd < 0) {
+      throw std::filesystem::filesystem_error("cannot watch directory", path,
+                                              std::error_code(errno, std::system_category()));
+    }
+    return wd;
+  }
+
+  void remove_watch(const int wd) noexcept { ::inotify_rm_watch(fd_, wd); }
+
+  /**
+   * @brief Makes the current or next call to wait() return false.
+   */
+  void wake() noexcept {
+    const std::uint64_t one{1};
+    [[maybe_unused]] const auto written{::write(wake_, &one, sizeof(one))};
+  }
+
+  /**
+   * @brief Blocks until events are available, returning true, or until wake()
+   * is called, returning false.
+   */
+  bool wait() noexcept {
+    for (;;) {
+      pollfd fds[2]{{fd_, POLLIN, 0}, {wake_, POLLIN, 0}};
+      if (::poll(fds, 2, -1) < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return false;
+      }
+      return !fds[1].revents;
+    }
+  }
+
+  /**
+   * @brief Reads the pending events without blocking and calls f(wd, mask,
+   * name) for each of them, name being empty for events on the watched
+   * directory itself.
+   */
+  template <typename F> void read_events(F &&f) {
+    alignas(inotify_event) char buffer[1 << 16];
+    for (;;) {
+      const auto bytes{::read(fd_, buffer, sizeof(buffer))};
+      if (bytes <= 0) {
+        return;
+      }
+      for (std::size_t offset{0}; offset < static_cast<std::size_t>(bytes);) {
+        inotify_event event;
+        std::memcpy(&event, buffer + offset, sizeof(event));
+        const std::string_view name{event.len ? buffer + offset + sizeof(event) : ""};
+        f(event.wd, event.mask, name);
+        offset += sizeof(event) + event.len;
+      }
+    }
+  }
+
+private:
+  void close() noexcept {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+    if (wake_ >= 0) {
+      ::close(wake_);
+    }
+  }
+
+  int fd_;
+  int wake_;
+};
+} // namespace details
+} // namespace utils
+#endif // __linux__
+
+#endif // DETAILS_INOTIFY_HPP
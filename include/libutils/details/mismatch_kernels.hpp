@@ -0,0 +1,128 @@
+#ifndef DETAILS_MISMATCH_KERNELS_HPP
+#define DETAILS_MISMATCH_KERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+#include "../type_traits.hpp"
+#include "cpu.hpp"
+
+namespace utils {
+namespace details {
+/**
+ * @brief True if ranges of It1 and It2 can be compared as raw bytes: both are
+ * contiguous over the same scalar type whose equality is bitwise equality,
+ * which excludes floating point types.
+ */
+template <typename It1, typename It2>
+inline constexpr bool is_bytewise_comparable_v =
+    is_contiguous_iterator_v<It1> && is_contiguous_iterator_v<It2> &&
+    std::is_same_v<
+        std::remove_cv_t<typename std::iterator_traits<It1>::value_type>,
+        std::remove_cv_t<typename std::iterator_traits<It2>::value_type>> &&
+    std::is_scalar_v<typename std::iterator_traits<It1>::value_type> &&
+    std::has_unique_object_representations_v<
+        std::remove_cv_t<typename std::iterator_traits<It1>::value_type>>;
+
+/**
+ * @brief Returns the length of the common suffix of the n bytes ending at
+ * a_end and b_end, comparing 8 bytes at a time.
+ */
+inline std::size_t common_suffix_scalar(const char *a_end, const char *b_end,
+                                        const std::size_t n) noexcept {
+  std::size_t suffix{0};
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  for (; suffix + 8 <= n; suffix += 8) {
+    std::uint64_t a;
+    std::uint64_t b;
+    std::memcpy(&a, a_end - suffix - 8, 8);
+    std::memcpy(&b, b_end - suffix - 8, 8);
+    if (const auto diff{a ^ b}) {
+      return suffix + count_leading_zeros(diff) / 8;
+    }
+  }
+#endif
+  for (; suffix < n && a_end[-1 - static_cast<std::ptrdiff_t>(suffix)] ==
+                           b_end[-1 - static_cast<std::ptrdiff_t>(suffix)];
+       ++suffix) {
+  }
+  return suffix;
+}
+
+#if LIBUTILS_X86_SIMD
+/*
+ * Defines common_suffix_<ISA>(a_end, b_end, n), which compares WIDTH bytes per
+ * step backwards. EQUAL_BITS(pa, pb) returns the byte equality mask of the
+ * WIDTH bytes at pa and pb as a std::uint64_t, so the last unequal byte of a
+ * step is found with a single lzcnt.
+ */
+#define LIBUTILS_DEFINE_COMMON_SUFFIX_KERNEL(ISA, TARGET, WIDTH, EQUAL_BITS)   \
+  TARGET inline std::size_t common_suffix_##ISA(                               \
+      const char *a_end, const char *b_end, const std::size_t n) noexcept {    \
+    constexpr std::uint64_t all{WIDTH == 64 ? ~std::uint64_t{0}                \
+                                            : (std::uint64_t{1} << WIDTH) - 1}; \
+    std::size_t suffix{0};                                                     \
+    for (; suffix + WIDTH <= n; suffix += WIDTH) {                             \
+      const auto unequal{                                                      \
+          ~EQUAL_BITS(a_end - suffix - WIDTH, b_end - suffix - WIDTH) & all};  \
+      if (unequal) {                                                           \
+        return suffix + count_leading_zeros(unequal) - (64 - WIDTH);           \
+      }                                                                        \
+    }                                                                          \
+    return suffix + common_suffix_scalar(a_end - suffix, b_end - suffix,       \
+                                         n - suffix);                          \
+  }
+
+#define LIBUTILS_EQUAL_BITS_SSE42(pa, pb)                                      \
+  static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(          \
+      _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pa)),   \
+                     _mm_loadu_si128(reinterpret_cast<const __m128i *>(pb))))))
+#define LIBUTILS_EQUAL_BITS_AVX2(pa, pb)                                       \
+  static_cast<std::uint64_t>(static_cast<unsigned>(_mm256_movemask_epi8(       \
+      _mm256_cmpeq_epi8(                                                       \
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pa)),           \
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pb))))))
+#define LIBUTILS_EQUAL_BITS_AVX512(pa, pb)                                     \
+  static_cast<std::uint64_t>(_mm512_cmpeq_epi8_mask(_mm512_loadu_si512(pa),    \
+                                                    _mm512_loadu_si512(pb)))
+
+LIBUTILS_DEFINE_COMMON_SUFFIX_KERNEL(sse42, LIBUTILS_TARGET_SSE42, 16,
+                                     LIBUTILS_EQUAL_BITS_SSE42)
+LIBUTILS_DEFINE_COMMON_SUFFIX_KERNEL(avx2, LIBUTILS_TARGET_AVX2, 32,
+                                     LIBUTILS_EQUAL_BITS_AVX2)
+LIBUTILS_DEFINE_COMMON_SUFFIX_KERNEL(avx512, LIBUTILS_TARGET_AVX512, 64,
+                                     LIBUTILS_EQUAL_BITS_AVX512)
+
+#undef LIBUTILS_EQUAL_BITS_SSE42
+#undef LIBUTILS_EQUAL_BITS_AVX2
+#undef LIBUTILS_EQUAL_BITS_AVX512
+#undef LIBUTILS_DEFINE_COMMON_SUFFIX_KERNEL
+#endif // LIBUTILS_X86_SIMD
+
+/**
+ * @brief Returns the length of the common suffix of the n bytes ending at
+ * a_end and b_end.
+ */
+inline std::size_t common_suffix(const char *a_end, const char *b_end,
+                                 const std::size_t n) noexcept {
+#if LIBUTILS_X86_SIMD
+  switch (active_simd_level()) {
+  case simd_level::avx512:
+    return common_suffix_avx512(a_end, b_end, n);
+  case simd_level::avx2:
+    return common_suffix_avx2(a_end, b_end, n);
+  case simd_level::sse42:
+    return common_suffix_sse42(a_end, b_end, n);
+  default:
+    break;
+  }
+#endif
+  return common_suffix_scalar(a_end, b_end, n);
+}
+} // namespace details
+} // namespace utils
+
+#endif // DETAILS_MISMATCH_KERNELS_HPP
@@ -0,0 +1,251 @@
+#ifndef DETAILS_PERMUTE_HPP
+#define DETAILS_PERMUTE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../execution.hpp"
+
+namespace utils {
+/**
+ * @brief Strategies of the permutation engine behind
+ * reorder_elements_by_indices().
+ */
+enum class reorder_strategy {
+  automatic, ///< Chosen from the range size and the element type.
+  cycles,    ///< In place, following the cycles of the permutation.
+  gather,    ///< Out of place through a scratch buffer, then moved back.
+  blocked    ///< Gather partitioned by source block, for out-of-cache data.
+};
+
+namespace details {
+/**
+ * @brief Moves the cycle of the permutation through leader so that
+ * first[j] becomes the old first[indices[j]] for every j of the cycle.
+ */
+template <typename RandomIt1, typename RandomIt2>
+void rotate_cycle(RandomIt1 first, RandomIt2 indices,
+                  const std::size_t leader) {
+  auto value{std::move(first[leader])};
+  auto current{leader};
+  for (auto next{static_cast<std::size_t>(indices[current])}; next != leader;
+       current = next, next = static_cast<std::size_t>(indices[current])) {
+    first[current] = std::move(first[next]);
+  }
+  first[current] = std::move(value);
+}
+
+/**
+ * @brief Returns the smallest index of every cycle of length at least 2,
+ * using a bit-vector to mark visited positions.
+ */
+template <typename RandomIt2>
+std::vector<std::size_t> cycle_leaders(RandomIt2 indices, const std::size_t n) {
+  std::vector<std::uint64_t> visited((n + 63) / 64);
+  std::vector<std::size_t> leaders;
+  for (std::size_t i{0}; i < n; ++i) {
+    if (visited[i / 64] >> (i % 64) & 1u) {
+      continue;
+    }
+    auto current{static_cast<std::size_t>(indices[i])};
+    if (current == i) {
+      continue;
+    }
+    leaders.push_back(i);
+    for (; current != i; current = static_cast<std::size_t>(indices[current])) {
+      visited[current / 64] |= std::uint64_t{1} << (current % 64);
+    }
+  }
+  return leaders;
+}
+
+/**
+ * @brief In-place gather following the cycles of the permutation, one move
+ * per element. Visited positions are marked in a side bit-vector so the
+ * indices are left untouched.
+ */
+template <typename RandomIt1, typename RandomIt2>
+void reorder_cycles(RandomIt1 first, const std::size_t n, RandomIt2 indices) {
+  std::vector<std::uint64_t> visited((n + 63) / 64);
+  for (std::size_t i{0}; i < n; ++i) {
+    if (visited[i / 64] >> (i % 64) & 1u) {
+      continue;
+    }
+    auto current{i};
+    auto next{static_cast<std::size_t>(indices[i])};
+    if (next == i) {
+      continue;
+    }
+    auto value{std::move(first[i])};
+    for (; next != i;
+         current = next, next = static_cast<std::size_t>(indices[current])) {
+      first[current] = std::move(first[next]);
+      visited[next / 64] |= std::uint64_t{1} << (next % 64);
+    }
+    first[current] = std::move(value);
+  }
+}
+
+/**
+ * @brief Cycle gather processing independent cycles on several threads. The
+ * leaders are found first by a sequential pass that only reads the indices.
+ */
+template <typename RandomIt1, typename RandomIt2>
+void reorder_cycles(const execution::parallel_policy &policy, RandomIt1 first,
+                    const std::size_t n, RandomIt2 indices) {
+  const auto leaders{cycle_leaders(indices, n)};
+  const auto chunk{chunk_size(policy, leaders.size(), 1)};
+  parallel_for(policy, (leaders.size() + chunk - 1) / chunk,
+               [&](const std::size_t task) {
+                 const auto end{std::min(leaders.size(), (task + 1) * chunk)};
+                 for (auto i{task * chunk}; i < end; ++i) {
+                   rotate_cycle(first, indices, leaders[i]);
+                 }
+               });
+}
+
+/**
+ * @brief Out-of-place gather into a scratch buffer, then moved back.
+ */
+template <typename RandomIt1, typename RandomIt2>
+void reorder_gather(RandomIt1 first, const std::size_t n, RandomIt2 indices) {
+  using value_type = typename std::iterator_traits<RandomIt1>::value_type;
+  std::vector<value_type> scratch;
+  scratch.reserve(n);
+  for (std::size_t j{0}; j < n; ++j) {
+    scratch.push_back(std::move(first[static_cast<std::size_t>(indices[j])]));
+  }
+  std::move(scratch.begin(), scratch.end(), first);
+}
+
+template <typename RandomIt1, typename RandomIt2>
+void reorder_gather(const execution::parallel_policy &policy, RandomIt1 first,
+                    const std::size_t n, RandomIt2 indices) {
+  using value_type = typename std::iterator_traits<RandomIt1>::value_type;
+  std::vector<value_type> scratch(n);
+  const auto chunk{chunk_size(policy, n, std::size_t{1} << 14)};
+  const auto tasks{(n + chunk - 1) / chunk};
+  parallel_for(policy, tasks, [&](const std::size_t task) {
+    const auto end{std::min(n, (task + 1) * chunk)};
+    for (auto j{task * chunk}; j < end; ++j) {
+      scratch[j] = std::move(first[static_cast<std::size_t>(indices[j])]);
+    }
+  });
+  parallel_for(policy, tasks, [&](const std::size_t task) {
+    const auto begin{task * chunk};
+    const auto end{std::min(n, begin + chunk)};
+    std::move(scratch.begin() + static_cast<std::ptrdiff_t>(begin),
+              scratch.begin() + static_cast<std::ptrdiff_t>(end),
+              std::next(first, static_cast<std::ptrdiff_t>(begin)));
+  });
+}
+
+/**
+ * @brief Radix-partitioned gather for data much larger than the caches.
+ *
+ * The range is cut into at most 256 blocks of at least 256 KiB. Destination
+ * positions are first grouped by source block with a counting sort. Reading
+ * one source block at a time, the values are then staged with their
+ * destination positions, grouped by destination block, and finally written
+ * one destination block at a time. Every random access thus stays within a
+ * cache-resident block, at the cost of sequential passes over the staging
+ * buffers. Blocks have disjoint outputs in both phases, so the policy
+ * overload processes them concurrently.
+ */
+template <typename Policy, typename RandomIt1, typename RandomIt2>
+void reorder_blocked(const Policy &policy, RandomIt1 first,
+                     const std::size_t n, RandomIt2 indices) {
+  using value_type = typename std::iterator_traits<RandomIt1>::value_type;
+  constexpr std::size_t max_blocks{256};
+  const auto block{std::max(
+      std::max<std::size_t>(1, (std::size_t{256} << 10) / sizeof(value_type)),
+      (n + max_blocks - 1) / max_blocks)};
+  const auto blocks{(n + block - 1) / block};
+  const auto for_each_block{[&](auto &&f) {
+    if constexpr (std::is_same_v<Policy, execution::parallel_policy>) {
+      parallel_for(policy, blocks, f);
+    } else {
+      for (std::size_t b{0}; b < blocks; ++b) {
+        f(b);
+      }
+    }
+  }};
+
+  const auto run{[&](auto index_tag) {
+    using Index = decltype(index_tag);
+    // counts[s * blocks + d]: positions of destination block d reading from
+    // source block s.
+    std::vector<std::size_t> counts(blocks * blocks);
+    for (std::size_t j{0}; j < n; ++j) {
+      ++counts[static_cast<std::size_t>(indices[j]) / block * blocks + j / block];
+    }
+    std::vector<std::size_t> by_source(blocks * blocks);
+    std::vector<std::size_t> by_destination(blocks * blocks);
+    std::vector<std::size_t> source_begin(blocks + 1);
+    std::vector<std::size_t> destination_begin(blocks + 1);
+    for (std::size_t offset{0}, cell{0}; cell < blocks * blocks; ++cell) {
+      by_source[cell] = offset;
+      offset += counts[cell];
+      source_begin[cell / blocks + 1] = offset;
+    }
+    for (std::size_t offset{0}, d{0}; d < blocks; ++d) {
+      for (std::size_t s{0}; s < blocks; ++s) {
+        by_destination[s * blocks + d] = offset;
+        offset += counts[s * blocks + d];
+      }
+      destination_begin[d + 1] = offset;
+    }
+
+    std::vector<Index> order(n);
+    for (std::size_t j{0}; j < n; ++j) {
+      const auto s{static_cast<std::size_t>(indices[j]) / block};
+      order[by_source[s * blocks + j / block]++] = static_cast<Index>(j);
+    }
+    std::vector<std::pair<Index, value_type>> staged(n);
+    for_each_block([&](const std::size_t s) {
+      for (auto k{source_begin[s]}; k < source_begin[s + 1]; ++k) {
+        const auto j{static_cast<std::size_t>(order[k])};
+        auto &entry{staged[by_destination[s * blocks + j / block]++]};
+        entry.first = static_cast<Index>(j);
+        entry.second = std::move(first[static_cast<std::size_t>(indices[j])]);
+      }
+    });
+    for_each_block([&](const std::size_t d) {
+      for (auto k{destination_begin[d]}; k < destination_begin[d + 1]; ++k) {
+        first[static_cast<std::size_t>(staged[k].first)] =
+            std::move(staged[k].second);
+      }
+    });
+  }};
+  if (n <= std::size_t{0xFFFFFFFF}) {
+    run(std::uint32_t{});
+  } else {
+    run(std::size_t{});
+  }
+}
+
+/**
+ * @brief Picks a concrete strategy for permuting n elements of type T.
+ *
+ * Following cycles is a chain of dependent loads, while the gather issues
+ * independent ones and is several times faster from a few thousand elements
+ * on, including out of cache. Cycles are kept for tiny ranges, where the
+ * scratch buffer is not worth allocating, and for large elements, which the
+ * gather would move twice.
+ */
+template <typename T>
+reorder_strategy choose_reorder_strategy(const std::size_t n) noexcept {
+  if (n <= 64 || sizeof(T) >= 128) {
+    return reorder_strategy::cycles;
+  }
+  return reorder_strategy::gather;
+}
+} // namespace details
+} // namespace utils
+
+#endif // DETAILS_PERMUTE_HPP
@@ -0,0 +1,167 @@
+#ifndef DETAILS_PRODUCT_KERNELS_HPP
+#define DETAILS_PRODUCT_KERNELS_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+namespace utils {
+namespace details {
+/**
+ * @brief Stores a * b in result and returns true if it overflowed T.
+ */
+template <typename T>
+bool mul_overflow(const T a, const T b, T *result) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_mul_overflow(a, b, result);
+#else
+  using unsigned_type = std::make_unsigned_t<T>;
+  *result = static_cast<T>(static_cast<unsigned_type>(a) *
+                           static_cast<unsigned_type>(b));
+  if (!a || !b) {
+    return false;
+  }
+  if constexpr (std::is_signed_v<T>) {
+    if ((a == -1 && b == std::numeric_limits<T>::min()) ||
+        (b == -1 && a == std::numeric_limits<T>::min())) {
+      return true;
+    }
+  }
+  return *result / b != a;
+#endif
+}
+
+/**
+ * @brief Number of elements multiplied between two overflow checks of the
+ * checked product.
+ */
+inline constexpr std::size_t checked_product_batch{64};
+
+/**
+ * @brief Multiplies init by the elements of [first, last) converted to T.
+ *
+ * Overflow flags are or-ed over batches of checked_product_batch elements so
+ * that the loop has no data dependent branch, and the product stops at the
+ * end of the first batch that overflowed or reached zero.
+ *
+ * @return A pair of a boolean that is false on overflow, and the product, 0
+ * on overflow.
+ */
+template <typename T, typename InputIt>
+std::pair<bool, T> checked_product(InputIt first, const InputIt last,
+                                   T init) {
+  while (first != last) {
+    bool overflow{false};
+    for (std::size_t i{0}; i < checked_product_batch && first != last;
+         ++i, ++first) {
+      overflow |= mul_overflow(init, static_cast<T>(*first), &init);
+    }
+    if (overflow) {
+      return std::make_pair(false, T(0));
+    }
+    if (!init) {
+      break;
+    }
+  }
+  return std::make_pair(true, init);
+}
+
+/**
+ * @brief Splits value into a mantissa in [0.5, 1) in magnitude and a power of
+ * two, like std::frexp. Zero, infinite and NaN values get an exponent of 0.
+ *
+ * Normal doubles are split with bit operations, the other values and other
+ * types go through std::frexp.
+ */
+template <typename S>
+S split_exponent(const S value, std::int64_t &exponent) noexcept {
+  if constexpr (std::is_same_v<S, double> &&
+                std::numeric_limits<double>::is_iec559) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const auto biased{static_cast<std::int64_t>((bits >> 52) & 0x7ff)};
+    if (biased != 0 && biased != 0x7ff) {
+      exponent = biased - 1022;
+      bits = (bits & ~(std::uint64_t{0x7ff} << 52)) | (std::uint64_t{1022} << 52);
+      S mantissa;
+      std::memcpy(&mantissa, &bits, sizeof(bits));
+      return mantissa;
+    }
+  }
+  if (!std::isfinite(value)) {
+    exponent = 0;
+    return value;
+  }
+  int e{0};
+  const auto mantissa{std::frexp(value, &e)};
+  exponent = e;
+  return mantissa;
+}
+
+/**
+ * @brief Number of logical accumulators of the scaled product.
+ */
+inline constexpr std::size_t product_lanes{8};
+
+/**
+ * @brief Multiplies init by the elements of [first, last) converted to S,
+ * keeping the product as a mantissa and a separate power of two so that it
+ * can neither overflow nor underflow.
+ *
+ * Element i is split by split_exponent() and its mantissa goes to lane
+ * i % product_lanes; lanes are renormalized after every 16 elements each, so
+ * their mantissas stay above 2^-17.
+ *
+ * @return A pair of the mantissa, in [0.5, 1) in magnitude unless it is zero,
+ * infinite or NaN, and the exponent.
+ */
+template <typename S, typename InputIt>
+std::pair<S, std::int64_t> scaled_product(InputIt first, const InputIt last,
+                                          const S init) {
+  constexpr std::size_t renormalize_every{16 * product_lanes};
+  S mantissas[product_lanes];
+  std::int64_t exponents[product_lanes]{};
+  for (auto &mantissa : mantissas) {
+    mantissa = S(1);
+  }
+  mantissas[0] = split_exponent(init, exponents[0]);
+  const auto renormalize{[&] {
+    for (std::size_t lane{0}; lane < product_lanes; ++lane) {
+      std::int64_t e;
+      mantissas[lane] = split_exponent(mantissas[lane], e);
+      exponents[lane] += e;
+    }
+  }};
+  std::size_t i{0};
+  for (; first != last; ++first) {
+    std::int64_t e;
+    const auto lane{i % product_lanes};
+    mantissas[lane] *= split_exponent(static_cast<S>(*first), e);
+    exponents[lane] += e;
+    if (++i == renormalize_every) {
+      renormalize();
+      i = 0;
+    }
+  }
+  renormalize();
+
+  auto mantissa{mantissas[0]};
+  auto exponent{exponents[0]};
+  for (std::size_t lane{1}; lane < product_lanes; ++lane) {
+    std::int64_t e;
+    mantissa = split_exponent(mantissa * mantissas[lane], e);
+    exponent += exponents[lane] + e;
+  }
+  if (mantissa == S(0) || !std::isfinite(mantissa)) {
+    exponent = 0;
+  }
+  return std::make_pair(mantissa, exponent);
+}
+} // namespace details
+} // namespace utils
+
+#endif // DETAILS_PRODUCT_KERNELS_HPP
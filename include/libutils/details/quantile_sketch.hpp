@@ -0,0 +1,91 @@
+#ifndef DETAILS_QUANTILE_SKETCH_HPP
+#define DETAILS_QUANTILE_SKETCH_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace utils {
+namespace details {
+/**
+ * @brief Default accuracy parameter of the quantile sketch.
+ */
+inline constexpr std::size_t kll_default_k{200};
+
+/**
+ * @brief Smallest capacity of a compactor of the quantile sketch.
+ */
+inline constexpr std::size_t kll_min_capacity{8};
+
+/**
+ * @brief Returns the capacity of compactor level of a KLL sketch with the
+ * given number of levels: k for the top level, shrinking by 2/3 per level
+ * below it, but never below kll_min_capacity.
+ */
+inline std::size_t kll_capacity(const std::size_t k, const std::size_t levels,
+                                 const std::size_t level) noexcept {
+  const auto depth{static_cast<double>(levels - 1 - level)};
+  const auto capacity{static_cast<std::size_t>(
+      std::ceil(static_cast<double>(k) * std::pow(2.0 / 3.0, depth)))};
+  return std::max(kll_min_capacity, capacity);
+}
+
+/**
+ * @brief Returns the sum of kll_capacity() over all levels.
+ */
+inline std::size_t kll_total_capacity(const std::size_t k,
+                                      const std::size_t levels) noexcept {
+  std::size_t total{0};
+  for (std::size_t level{0}; level < levels; ++level) {
+    total += kll_capacity(k, levels, level);
+  }
+  return total;
+}
+
+/**
+ * @brief Sorts from and moves every other element, starting at offset 0 or 1,
+ * to the end of to. If from has an odd size, its largest element stays in it
+ * and every other element is removed from it.
+ *
+ * @return The number of elements removed from the sketch, half of those
+ * compacted.
+ */
+template <typename T>
+std::size_t kll_compact(std::vector<T> &from, std::vector<T> &to,
+                        const std::size_t offset) {
+  std::sort(from.begin(), from.end());
+  const auto even{from.size() & ~std::size_t{1}};
+  for (auto i{offset}; i < even; i += 2) {
+    to.push_back(from[i]);
+  }
+  from.erase(from.begin(), from.begin() + static_cast<std::ptrdiff_t>(even));
+  return even / 2;
+}
+
+/**
+ * @brief Returns the next bit of a xorshift64 generator, used to choose the
+ * compaction offsets so that sketches are reproducible.
+ */
+inline std::size_t kll_coin(std::uint64_t &state) noexcept {
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return static_cast<std::size_t>(state >> 63);
+}
+
+/**
+ * @brief Returns a small index that is distinct for each of the first threads
+ * asking for it, used to spread threads over shards.
+ */
+inline std::size_t thread_shard_index() noexcept {
+  static std::atomic<std::size_t> next{0};
+  thread_local const std::size_t index{next.fetch_add(1, std::memory_order_relaxed)};
+  return index;
+}
+} // namespace details
+} // namespace utils
+
+#endif // DETAILS_QUANTILE_SKETCH_HPP
@@ -0,0 +1,122 @@
+#ifndef DETAILS_RADIX_SORT_HPP
+#define DETAILS_RADIX_SORT_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace utils {
+namespace details {
+/**
+ * @brief True for the key types radix_argsort() handles: integral types other
+ * than bool, and IEEE 754 float and double.
+ */
+template <typename T>
+inline constexpr bool has_radix_key_v =
+    (std::is_integral_v<T> && !std::is_same_v<T, bool>) ||
+    (std::is_floating_point_v<T> && std::numeric_limits<T>::is_iec559 &&
+     (sizeof(T) == 4 || sizeof(T) == 8));
+
+template <typename T, typename = void> struct radix_key {};
+
+template <typename T>
+struct radix_key<T, std::enable_if_t<std::is_integral_v<T>>> {
+  using type = std::make_unsigned_t<T>;
+};
+
+template <typename T>
+struct radix_key<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+  using type = std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+};
+
+/**
+ * @brief Unsigned type whose order matches the order of T, see to_radix_key().
+ */
+template <typename T> using radix_key_t = typename radix_key<T>::type;
+
+/**
+ * @brief Maps a key to an unsigned integer of the same width preserving order.
+ *
+ * Signed integers get their sign bit flipped. Floating point values get their
+ * sign bit set when positive and all their bits flipped when negative, which
+ * yields the IEEE 754 total order: -NaN < -inf < ... < -0.0 < +0.0 < ... <
+ * +inf < +NaN.
+ */
+template <typename T> radix_key_t<T> to_radix_key(const T value) noexcept {
+  using key_type = radix_key_t<T>;
+  constexpr key_type sign_bit{key_type{1}
+                              << (std::numeric_limits<key_type>::digits - 1)};
+  if constexpr (std::is_floating_point_v<T>) {
+    key_type bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits & sign_bit ? static_cast<key_type>(~bits) : bits | sign_bit;
+  } else if constexpr (std::is_signed_v<T>) {
+    return static_cast<key_type>(static_cast<key_type>(value) ^ sign_bit);
+  } else {
+    return value;
+  }
+}
+
+/**
+ * @brief Stable LSD radix sort of (key, index) pairs over 8-bit digits,
+ * writing the sorted indices to d_first.
+ *
+ * All digit histograms are computed in the pass building the pairs, and
+ * digits shared by every key are skipped. Ranges of fewer than 256 elements
+ * use std::stable_sort on the same pairs.
+ */
+template <typename Index, typename RandomIt, typename OutputIt>
+OutputIt radix_argsort(RandomIt first, const std::size_t n, OutputIt d_first) {
+  using key_type =
+      radix_key_t<typename std::iterator_traits<RandomIt>::value_type>;
+  struct entry {
+    key_type key;
+    Index index;
+  };
+  constexpr std::size_t passes{sizeof(key_type)};
+
+  std::vector<entry> entries(n);
+  std::array<std::array<std::size_t, 256>, passes> histograms{};
+  for (std::size_t i{0}; i < n; ++i) {
+    const auto key{to_radix_key(first[i])};
+    entries[i] = {key, static_cast<Index>(i)};
+    for (std::size_t pass{0}; pass < passes; ++pass) {
+      ++histograms[pass][(key >> (8 * pass)) & 0xFF];
+    }
+  }
+
+  if (n < 256) {
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const entry &a, const entry &b) { return a.key < b.key; });
+  } else {
+    std::vector<entry> buffer(n);
+    for (std::size_t pass{0}; pass < passes; ++pass) {
+      auto &histogram{histograms[pass]};
+      const auto shift{8 * pass};
+      if (histogram[(entries.front().key >> shift) & 0xFF] == n) {
+        continue;
+      }
+      std::size_t offset{0};
+      for (auto &count : histogram) {
+        offset += std::exchange(count, offset);
+      }
+      for (const auto &e : entries) {
+        buffer[histogram[(e.key >> shift) & 0xFF]++] = e;
+      }
+      entries.swap(buffer);
+    }
+  }
+  return std::transform(entries.begin(), entries.end(), d_first,
+                        [](const entry &e) { return e.index; });
+}
+} // namespace details
+} // namespace utils
+
+#endif // DETAILS_RADIX_SORT_HPP
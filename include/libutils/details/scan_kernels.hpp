@@ -0,0 +1,245 @@
+#ifndef DETAILS_SCAN_KERNELS_HPP
+#define DETAILS_SCAN_KERNELS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "../execution.hpp"
+#include "../type_traits.hpp"
+#include "cpu.hpp"
+#include "sum_kernels.hpp"
+
+namespace utils {
+namespace details {
+/**
+ * @brief True for the pairs of input and output element types scanned by the
+ * kernels: float and double into themselves with a double running sum, 32 and
+ * 64-bit signed integers into 64-bit ones with a 64-bit running sum.
+ */
+template <typename In, typename Out>
+inline constexpr bool has_scan_kernel_v =
+    (std::is_same_v<In, float> && std::is_same_v<Out, float>) ||
+    (std::is_same_v<In, double> && std::is_same_v<Out, double>) ||
+    ((std::is_same_v<In, std::int32_t> || std::is_same_v<In, std::int64_t>) &&
+     std::is_same_v<Out, std::int64_t>);
+
+/**
+ * @brief Number of elements scanned together by the floating point kernels.
+ *
+ * Within a group of four the prefix sums are formed as by an in-register
+ * scan, y = x + (x shifted by one), z = y + (y shifted by two), then added to
+ * the running sum. The scalar path follows the same order, so floating point
+ * scans are bit-identical whatever the instruction set.
+ */
+inline constexpr std::size_t scan_group{4};
+
+/**
+ * @brief Scans the n elements at in into out starting from carry and returns
+ * the running sum after them. out may be equal to in.
+ */
+template <bool Exclusive, typename In, typename Out, typename S>
+S scan_scalar(const In *in, Out *out, const std::size_t n, S carry) noexcept {
+  std::size_t i{0};
+  if constexpr (std::is_floating_point_v<S>) {
+    for (; i + scan_group <= n; i += scan_group) {
+      const S x[scan_group]{static_cast<S>(in[i]), static_cast<S>(in[i + 1]),
+                            static_cast<S>(in[i + 2]),
+                            static_cast<S>(in[i + 3])};
+      const S y[scan_group]{x[0] + S(0), x[1] + x[0], x[2] + x[1], x[3] + x[2]};
+      const S z[scan_group]{y[0] + S(0), y[1] + S(0), y[2] + y[0], y[3] + y[1]};
+      S inclusive[scan_group];
+      for (std::size_t k{0}; k < scan_group; ++k) {
+        inclusive[k] = carry + z[k];
+      }
+      for (std::size_t k{0}; k < scan_group; ++k) {
+        out[i + k] = static_cast<Out>(
+            Exclusive ? (k ? inclusive[k - 1] : carry) : inclusive[k]);
+      }
+      carry = inclusive[scan_group - 1];
+    }
+  }
+  for (; i < n; ++i) {
+    const auto x{static_cast<S>(in[i])};
+    if constexpr (Exclusive) {
+      out[i] = static_cast<Out>(carry);
+    }
+    carry += x;
+    if constexpr (!Exclusive) {
+      out[i] = static_cast<Out>(carry);
+    }
+  }
+  return carry;
+}
+
+#if LIBUTILS_X86_SIMD
+template <bool Exclusive, typename In, typename Out>
+LIBUTILS_TARGET_AVX2 double scan_avx2(const In *in, Out *out,
+                                      const std::size_t n,
+                                      const double init) noexcept {
+  const auto zero{_mm256_setzero_pd()};
+  auto carry{_mm256_set1_pd(init)};
+  std::size_t i{0};
+  for (; i + scan_group <= n; i += scan_group) {
+    __m256d x;
+    if constexpr (std::is_same_v<In, float>) {
+      x = _mm256_cvtps_pd(_mm_loadu_ps(in + i));
+    } else {
+      x = _mm256_loadu_pd(in + i);
+    }
+    const auto y{_mm256_add_pd(
+        x, _mm256_blend_pd(_mm256_permute4x64_pd(x, _MM_SHUFFLE(2, 1, 0, 0)),
+                           zero, 0b0001))};
+    const auto z{_mm256_add_pd(y, _mm256_permute2f128_pd(y, y, 0x08))};
+    const auto inclusive{_mm256_add_pd(carry, z)};
+    auto result{inclusive};
+    if constexpr (Exclusive) {
+      result = _mm256_blend_pd(
+          _mm256_permute4x64_pd(inclusive, _MM_SHUFFLE(2, 1, 0, 0)), carry,
+          0b0001);
+    }
+    if constexpr (std::is_same_v<Out, float>) {
+      _mm_storeu_ps(out + i, _mm256_cvtpd_ps(result));
+    } else {
+      _mm256_storeu_pd(out + i, result);
+    }
+    carry = _mm256_permute4x64_pd(inclusive, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+  return scan_scalar<Exclusive>(in + i, out + i, n - i,
+                                _mm256_cvtsd_f64(carry));
+}
+
+template <bool Exclusive, typename In>
+LIBUTILS_TARGET_AVX2 std::int64_t scan_avx2(const In *in, std::int64_t *out,
+                                            const std::size_t n,
+                                            const std::int64_t init) noexcept {
+  auto carry{_mm256_set1_epi64x(init)};
+  std::size_t i{0};
+  for (; i + scan_group <= n; i += scan_group) {
+    __m256i x;
+    if constexpr (std::is_same_v<In, std::int32_t>) {
+      x = _mm256_cvtepi32_epi64(
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i)));
+    } else {
+      x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+    }
+    const auto y{_mm256_add_epi64(
+        x, _mm256_blend_epi32(
+               _mm256_permute4x64_epi64(x, _MM_SHUFFLE(2, 1, 0, 0)),
+               _mm256_setzero_si256(), 0b00000011))};
+    const auto z{_mm256_add_epi64(y, _mm256_permute2x128_si256(y, y, 0x08))};
+    const auto inclusive{_mm256_add_epi64(carry, z)};
+    auto result{inclusive};
+    if constexpr (Exclusive) {
+      result = _mm256_blend_epi32(
+          _mm256_permute4x64_epi64(inclusive, _MM_SHUFFLE(2, 1, 0, 0)), carry,
+          0b00000011);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), result);
+    carry = _mm256_permute4x64_epi64(inclusive, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+  return scan_scalar<Exclusive>(
+      in + i, out + i, n - i,
+      static_cast<std::int64_t>(_mm256_extract_epi64(carry, 0)));
+}
+#endif // LIBUTILS_X86_SIMD
+
+/**
+ * @brief Scans the n elements at in into out starting from carry on the best
+ * kernel and returns the running sum after them.
+ */
+template <bool Exclusive, typename In, typename Out, typename S>
+S scan_block(const In *in, Out *out, const std::size_t n, const S carry) noexcept {
+#if LIBUTILS_X86_SIMD
+  if (active_simd_level() >= simd_level::avx2) {
+    return scan_avx2<Exclusive>(in, out, n, carry);
+  }
+#endif
+  return scan_scalar<Exclusive>(in, out, n, carry);
+}
+
+/**
+ * @brief Scans [first, last) into d_first with a running sum of type S
+ * starting from carry and returns the iterator past the last element written.
+ *
+ * Contiguous ranges accepted by has_scan_kernel_v go through scan_block(),
+ * others are scanned one element at a time.
+ */
+template <bool Exclusive, typename S, typename InputIt, typename OutputIt>
+OutputIt scan(InputIt first, const InputIt last, OutputIt d_first, S carry) {
+  using in_type = remove_cvref_t<decltype(*first)>;
+  using out_type = typename std::iterator_traits<OutputIt>::value_type;
+  if constexpr (is_contiguous_iterator_v<InputIt> &&
+                is_contiguous_iterator_v<OutputIt> &&
+                has_scan_kernel_v<in_type, out_type> &&
+                std::is_same_v<S, sum_accumulator_t<in_type>>) {
+    const auto n{static_cast<std::size_t>(std::distance(first, last))};
+    if (n) {
+      scan_block<Exclusive>(std::addressof(*first), std::addressof(*d_first),
+                            n, carry);
+    }
+    return std::next(d_first, static_cast<std::ptrdiff_t>(n));
+  } else {
+    for (; first != last; ++first, ++d_first) {
+      const S x(*first);
+      if constexpr (Exclusive) {
+        *d_first = carry;
+      }
+      carry = carry + x;
+      if constexpr (!Exclusive) {
+        *d_first = carry;
+      }
+    }
+    return d_first;
+  }
+}
+
+/**
+ * @brief Default number of elements per chunk of the parallel scan. It does
+ * not depend on the number of threads, so neither do the results.
+ */
+inline constexpr std::size_t scan_chunk_size{std::size_t{1} << 16};
+
+/**
+ * @brief Scans [first, last) into d_first with the threads of the policy.
+ *
+ * The range is cut into chunks of the policy's grain size, or
+ * scan_chunk_size. The first pass sums every chunk in parallel, the running
+ * sums at the chunk boundaries are then accumulated in order, and the second
+ * pass scans every chunk in parallel from its boundary sum.
+ */
+template <bool Exclusive, typename S, typename RandomIt1, typename RandomIt2>
+RandomIt2 scan(const execution::parallel_policy &policy, RandomIt1 first,
+               const RandomIt1 last, RandomIt2 d_first, const S init) {
+  const auto n{static_cast<std::size_t>(std::distance(first, last))};
+  const auto chunk{policy.grain_size() ? policy.grain_size() : scan_chunk_size};
+  const auto chunks{(n + chunk - 1) / chunk};
+  if (chunks <= 1) {
+    return scan<Exclusive>(first, last, d_first, init);
+  }
+  std::vector<S> carries(chunks, init);
+  parallel_for(policy, chunks - 1, [&](const std::size_t task) {
+    const auto begin{std::next(first, static_cast<std::ptrdiff_t>(task * chunk))};
+    carries[task + 1] = static_cast<S>(widened_sum(begin, std::next(begin, chunk)));
+  });
+  for (std::size_t c{1}; c < chunks; ++c) {
+    carries[c] = carries[c - 1] + carries[c];
+  }
+  parallel_for(policy, chunks, [&](const std::size_t task) {
+    const auto begin{task * chunk};
+    const auto end{std::min(n, begin + chunk)};
+    scan<Exclusive>(std::next(first, static_cast<std::ptrdiff_t>(begin)),
+                    std::next(first, static_cast<std::ptrdiff_t>(end)),
+                    std::next(d_first, static_cast<std::ptrdiff_t>(begin)),
+                    carries[task]);
+  });
+  return std::next(d_first, static_cast<std::ptrdiff_t>(n));
+}
+} // namespace details
+} // namespace utils
+
+#endif // DETAILS_SCAN_KERNELS_HPP
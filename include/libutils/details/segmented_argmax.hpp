@@ -0,0 +1,183 @@
+#ifndef DETAILS_SEGMENTED_ARGMAX_HPP
+#define DETAILS_SEGMENTED_ARGMAX_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+#include "argmax_kernels.hpp"
+
+namespace utils {
+namespace details {
+/**
+ * @brief Segments up to this length are batched into SIMD lanes, longer ones
+ * are searched one at a time with argmax_ordered().
+ */
+inline constexpr std::size_t short_segment_max{64};
+
+/**
+ * @brief Argmax of a single segment with the rules of argmax(): 0 for an
+ * empty segment or a leading NaN, otherwise the first maximum among the
+ * ordered elements.
+ */
+template <typename T>
+std::size_t argmax_segment(const T *data, const std::size_t n) noexcept {
+  if (n > short_segment_max) {
+    return is_unordered(data[0]) ? 0 : argmax_ordered(data, n);
+  }
+  std::size_t best{0};
+  for (std::size_t i{1}; i < n; ++i) {
+    if (data[best] < data[i]) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+#if LIBUTILS_X86_SIMD
+/*
+ * Defines argmax_lanes_<ISA>(base, starts, lengths, results), which searches
+ * Ops::width segments at once, lane l walking the lengths[l] elements at
+ * base + starts[l] with masked gathers. Lengths must be in
+ * [1, short_segment_max]. A lane past the end of its segment gathers nothing
+ * and keeps its best value, which is then never strictly exceeded.
+ */
+#define LIBUTILS_DEFINE_ARGMAX_LANES_KERNEL(ISA, TARGET)                       \
+  template <typename Ops, typename T>                                          \
+  TARGET void argmax_lanes_##ISA(const T *base,                                \
+                                 const typename Ops::index_type *starts,       \
+                                 const std::size_t *lengths,                   \
+                                 std::size_t *results) noexcept {              \
+    using I = typename Ops::index_type;                                        \
+    constexpr std::size_t lanes{Ops::width};                                   \
+    unsigned stop_at[short_segment_max + 1]{};                                 \
+    std::size_t max_length{0};                                                 \
+    for (std::size_t l{0}; l < lanes; ++l) {                                   \
+      stop_at[lengths[l]] |= 1u << l;                                          \
+      max_length = std::max(max_length, lengths[l]);                           \
+    }                                                                          \
+    const auto data{reinterpret_cast<const simd_lane_t<T> *>(base)};          \
+    const auto start{Ops::index_load(starts)};                                 \
+    auto active{(1u << lanes) - 1};                                            \
+    auto best{Ops::gather(Ops::broadcast(0), Ops::mask_from_bits(active),      \
+                          data, start)};                                       \
+    auto best_index{Ops::index_broadcast(0)};                                  \
+    for (std::size_t c{1}; c < max_length; ++c) {                              \
+      active &= ~stop_at[c];                                                   \
+      const auto column{Ops::index_broadcast(static_cast<I>(c))};              \
+      const auto value{Ops::gather(best, Ops::mask_from_bits(active), data,    \
+                                   Ops::index_add(start, column))};            \
+      const auto take{Ops::greater(value, best)};                              \
+      best = Ops::select(take, value, best);                                   \
+      best_index = Ops::index_select(take, column, best_index);                \
+    }                                                                          \
+    I indices[lanes];                                                          \
+    Ops::index_store(indices, best_index);                                     \
+    for (std::size_t l{0}; l < lanes; ++l) {                                   \
+      results[l] = static_cast<std::size_t>(indices[l]);                       \
+    }                                                                          \
+  }
+
+LIBUTILS_DEFINE_ARGMAX_LANES_KERNEL(avx2, LIBUTILS_TARGET_AVX2)
+LIBUTILS_DEFINE_ARGMAX_LANES_KERNEL(avx512, LIBUTILS_TARGET_AVX512)
+
+#undef LIBUTILS_DEFINE_ARGMAX_LANES_KERNEL
+
+/**
+ * @brief Processes segments [first, last) in windows of Ops::width, the short
+ * non-empty segments of a window sharing one lane kernel call.
+ */
+template <typename Ops, typename T, typename Kernel, typename Segment,
+          typename Emit>
+void segmented_argmax_windows(const T *values, std::size_t first,
+                              const std::size_t last, Kernel kernel,
+                              Segment segment, Emit emit) {
+  using I = typename Ops::index_type;
+  constexpr std::size_t lanes{Ops::width};
+  for (; first < last; first += lanes) {
+    const auto count{std::min(lanes, last - first)};
+    std::pair<std::size_t, std::size_t> segments[lanes];
+    std::size_t results[lanes];
+    std::size_t lane_segment[lanes];
+    std::size_t used{0};
+    for (std::size_t i{0}; i < count; ++i) {
+      segments[i] = segment(first + i);
+      const auto [start, length]{segments[i]};
+      if (length && length <= short_segment_max) {
+        lane_segment[used++] = i;
+      } else {
+        results[i] = length ? argmax_segment(values + start, length) : 0;
+      }
+    }
+    if (used) {
+      // Offsets are relative to the first batched segment and must fit the
+      // index lanes.
+      const auto base{segments[lane_segment[0]].first};
+      const auto span{segments[lane_segment[used - 1]].first +
+                      segments[lane_segment[used - 1]].second - base};
+      if (span <= static_cast<std::size_t>(std::numeric_limits<I>::max())) {
+        I starts[lanes];
+        std::size_t lengths[lanes];
+        std::size_t lane_results[lanes];
+        for (std::size_t l{0}; l < lanes; ++l) {
+          const auto &s{segments[lane_segment[std::min(l, used - 1)]]};
+          starts[l] = static_cast<I>(s.first - base);
+          lengths[l] = s.second;
+        }
+        kernel(values + base, starts, lengths, lane_results);
+        for (std::size_t l{0}; l < used; ++l) {
+          results[lane_segment[l]] = lane_results[l];
+        }
+      } else {
+        for (std::size_t l{0}; l < used; ++l) {
+          const auto [start, length]{segments[lane_segment[l]]};
+          results[lane_segment[l]] = argmax_segment(values + start, length);
+        }
+      }
+    }
+    for (std::size_t i{0}; i < count; ++i) {
+      emit(first + i, results[i]);
+    }
+  }
+}
+#endif // LIBUTILS_X86_SIMD
+
+/**
+ * @brief Calls emit(i, argmax of segment i) for i in [first, last) in
+ * increasing order, segment(i) returning the (start, length) of segment i in
+ * values.
+ *
+ * With AVX2 or AVX-512, short segments are batched into lanes with gathers.
+ */
+template <typename T, typename Segment, typename Emit>
+void segmented_argmax_range(const T *values, std::size_t first,
+                            const std::size_t last, Segment segment,
+                            Emit emit) {
+#if LIBUTILS_X86_SIMD
+  if constexpr (has_simd_lane_v<T>) {
+    using L = simd_lane_t<T>;
+    switch (active_simd_level()) {
+    case simd_level::avx512:
+      return segmented_argmax_windows<avx512_ops<L>>(
+          values, first, last, argmax_lanes_avx512<avx512_ops<L>, T>, segment,
+          emit);
+    case simd_level::avx2:
+      return segmented_argmax_windows<avx2_ops<L>>(
+          values, first, last, argmax_lanes_avx2<avx2_ops<L>, T>, segment,
+          emit);
+    default:
+      break;
+    }
+  }
+#endif
+  for (; first < last; ++first) {
+    const auto [start, length]{segment(first)};
+    emit(first, length ? argmax_segment(values + start, length) : 0);
+  }
+}
+} // namespace details
+} // namespace utils
+
+#endif // DETAILS_SEGMENTED_ARGMAX_HPP
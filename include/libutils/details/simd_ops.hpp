@@ -0,0 +1,786 @@
+#ifndef DETAILS_SIMD_OPS_HPP
+#define DETAILS_SIMD_OPS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "cpu.hpp"
+
+namespace utils {
+namespace details {
+/**
+ * @brief Maps an arithmetic type to the lane type of the SIMD kernels.
+ *
+ * Kernels exist for float, double and 32/64-bit signed integers; every other
+ * type maps to void and takes the generic path.
+ */
+template <typename T, typename = void> struct simd_lane { using type = void; };
+
+template <typename T>
+struct simd_lane<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+  using type = std::conditional_t<
+      std::is_same_v<T, float>, float,
+      std::conditional_t<std::is_same_v<T, double>, double, void>>;
+};
+
+template <typename T>
+struct simd_lane<T, std::enable_if_t<std::is_integral_v<T> &&
+                                     std::is_signed_v<T> && sizeof(T) == 4>> {
+  using type = std::int32_t;
+};
+
+template <typename T>
+struct simd_lane<T, std::enable_if_t<std::is_integral_v<T> &&
+                                     std::is_signed_v<T> && sizeof(T) == 8>> {
+  using type = std::int64_t;
+};
+
+template <typename T> using simd_lane_t = typename simd_lane<T>::type;
+
+template <typename T>
+inline constexpr bool has_simd_lane_v = !std::is_void_v<simd_lane_t<T>>;
+
+/**
+ * @brief Returns true for values that compare unordered with themselves (NaN).
+ */
+template <typename T> constexpr bool is_unordered(const T &value) noexcept {
+  if constexpr (std::is_floating_point_v<T>) {
+    return value != value;
+  } else {
+    return false;
+  }
+}
+
+#if LIBUTILS_X86_SIMD
+/*
+ * Lane operations per instruction set and lane type. Every specialization
+ * provides the same interface so that a kernel is written once per
+ * instruction set:
+ *
+ *   vector / mask / index_vector  register types,
+ *   width                         number of lanes,
+ *   load, broadcast, greater, mask_from_bits, mask_and, mask_bits, select,
+ *   store,
+ *   index_iota, index_broadcast, index_add, index_select, index_store,
+ *
+ * and the AVX2 and AVX-512 ones also index_load and a masked gather.
+ *
+ * Indices travel in lanes of the same width as the values, so the 32-bit
+ * kernels must not be run over more than 2^31 elements at once.
+ */
+template <typename L> struct sse42_ops;
+template <typename L> struct avx2_ops;
+template <typename L> struct avx512_ops;
+
+template <> struct sse42_ops<float> {
+  using vector = __m128;
+  using mask = __m128;
+  using index_vector = __m128i;
+  using index_type = std::int32_t;
+  static constexpr std::size_t width{4};
+
+  LIBUTILS_TARGET_SSE42 static vector load(const void *p) {
+    return _mm_loadu_ps(static_cast<const float *>(p));
+  }
+  LIBUTILS_TARGET_SSE42 static vector broadcast(float v) {
+    return _mm_set1_ps(v);
+  }
+  LIBUTILS_TARGET_SSE42 static mask greater(vector a, vector b) {
+    return _mm_cmpgt_ps(a, b);
+  }
+  LIBUTILS_TARGET_SSE42 static mask mask_from_bits(unsigned bits) {
+    const auto lanes{_mm_setr_epi32(1, 2, 4, 8)};
+    return _mm_castsi128_ps(_mm_cmpeq_epi32(
+        _mm_and_si128(_mm_set1_epi32(static_cast<int>(bits)), lanes), lanes));
+  }
+  LIBUTILS_TARGET_SSE42 static mask mask_and(mask a, mask b) {
+    return _mm_and_ps(a, b);
+  }
+  LIBUTILS_TARGET_SSE42 static unsigned mask_bits(mask m) {
+    return static_cast<unsigned>(_mm_movemask_ps(m));
+  }
+  LIBUTILS_TARGET_SSE42 static vector select(mask m, vector a, vector b) {
+    return _mm_blendv_ps(b, a, m);
+  }
+  LIBUTILS_TARGET_SSE42 static void store(void *p, vector v) {
+    _mm_storeu_ps(static_cast<float *>(p), v);
+  }
+  LIBUTILS_TARGET_SSE42 static index_vector index_iota(index_type start) {
+    return _mm_add_epi32(_mm_set1_epi32(start), _mm_setr_epi32(0, 1, 2, 3));
+  }
+  LIBUTILS_TARGET_SSE42 static index_vector index_broadcast(index_type v) {
+    return _mm_set1_epi32(v);
+  }
+  LIBUTILS_TARGET_SSE42 static index_vector index_add(index_vector a,
+                                                      index_vector b) {
+    return _mm_add_epi32(a, b);
+  }
+  LIBUTILS_TARGET_SSE42 static index_vector
+  index_select(mask m, index_vector a, index_vector b) {
+    return _mm_blendv_epi8(b, a, _mm_castps_si128(m));
+  }
+  LIBUTILS_TARGET_SSE42 static void index_store(index_type *p,
+                                                index_vector v) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v);
+  }
+};
+
+template <> struct sse42_ops<double> {
+  using vector = __m128d;
+  using mask = __m128d;
+  using index_vector = __m128i;
+  using index_type = std::int64_t;
+  static constexpr std::size_t width{2};
+
+  LIBUTILS_TARGET_SSE42 static vector load(const void *p) {
+    return _mm_loadu_pd(static_cast<const double *>(p));
+  }
+  LIBUTILS_TARGET_SSE42 static vector broadcast(double v) {
+    return _mm_set1_pd(v);
+  }
+  LIBUTILS_TARGET_SSE42 static mask greater(vector a, vector b) {
+    return _mm_cmpgt_pd(a, b);
+  }
+  LIBUTILS_TARGET_SSE42 static mask mask_from_bits(unsigned bits) {
+    const auto lanes{_mm_set_epi64x(2, 1)};
+    return _mm_castsi128_pd(_mm_cmpeq_epi64(
+        _mm_and_si128(_mm_set1_epi64x(bits), lanes), lanes));
+  }
+  LIBUTILS_TARGET_SSE42 static mask mask_and(mask a, mask b) {
+    return _mm_and_pd(a, b);
+  }
+  LIBUTILS_TARGET_SSE42 static unsigned mask_bits(mask m) {
+    return static_cast<unsigned>(_mm_movemask_pd(m));
+  }
+  LIBUTILS_TARGET_SSE42 static vector select(mask m, vector a, vector b) {
+    return _mm_blendv_pd(b, a, m);
+  }
+  LIBUTILS_TARGET_SSE42 static void store(void *p, vector v) {
+    _mm_storeu_pd(static_cast<double *>(p), v);
+  }
+  LIBUTILS_TARGET_SSE42 static index_vector index_iota(index_type start) {
+    return _mm_add_epi64(_mm_set1_epi64x(start), _mm_set_epi64x(1, 0));
+  }
+  LIBUTILS_TARGET_SSE42 static index_vector index_broadcast(index_type v) {
+    return _mm_set1_epi64x(v);
+  }
+  LIBUTILS_TARGET_SSE42 static index_vector index_add(index_vector a,
+                                                      index_vector b) {
+    return _mm_add_epi64(a, b);
+  }
+  LIBUTILS_TARGET_SSE42 static index_vector
+  index_select(mask m, index_vector a, index_vector b) {
+    return _mm_blendv_epi8(b, a, _mm_castpd_si128(m));
+  }
+  LIBUTILS_TARGET_SSE42 static void index_store(index_type *p,
+                                                index_vector v) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v);
+  }
+};
+
+template <> struct sse42_ops<std::int32_t> {
+  using vector = __m128i;
+  using mask = __m128i;
+  using index_vector = __m128i;
+  using index_type = std::int32_t;
+  static constexpr std::size_t width{4};
+
+  LIBUTILS_TARGET_SSE42 static vector load(const void *p) {
+    return _mm_loadu_si128(static_cast<const __m128i *>(p));
+  }
+  LIBUTILS_TARGET_SSE42 static vector broadcast(std::int32_t v) {
+    return _mm_set1_epi32(v);
+  }
+  LIBUTILS_TARGET_SSE42 static mask greater(vector a, vector b) {
+    return _mm_cmpgt_epi32(a, b);
+  }
+  LIBUTILS_TARGET_SSE42 static mask mask_from_bits(unsigned bits) {
+    const auto lanes{_mm_setr_epi32(1, 2, 4, 8)};
+    return _mm_cmpeq_epi32(
+        _mm_and_si128(_mm_set1_epi32(static_cast<int>(bits)), lanes), lanes);
+  }
+  LIBUTILS_TARGET_SSE42 static mask mask_and(mask a, mask b) {
+    return _mm_and_si128(a, b);
+  }
+  LIBUTILS_TARGET_SSE42 static unsigned mask_bits(mask m) {
+    return static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(m)));
+  }
+  LIBUTILS_TARGET_SSE42 static vector select(mask m, vector a, vector b) {
+    return _mm_blendv_epi8(b, a, m);
+  }
+  LIBUTILS_TARGET_SSE42 static void store(void *p, vector v) {
+    _mm_storeu_si128(static_cast<__m128i *>(p), v);
+  }
+  LIBUTILS_TARGET_SSE42 static index_vector index_iota(index_type start) {
+    return _mm_add_epi32(_mm_set1_epi32(start), _mm_setr_epi32(0, 1, 2, 3));
+  }
+  LIBUTILS_TARGET_SSE42 static index_vector index_broadcast(index_type v) {
+    return _mm_set1_epi32(v);
+  }
+  LIBUTILS_TARGET_SSE42 static index_vector index_add(index_vector a,
+                                                      index_vector b) {
+    return _mm_add_epi32(a, b);
+  }
+  LIBUTILS_TARGET_SSE42 static index_vector
+  index_select(mask m, index_vector a, index_vector b) {
+    return _mm_blendv_epi8(b, a, m);
+  }
+  LIBUTILS_TARGET_SSE42 static void index_store(index_type *p,
+                                                index_vector v) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v);
+  }
+};
+
+template <> struct sse42_ops<std::int64_t> {
+  using vector = __m128i;
+  using mask = __m128i;
+  using index_vector = __m128i;
+  using index_type = std::int64_t;
+  static constexpr std::size_t width{2};
+
+  LIBUTILS_TARGET_SSE42 static vector load(const void *p) {
+    return _mm_loadu_si128(static_cast<const __m128i *>(p));
+  }
+  LIBUTILS_TARGET_SSE42 static vector broadcast(std::int64_t v) {
+    return _mm_set1_epi64x(v);
+  }
+  LIBUTILS_TARGET_SSE42 static mask greater(vector a, vector b) {
+    return _mm_cmpgt_epi64(a, b);
+  }
+  LIBUTILS_TARGET_SSE42 static mask mask_from_bits(unsigned bits) {
+    const auto lanes{_mm_set_epi64x(2, 1)};
+    return _mm_cmpeq_epi64(_mm_and_si128(_mm_set1_epi64x(bits), lanes), lanes);
+  }
+  LIBUTILS_TARGET_SSE42 static mask mask_and(mask a, mask b) {
+    return _mm_and_si128(a, b);
+  }
+  LIBUTILS_TARGET_SSE42 static unsigned mask_bits(mask m) {
+    return static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(m)));
+  }
+  LIBUTILS_TARGET_SSE42 static vector select(mask m, vector a, vector b) {
+    return _mm_blendv_epi8(b, a, m);
+  }
+  LIBUTILS_TARGET_SSE42 static void store(void *p, vector v) {
+    _mm_storeu_si128(static_cast<__m128i *>(p), v);
+  }
+  LIBUTILS_TARGET_SSE42 static index_vector index_iota(index_type start) {
+    return _mm_add_epi64(_mm_set1_epi64x(start), _mm_set_epi64x(1, 0));
+  }
+  LIBUTILS_TARGET_SSE42 static index_vector index_broadcast(index_type v) {
+    return _mm_set1_epi64x(v);
+  }
+  LIBUTILS_TARGET_SSE42 static index_vector index_add(index_vector a,
+                                                      index_vector b) {
+    return _mm_add_epi64(a, b);
+  }
+  LIBUTILS_TARGET_SSE42 static index_vector
+  index_select(mask m, index_vector a, index_vector b) {
+    return _mm_blendv_epi8(b, a, m);
+  }
+  LIBUTILS_TARGET_SSE42 static void index_store(index_type *p,
+                                                index_vector v) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v);
+  }
+};
+
+template <> struct avx2_ops<float> {
+  using vector = __m256;
+  using mask = __m256;
+  using index_vector = __m256i;
+  using index_type = std::int32_t;
+  static constexpr std::size_t width{8};
+
+  LIBUTILS_TARGET_AVX2 static vector load(const void *p) {
+    return _mm256_loadu_ps(static_cast<const float *>(p));
+  }
+  LIBUTILS_TARGET_AVX2 static vector broadcast(float v) {
+    return _mm256_set1_ps(v);
+  }
+  LIBUTILS_TARGET_AVX2 static mask greater(vector a, vector b) {
+    return _mm256_cmp_ps(a, b, _CMP_GT_OQ);
+  }
+  LIBUTILS_TARGET_AVX2 static mask mask_from_bits(unsigned bits) {
+    const auto lanes{_mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128)};
+    return _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+        _mm256_and_si256(_mm256_set1_epi32(static_cast<int>(bits)), lanes),
+        lanes));
+  }
+  LIBUTILS_TARGET_AVX2 static mask mask_and(mask a, mask b) {
+    return _mm256_and_ps(a, b);
+  }
+  LIBUTILS_TARGET_AVX2 static unsigned mask_bits(mask m) {
+    return static_cast<unsigned>(_mm256_movemask_ps(m));
+  }
+  LIBUTILS_TARGET_AVX2 static vector select(mask m, vector a, vector b) {
+    return _mm256_blendv_ps(b, a, m);
+  }
+  LIBUTILS_TARGET_AVX2 static void store(void *p, vector v) {
+    _mm256_storeu_ps(static_cast<float *>(p), v);
+  }
+  LIBUTILS_TARGET_AVX2 static index_vector index_iota(index_type start) {
+    return _mm256_add_epi32(_mm256_set1_epi32(start),
+                            _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+  }
+  LIBUTILS_TARGET_AVX2 static index_vector index_broadcast(index_type v) {
+    return _mm256_set1_epi32(v);
+  }
+  LIBUTILS_TARGET_AVX2 static index_vector index_add(index_vector a,
+                                                     index_vector b) {
+    return _mm256_add_epi32(a, b);
+  }
+  LIBUTILS_TARGET_AVX2 static index_vector
+  index_select(mask m, index_vector a, index_vector b) {
+    return _mm256_blendv_epi8(b, a, _mm256_castps_si256(m));
+  }
+  LIBUTILS_TARGET_AVX2 static void index_store(index_type *p,
+                                               index_vector v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+  }
+  LIBUTILS_TARGET_AVX2 static index_vector index_load(const index_type *p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+  }
+  LIBUTILS_TARGET_AVX2 static vector gather(vector src, mask m,
+                                            const float *base,
+                                            index_vector offsets) {
+    return _mm256_mask_i32gather_ps(src, base, offsets, m, 4);
+  }
+};
+
+template <> struct avx2_ops<double> {
+  using vector = __m256d;
+  using mask = __m256d;
+  using index_vector = __m256i;
+  using index_type = std::int64_t;
+  static constexpr std::size_t width{4};
+
+  LIBUTILS_TARGET_AVX2 static vector load(const void *p) {
+    return _mm256_loadu_pd(static_cast<const double *>(p));
+  }
+  LIBUTILS_TARGET_AVX2 static vector broadcast(double v) {
+    return _mm256_set1_pd(v);
+  }
+  LIBUTILS_TARGET_AVX2 static mask greater(vector a, vector b) {
+    return _mm256_cmp_pd(a, b, _CMP_GT_OQ);
+  }
+  LIBUTILS_TARGET_AVX2 static mask mask_from_bits(unsigned bits) {
+    const auto lanes{_mm256_setr_epi64x(1, 2, 4, 8)};
+    return _mm256_castsi256_pd(_mm256_cmpeq_epi64(
+        _mm256_and_si256(_mm256_set1_epi64x(bits), lanes), lanes));
+  }
+  LIBUTILS_TARGET_AVX2 static mask mask_and(mask a, mask b) {
+    return _mm256_and_pd(a, b);
+  }
+  LIBUTILS_TARGET_AVX2 static unsigned mask_bits(mask m) {
+    return static_cast<unsigned>(_mm256_movemask_pd(m));
+  }
+  LIBUTILS_TARGET_AVX2 static vector select(mask m, vector a, vector b) {
+    return _mm256_blendv_pd(b, a, m);
+  }
+  LIBUTILS_TARGET_AVX2 static void store(void *p, vector v) {
+    _mm256_storeu_pd(static_cast<double *>(p), v);
+  }
+  LIBUTILS_TARGET_AVX2 static index_vector index_iota(index_type start) {
+    return _mm256_add_epi64(_mm256_set1_epi64x(start),
+                            _mm256_setr_epi64x(0, 1, 2, 3));
+  }
+  LIBUTILS_TARGET_AVX2 static index_vector index_broadcast(index_type v) {
+    return _mm256_set1_epi64x(v);
+  }
+  LIBUTILS_TARGET_AVX2 static index_vector index_add(index_vector a,
+                                                     index_vector b) {
+    return _mm256_add_epi64(a, b);
+  }
+  LIBUTILS_TARGET_AVX2 static index_vector
+  index_select(mask m, index_vector a, index_vector b) {
+    return _mm256_blendv_epi8(b, a, _mm256_castpd_si256(m));
+  }
+  LIBUTILS_TARGET_AVX2 static void index_store(index_type *p,
+                                               index_vector v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+  }
+  LIBUTILS_TARGET_AVX2 static index_vector index_load(const index_type *p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+  }
+  LIBUTILS_TARGET_AVX2 static vector gather(vector src, mask m,
+                                            const double *base,
+                                            index_vector offsets) {
+    return _mm256_mask_i64gather_pd(src, base, offsets, m, 8);
+  }
+};
+
+template <> struct avx2_ops<std::int32_t> {
+  using vector = __m256i;
+  using mask = __m256i;
+  using index_vector = __m256i;
+  using index_type = std::int32_t;
+  static constexpr std::size_t width{8};
+
+  LIBUTILS_TARGET_AVX2 static vector load(const void *p) {
+    return _mm256_loadu_si256(static_cast<const __m256i *>(p));
+  }
+  LIBUTILS_TARGET_AVX2 static vector broadcast(std::int32_t v) {
+    return _mm256_set1_epi32(v);
+  }
+  LIBUTILS_TARGET_AVX2 static mask greater(vector a, vector b) {
+    return _mm256_cmpgt_epi32(a, b);
+  }
+  LIBUTILS_TARGET_AVX2 static mask mask_from_bits(unsigned bits) {
+    const auto lanes{_mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128)};
+    return _mm256_cmpeq_epi32(
+        _mm256_and_si256(_mm256_set1_epi32(static_cast<int>(bits)), lanes),
+        lanes);
+  }
+  LIBUTILS_TARGET_AVX2 static mask mask_and(mask a, mask b) {
+    return _mm256_and_si256(a, b);
+  }
+  LIBUTILS_TARGET_AVX2 static unsigned mask_bits(mask m) {
+    return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(m)));
+  }
+  LIBUTILS_TARGET_AVX2 static vector select(mask m, vector a, vector b) {
+    return _mm256_blendv_epi8(b, a, m);
+  }
+  LIBUTILS_TARGET_AVX2 static void store(void *p, vector v) {
+    _mm256_storeu_si256(static_cast<__m256i *>(p), v);
+  }
+  LIBUTILS_TARGET_AVX2 static index_vector index_iota(index_type start) {
+    return _mm256_add_epi32(_mm256_set1_epi32(start),
+                            _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+  }
+  LIBUTILS_TARGET_AVX2 static index_vector index_broadcast(index_type v) {
+    return _mm256_set1_epi32(v);
+  }
+  LIBUTILS_TARGET_AVX2 static index_vector index_add(index_vector a,
+                                                     index_vector b) {
+    return _mm256_add_epi32(a, b);
+  }
+  LIBUTILS_TARGET_AVX2 static index_vector
+  index_select(mask m, index_vector a, index_vector b) {
+    return _mm256_blendv_epi8(b, a, m);
+  }
+  LIBUTILS_TARGET_AVX2 static void index_store(index_type *p,
+                                               index_vector v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+  }
+  LIBUTILS_TARGET_AVX2 static index_vector index_load(const index_type *p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+  }
+  LIBUTILS_TARGET_AVX2 static vector gather(vector src, mask m,
+                                            const std::int32_t *base,
+                                            index_vector offsets) {
+    return _mm256_mask_i32gather_epi32(src, reinterpret_cast<const int *>(base),
+                                       offsets, m, 4);
+  }
+};
+
+template <> struct avx2_ops<std::int64_t> {
+  using vector = __m256i;
+  using mask = __m256i;
+  using index_vector = __m256i;
+  using index_type = std::int64_t;
+  static constexpr std::size_t width{4};
+
+  LIBUTILS_TARGET_AVX2 static vector load(const void *p) {
+    return _mm256_loadu_si256(static_cast<const __m256i *>(p));
+  }
+  LIBUTILS_TARGET_AVX2 static vector broadcast(std::int64_t v) {
+    return _mm256_set1_epi64x(v);
+  }
+  LIBUTILS_TARGET_AVX2 static mask greater(vector a, vector b) {
+    return _mm256_cmpgt_epi64(a, b);
+  }
+  LIBUTILS_TARGET_AVX2 static mask mask_from_bits(unsigned bits) {
+    const auto lanes{_mm256_setr_epi64x(1, 2, 4, 8)};
+    return _mm256_cmpeq_epi64(
+        _mm256_and_si256(_mm256_set1_epi64x(bits), lanes), lanes);
+  }
+  LIBUTILS_TARGET_AVX2 static mask mask_and(mask a, mask b) {
+    return _mm256_and_si256(a, b);
+  }
+  LIBUTILS_TARGET_AVX2 static unsigned mask_bits(mask m) {
+    return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(m)));
+  }
+  LIBUTILS_TARGET_AVX2 static vector select(mask m, vector a, vector b) {
+    return _mm256_blendv_epi8(b, a, m);
+  }
+  LIBUTILS_TARGET_AVX2 static void store(void *p, vector v) {
+    _mm256_storeu_si256(static_cast<__m256i *>(p), v);
+  }
+  LIBUTILS_TARGET_AVX2 static index_vector index_iota(index_type start) {
+    return _mm256_add_epi64(_mm256_set1_epi64x(start),
+                            _mm256_setr_epi64x(0, 1, 2, 3));
+  }
+  LIBUTILS_TARGET_AVX2 static index_vector index_broadcast(index_type v) {
+    return _mm256_set1_epi64x(v);
+  }
+  LIBUTILS_TARGET_AVX2 static index_vector index_add(index_vector a,
+                                                     index_vector b) {
+    return _mm256_add_epi64(a, b);
+  }
+  LIBUTILS_TARGET_AVX2 static index_vector
+  index_select(mask m, index_vector a, index_vector b) {
+    return _mm256_blendv_epi8(b, a, m);
+  }
+  LIBUTILS_TARGET_AVX2 static void index_store(index_type *p,
+                                               index_vector v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+  }
+  LIBUTILS_TARGET_AVX2 static index_vector index_load(const index_type *p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+  }
+  LIBUTILS_TARGET_AVX2 static vector gather(vector src, mask m,
+                                            const std::int64_t *base,
+                                            index_vector offsets) {
+    return _mm256_mask_i64gather_epi64(
+        src, reinterpret_cast<const long long *>(base), offsets, m, 8);
+  }
+};
+
+template <> struct avx512_ops<float> {
+  using vector = __m512;
+  using mask = __mmask16;
+  using index_vector = __m512i;
+  using index_type = std::int32_t;
+  static constexpr std::size_t width{16};
+
+  LIBUTILS_TARGET_AVX512 static vector load(const void *p) {
+    return _mm512_loadu_ps(p);
+  }
+  LIBUTILS_TARGET_AVX512 static vector broadcast(float v) {
+    return _mm512_set1_ps(v);
+  }
+  LIBUTILS_TARGET_AVX512 static mask greater(vector a, vector b) {
+    return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ);
+  }
+  LIBUTILS_TARGET_AVX512 static mask mask_from_bits(unsigned bits) {
+    return static_cast<mask>(bits);
+  }
+  LIBUTILS_TARGET_AVX512 static mask mask_and(mask a, mask b) {
+    return static_cast<mask>(a & b);
+  }
+  LIBUTILS_TARGET_AVX512 static unsigned mask_bits(mask m) {
+    return static_cast<unsigned>(m);
+  }
+  LIBUTILS_TARGET_AVX512 static vector select(mask m, vector a, vector b) {
+    return _mm512_mask_blend_ps(m, b, a);
+  }
+  LIBUTILS_TARGET_AVX512 static void store(void *p, vector v) {
+    _mm512_storeu_ps(p, v);
+  }
+  LIBUTILS_TARGET_AVX512 static index_vector index_iota(index_type start) {
+    return _mm512_add_epi32(
+        _mm512_set1_epi32(start),
+        _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+                          15));
+  }
+  LIBUTILS_TARGET_AVX512 static index_vector index_broadcast(index_type v) {
+    return _mm512_set1_epi32(v);
+  }
+  LIBUTILS_TARGET_AVX512 static index_vector index_add(index_vector a,
+                                                       index_vector b) {
+    return _mm512_add_epi32(a, b);
+  }
+  LIBUTILS_TARGET_AVX512 static index_vector
+  index_select(mask m, index_vector a, index_vector b) {
+    return _mm512_mask_blend_epi32(m, b, a);
+  }
+  LIBUTILS_TARGET_AVX512 static void index_store(index_type *p,
+                                                 index_vector v) {
+    _mm512_storeu_si512(p, v);
+  }
+  LIBUTILS_TARGET_AVX512 static index_vector index_load(const index_type *p) {
+    return _mm512_loadu_si512(p);
+  }
+  LIBUTILS_TARGET_AVX512 static vector gather(vector src, mask m,
+                                              const float *base,
+                                              index_vector offsets) {
+    return _mm512_mask_i32gather_ps(src, m, offsets, base, 4);
+  }
+};
+
+template <> struct avx512_ops<double> {
+  using vector = __m512d;
+  using mask = __mmask8;
+  using index_vector = __m512i;
+  using index_type = std::int64_t;
+  static constexpr std::size_t width{8};
+
+  LIBUTILS_TARGET_AVX512 static vector load(const void *p) {
+    return _mm512_loadu_pd(p);
+  }
+  LIBUTILS_TARGET_AVX512 static vector broadcast(double v) {
+    return _mm512_set1_pd(v);
+  }
+  LIBUTILS_TARGET_AVX512 static mask greater(vector a, vector b) {
+    return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ);
+  }
+  LIBUTILS_TARGET_AVX512 static mask mask_from_bits(unsigned bits) {
+    return static_cast<mask>(bits);
+  }
+  LIBUTILS_TARGET_AVX512 static mask mask_and(mask a, mask b) {
+    return static_cast<mask>(a & b);
+  }
+  LIBUTILS_TARGET_AVX512 static unsigned mask_bits(mask m) {
+    return static_cast<unsigned>(m);
+  }
+  LIBUTILS_TARGET_AVX512 static vector select(mask m, vector a, vector b) {
+    return _mm512_mask_blend_pd(m, b, a);
+  }
+  LIBUTILS_TARGET_AVX512 static void store(void *p, vector v) {
+    _mm512_storeu_pd(p, v);
+  }
+  LIBUTILS_TARGET_AVX512 static index_vector index_iota(index_type start) {
+    return _mm512_add_epi64(_mm512_set1_epi64(start),
+                            _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7));
+  }
+  LIBUTILS_TARGET_AVX512 static index_vector index_broadcast(index_type v) {
+    return _mm512_set1_epi64(v);
+  }
+  LIBUTILS_TARGET_AVX512 static index_vector index_add(index_vector a,
+                                                       index_vector b) {
+    return _mm512_add_epi64(a, b);
+  }
+  LIBUTILS_TARGET_AVX512 static index_vector
+  index_select(mask m, index_vector a, index_vector b) {
+    return _mm512_mask_blend_epi64(m, b, a);
+  }
+  LIBUTILS_TARGET_AVX512 static void index_store(index_type *p,
+                                                 index_vector v) {
+    _mm512_storeu_si512(p, v);
+  }
+  LIBUTILS_TARGET_AVX512 static index_vector index_load(const index_type *p) {
+    return _mm512_loadu_si512(p);
+  }
+  LIBUTILS_TARGET_AVX512 static vector gather(vector src, mask m,
+                                              const double *base,
+                                              index_vector offsets) {
+    return _mm512_mask_i64gather_pd(src, m, offsets, base, 8);
+  }
+};
+
+template <> struct avx512_ops<std::int32_t> {
+  using vector = __m512i;
+  using mask = __mmask16;
+  using index_vector = __m512i;
+  using index_type = std::int32_t;
+  static constexpr std::size_t width{16};
+
+  LIBUTILS_TARGET_AVX512 static vector load(const void *p) {
+    return _mm512_loadu_si512(p);
+  }
+  LIBUTILS_TARGET_AVX512 static vector broadcast(std::int32_t v) {
+    return _mm512_set1_epi32(v);
+  }
+  LIBUTILS_TARGET_AVX512 static mask greater(vector a, vector b) {
+    return _mm512_cmpgt_epi32_mask(a, b);
+  }
+  LIBUTILS_TARGET_AVX512 static mask mask_from_bits(unsigned bits) {
+    return static_cast<mask>(bits);
+  }
+  LIBUTILS_TARGET_AVX512 static mask mask_and(mask a, mask b) {
+    return static_cast<mask>(a & b);
+  }
+  LIBUTILS_TARGET_AVX512 static unsigned mask_bits(mask m) {
+    return static_cast<unsigned>(m);
+  }
+  LIBUTILS_TARGET_AVX512 static vector select(mask m, vector a, vector b) {
+    return _mm512_mask_blend_epi32(m, b, a);
+  }
+  LIBUTILS_TARGET_AVX512 static void store(void *p, vector v) {
+    _mm512_storeu_si512(p, v);
+  }
+  LIBUTILS_TARGET_AVX512 static index_vector index_iota(index_type start) {
+    return _mm512_add_epi32(
+        _mm512_set1_epi32(start),
+        _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+                          15));
+  }
+  LIBUTILS_TARGET_AVX512 static index_vector index_broadcast(index_type v) {
+    return _mm512_set1_epi32(v);
+  }
+  LIBUTILS_TARGET_AVX512 static index_vector index_add(index_vector a,
+                                                       index_vector b) {
+    return _mm512_add_epi32(a, b);
+  }
+  LIBUTILS_TARGET_AVX512 static index_vector
+  index_select(mask m, index_vector a, index_vector b) {
+    return _mm512_mask_blend_epi32(m, b, a);
+  }
+  LIBUTILS_TARGET_AVX512 static void index_store(index_type *p,
+                                                 index_vector v) {
+    _mm512_storeu_si512(p, v);
+  }
+  LIBUTILS_TARGET_AVX512 static index_vector index_load(const index_type *p) {
+    return _mm512_loadu_si512(p);
+  }
+  LIBUTILS_TARGET_AVX512 static vector gather(vector src, mask m,
+                                              const std::int32_t *base,
+                                              index_vector offsets) {
+    return _mm512_mask_i32gather_epi32(src, m, offsets, base, 4);
+  }
+};
+
+template <> struct avx512_ops<std::int64_t> {
+  using vector = __m512i;
+  using mask = __mmask8;
+  using index_vector = __m512i;
+  using index_type = std::int64_t;
+  static constexpr std::size_t width{8};
+
+  LIBUTILS_TARGET_AVX512 static vector load(const void *p) {
+    return _mm512_loadu_si512(p);
+  }
+  LIBUTILS_TARGET_AVX512 static vector broadcast(std::int64_t v) {
+    return _mm512_set1_epi64(v);
+  }
+  LIBUTILS_TARGET_AVX512 static mask greater(vector a, vector b) {
+    return _mm512_cmpgt_epi64_mask(a, b);
+  }
+  LIBUTILS_TARGET_AVX512 static mask mask_from_bits(unsigned bits) {
+    return static_cast<mask>(bits);
+  }
+  LIBUTILS_TARGET_AVX512 static mask mask_and(mask a, mask b) {
+    return static_cast<mask>(a & b);
+  }
+  LIBUTILS_TARGET_AVX512 static unsigned mask_bits(mask m) {
+    return static_cast<unsigned>(m);
+  }
+  LIBUTILS_TARGET_AVX512 static vector select(mask m, vector a, vector b) {
+    return _mm512_mask_blend_epi64(m, b, a);
+  }
+  LIBUTILS_TARGET_AVX512 static void store(void *p, vector v) {
+    _mm512_storeu_si512(p, v);
+  }
+  LIBUTILS_TARGET_AVX512 static index_vector index_iota(index_type start) {
+    return _mm512_add_epi64(_mm512_set1_epi64(start),
+                            _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7));
+  }
+  LIBUTILS_TARGET_AVX512 static index_vector index_broadcast(index_type v) {
+    return _mm512_set1_epi64(v);
+  }
+  LIBUTILS_TARGET_AVX512 static index_vector index_add(index_vector a,
+                                                       index_vector b) {
+    return _mm512_add_epi64(a, b);
+  }
+  LIBUTILS_TARGET_AVX512 static index_vector
+  index_select(mask m, index_vector a, index_vector b) {
+    return _mm512_mask_blend_epi64(m, b, a);
+  }
+  LIBUTILS_TARGET_AVX512 static void index_store(index_type *p,
+                                                 index_vector v) {
+    _mm512_storeu_si512(p, v);
+  }
+  LIBUTILS_TARGET_AVX512 static index_vector index_load(const index_type *p) {
+    return _mm512_loadu_si512(p);
+  }
+  LIBUTILS_TARGET_AVX512 static vector gather(vector src, mask m,
+                                              const std::int64_t *base,
+                                              index_vector offsets) {
+    return _mm512_mask_i64gather_epi64(src, m, offsets, base, 8);
+  }
+};
+#endif // LIBUTILS_X86_SIMD
+} // namespace details
+} // namespace utils
+
+#endif // DETAILS_SIMD_OPS_HPP
@@ -0,0 +1,144 @@
+#ifndef DETAILS_STATS_KERNELS_HPP
+#define DETAILS_STATS_KERNELS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+#include "argmax_kernels.hpp"
+#include "sum_kernels.hpp"
+
+namespace utils {
+namespace details {
+/**
+ * @brief Type in which the moments of elements of type T are computed: long
+ * double for long double, double otherwise.
+ */
+template <typename T>
+using stats_accumulator_t =
+    std::conditional_t<(sizeof(T) > sizeof(double)) &&
+                           std::is_floating_point_v<T>,
+                       T, double>;
+
+/**
+ * @brief Returns the sum of the squared deviations of the n elements at data
+ * from mean.
+ *
+ * Element i goes to accumulator i % sum_lanes like in the summation kernels,
+ * which lets the compiler vectorize the loop without reassociating it.
+ */
+template <typename S, typename T>
+S squared_deviation_sum(const T *data, const std::size_t n,
+                        const S mean) noexcept {
+  S acc[sum_lanes]{};
+  std::size_t i{0};
+  for (; i + sum_lanes <= n; i += sum_lanes) {
+    for (std::size_t lane{0}; lane < sum_lanes; ++lane) {
+      const auto deviation{static_cast<S>(data[i + lane]) - mean};
+      acc[lane] += deviation * deviation;
+    }
+  }
+  for (; i < n; ++i) {
+    const auto deviation{static_cast<S>(data[i]) - mean};
+    acc[i % sum_lanes] += deviation * deviation;
+  }
+  for (auto width{sum_lanes / 2}; width; width /= 2) {
+    for (std::size_t lane{0}; lane < width; ++lane) {
+      acc[lane] += acc[lane + width];
+    }
+  }
+  return acc[0];
+}
+
+/**
+ * @brief Returns the smallest ordered element among the n elements at data,
+ * starting from init, which must be ordered. Unordered elements are skipped.
+ *
+ * Each of the sum_lanes lanes keeps a running minimum with a select that maps
+ * to SIMD min instructions.
+ */
+template <typename T>
+T min_ordered(const T *data, const std::size_t n, const T init) noexcept {
+  T lanes[sum_lanes];
+  for (auto &lane : lanes) {
+    lane = init;
+  }
+  std::size_t i{0};
+  for (; i + sum_lanes <= n; i += sum_lanes) {
+    for (std::size_t lane{0}; lane < sum_lanes; ++lane) {
+      const auto value{data[i + lane]};
+      lanes[lane] = value < lanes[lane] ? value : lanes[lane];
+    }
+  }
+  for (; i < n; ++i) {
+    lanes[0] = data[i] < lanes[0] ? data[i] : lanes[0];
+  }
+  auto result{lanes[0]};
+  for (const auto lane : lanes) {
+    result = lane < result ? lane : result;
+  }
+  return result;
+}
+
+/**
+ * @brief Statistics of a block of elements, see block_stats().
+ */
+template <typename T> struct stats_block {
+  stats_accumulator_t<T> mean;
+  stats_accumulator_t<T> m2;
+  // Index of the first maximum among the ordered elements, n if none.
+  std::size_t argmax;
+  T min;
+};
+
+/**
+ * @brief Computes the mean, the sum of squared deviations and the extrema of
+ * the n > 0 elements at data.
+ *
+ * The block is read once from memory and twice from cache: the sum goes
+ * through widened_sum() and the maximum through the argmax kernels, then the
+ * squared deviations from the block mean and the minimum are computed, which
+ * is more accurate than a per element Welford update.
+ */
+template <typename T>
+stats_block<T> block_stats(const T *data, const std::size_t n) noexcept {
+  using S = stats_accumulator_t<T>;
+  stats_block<T> block{};
+  block.mean = static_cast<S>(widened_sum(data, data + n)) / static_cast<S>(n);
+  block.m2 = squared_deviation_sum(data, n, block.mean);
+  block.argmax = argmax_range(data, n);
+  if (block.argmax != n) {
+    block.min = min_ordered(data, n, data[block.argmax]);
+  }
+  return block;
+}
+/**
+ * @brief Returns the leaf function of the reduction tree of stats(): leaf b
+ * is the Stats accumulator of the elements [b * reduce_leaf_size,
+ * (b + 1) * reduce_leaf_size) of the n elements at first.
+ */
+template <typename Stats, typename RandomIt>
+auto stats_leaves(const RandomIt first, const std::size_t n) {
+  return [first, n](const std::size_t b) {
+    const auto begin{b * reduce_leaf_size};
+    Stats leaf{begin};
+    leaf.update(std::next(first, begin), std::next(first, std::min(n, begin + reduce_leaf_size)));
+    return leaf;
+  };
+}
+
+/**
+ * @brief Combine function of the reduction tree of stats(): merges the
+ * accumulators of two consecutive parts of a sequence.
+ */
+struct merge_stats {
+  template <typename Stats> Stats operator()(Stats a, const Stats &b) const noexcept {
+    a.merge(b);
+    return a;
+  }
+};
+} // namespace details
+} // namespace utils
+
+#endif // DETAILS_STATS_KERNELS_HPP
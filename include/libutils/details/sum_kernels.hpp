@@ -0,0 +1,430 @@
+#ifndef DETAILS_SUM_KERNELS_HPP
+#define DETAILS_SUM_KERNELS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <type_traits>
+
+#include "../float16.hpp"
+#include "../type_traits.hpp"
+#include "cpu.hpp"
+#include "tree_reduce.hpp"
+
+namespace utils {
+namespace details {
+template <typename T, typename = void> struct sum_accumulator {
+  using type = T;
+};
+
+template <typename T>
+struct sum_accumulator<T, std::enable_if_t<std::is_integral_v<T>>> {
+  using type = std::conditional_t<std::is_signed_v<T>, std::int64_t,
+                                  std::uint64_t>;
+};
+
+template <typename T>
+struct sum_accumulator<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+  using type = std::conditional_t<(sizeof(T) > sizeof(double)), T, double>;
+};
+
+template <typename T>
+struct sum_accumulator<T, std::enable_if_t<is_narrow_float_v<T>>> {
+  using type = double;
+};
+
+/**
+ * @brief Type in which elements of type T are summed: 64-bit integers for
+ * integral types, at least double for floating point types, float16 and
+ * bfloat16, T otherwise.
+ */
+template <typename T>
+using sum_accumulator_t = typename sum_accumulator<T>::type;
+
+/**
+ * @brief True for the element types summed in sum_accumulator_t by
+ * widened_sum(): arithmetic types, float16 and bfloat16.
+ */
+template <typename T>
+inline constexpr bool has_widened_sum_v =
+    std::is_arithmetic_v<T> || is_narrow_float_v<T>;
+
+/**
+ * @brief True for the element types summed by the pairwise kernels: float,
+ * double, float16 and bfloat16, the last two being widened in registers.
+ */
+template <typename T>
+inline constexpr bool has_sum_kernel_v =
+    std::is_same_v<T, float> || std::is_same_v<T, double> ||
+    is_narrow_float_v<T>;
+
+/**
+ * @brief Number of logical accumulators of the floating point kernels.
+ *
+ * Element i of a block always goes to accumulator i % sum_lanes, whatever the
+ * instruction set, so every kernel performs the same additions in the same
+ * order and the sums are bit-identical across vector widths.
+ */
+inline constexpr std::size_t sum_lanes{16};
+
+/**
+ * @brief Adds [data + i, data + n) to the accumulators, element i going to
+ * acc[i % sum_lanes], then returns their sum in a fixed tree order.
+ */
+template <typename T>
+double sum_lanes_finish(const T *data, std::size_t i, const std::size_t n,
+                        double *acc) noexcept {
+  for (; i < n; ++i) {
+    acc[i % sum_lanes] += static_cast<double>(data[i]);
+  }
+  for (auto width{sum_lanes / 2}; width; width /= 2) {
+    for (std::size_t lane{0}; lane < width; ++lane) {
+      acc[lane] += acc[lane + width];
+    }
+  }
+  return acc[0];
+}
+
+template <typename T>
+double sum_block_scalar(const T *data, const std::size_t n) noexcept {
+  double acc[sum_lanes]{};
+  return sum_lanes_finish(data, 0, n, acc);
+}
+
+#if LIBUTILS_X86_SIMD
+/*
+ * Defines sum_block_<ISA>(data, n) for the types of has_sum_kernel_v. The
+ * sum_lanes accumulators are held in REGS registers of LANES doubles; LOAD_F,
+ * LOAD_D, LOAD_H and LOAD_B load LANES floats, doubles, float16 or bfloat16
+ * values at a pointer as doubles. Every conversion is exact, so the sums do not
+ * depend on the instruction set.
+ */
+#define LIBUTILS_DEFINE_SUM_BLOCK_KERNEL(ISA, TARGET, VEC, LANES, ZERO, ADD,   \
+                                         STORE, LOAD_F, LOAD_D, LOAD_H,        \
+                                         LOAD_B)                               \
+  template <typename T>                                                        \
+  TARGET double sum_block_##ISA(const T *data, const std::size_t n) noexcept { \
+    constexpr std::size_t regs{sum_lanes / LANES};                             \
+    VEC acc[regs];                                                             \
+    for (std::size_t r{0}; r < regs; ++r) {                                    \
+      acc[r] = ZERO();                                                         \
+    }                                                                          \
+    std::size_t i{0};                                                          \
+    for (; i + sum_lanes <= n; i += sum_lanes) {                               \
+      for (std::size_t r{0}; r < regs; ++r) {                                  \
+        if constexpr (std::is_same_v<T, float>) {                              \
+          acc[r] = ADD(acc[r], LOAD_F(data + i + r * LANES));                  \
+        } else if constexpr (std::is_same_v<T, float16>) {                     \
+          acc[r] = ADD(acc[r], LOAD_H(data + i + r * LANES));                  \
+        } else if constexpr (std::is_same_v<T, bfloat16>) {                    \
+          acc[r] = ADD(acc[r], LOAD_B(data + i + r * LANES));                  \
+        } else {                                                               \
+          acc[r] = ADD(acc[r], LOAD_D(data + i + r * LANES));                  \
+        }                                                                      \
+      }                                                                        \
+    }                                                                          \
+    double lanes[sum_lanes];                                                   \
+    for (std::size_t r{0}; r < regs; ++r) {                                    \
+      STORE(lanes + r * LANES, acc[r]);                                        \
+    }                                                                          \
+    return sum_lanes_finish(data, i, n, lanes);                                \
+  }
+
+/**
+ * @brief Loads two floats from p, which need not be aligned, as doubles.
+ *
+ * The 64 bits are read through __m128i, which may alias any type, rather than
+ * through a double.
+ */
+LIBUTILS_TARGET_SSE42 inline __m128d load_float2_sse42(const float *p) noexcept {
+  return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p))));
+}
+
+// SSE4.2 has no F16C, so float16 values are converted one at a time.
+#define LIBUTILS_SSE42_LOAD_H(p)                                               \
+  _mm_set_pd(static_cast<double>((p)[1]), static_cast<double>((p)[0]))
+// A bfloat16 becomes a float when interleaved below a zero half word.
+#define LIBUTILS_SSE42_LOAD_B(p)                                               \
+  _mm_cvtps_pd(_mm_castsi128_ps(                                               \
+      _mm_unpacklo_epi16(_mm_setzero_si128(), _mm_loadu_si32(p))))
+#define LIBUTILS_AVX2_LOAD_F(p) _mm256_cvtps_pd(_mm_loadu_ps(p))
+#define LIBUTILS_AVX2_LOAD_H(p)                                                \
+  _mm256_cvtps_pd(                                                             \
+      _mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p))))
+#define LIBUTILS_AVX2_LOAD_B(p)                                                \
+  _mm256_cvtps_pd(_mm_castsi128_ps(_mm_unpacklo_epi16(                         \
+      _mm_setzero_si128(),                                                     \
+      _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)))))
+#define LIBUTILS_AVX512_LOAD_F(p) _mm512_cvtps_pd(_mm256_loadu_ps(p))
+#define LIBUTILS_AVX512_LOAD_H(p)                                              \
+  _mm512_cvtps_pd(                                                             \
+      _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))))
+#define LIBUTILS_AVX512_LOAD_B(p)                                              \
+  _mm512_cvtps_pd(_mm256_castsi256_ps(_mm256_slli_epi32(                       \
+      _mm256_cvtepu16_epi32(                                                   \
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(p))),              \
+      16)))
+
+LIBUTILS_DEFINE_SUM_BLOCK_KERNEL(sse42, LIBUTILS_TARGET_SSE42, __m128d, 2,
+                                 _mm_setzero_pd, _mm_add_pd, _mm_storeu_pd,
+                                 load_float2_sse42, _mm_loadu_pd,
+                                 LIBUTILS_SSE42_LOAD_H, LIBUTILS_SSE42_LOAD_B)
+LIBUTILS_DEFINE_SUM_BLOCK_KERNEL(avx2, LIBUTILS_TARGET_AVX2, __m256d, 4,
+                                 _mm256_setzero_pd, _mm256_add_pd,
+                                 _mm256_storeu_pd, LIBUTILS_AVX2_LOAD_F,
+                                 _mm256_loadu_pd, LIBUTILS_AVX2_LOAD_H,
+                                 LIBUTILS_AVX2_LOAD_B)
+LIBUTILS_DEFINE_SUM_BLOCK_KERNEL(avx512, LIBUTILS_TARGET_AVX512, __m512d, 8,
+                                 _mm512_setzero_pd, _mm512_add_pd,
+                                 _mm512_storeu_pd, LIBUTILS_AVX512_LOAD_F,
+                                 _mm512_loadu_pd, LIBUTILS_AVX512_LOAD_H,
+                                 LIBUTILS_AVX512_LOAD_B)
+
+#undef LIBUTILS_SSE42_LOAD_H
+#undef LIBUTILS_SSE42_LOAD_B
+#undef LIBUTILS_AVX2_LOAD_F
+#undef LIBUTILS_AVX2_LOAD_H
+#undef LIBUTILS_AVX2_LOAD_B
+#undef LIBUTILS_AVX512_LOAD_F
+#undef LIBUTILS_AVX512_LOAD_H
+#undef LIBUTILS_AVX512_LOAD_B
+#undef LIBUTILS_DEFINE_SUM_BLOCK_KERNEL
+#endif // LIBUTILS_X86_SIMD
+
+/**
+ * @brief Sums at most reduce_leaf_size elements on the best kernel.
+ */
+template <typename T>
+double sum_block(const T *data, const std::size_t n) noexcept {
+#if LIBUTILS_X86_SIMD
+  switch (active_simd_level()) {
+  case simd_level::avx512:
+    return sum_block_avx512(data, n);
+  case simd_level::avx2:
+    return sum_block_avx2(data, n);
+  case simd_level::sse42:
+    return sum_block_sse42(data, n);
+  default:
+    break;
+  }
+#endif
+  return sum_block_scalar(data, n);
+}
+
+/**
+ * @brief Sums the n elements at data in double with the pairwise kernels:
+ * leaves of reduce_leaf_size elements are summed by sum_block() and combined
+ * by tree_reduce().
+ */
+template <typename T>
+double pairwise_sum(const T *data, const std::size_t n) noexcept {
+  if (!n) {
+    return 0.0;
+  }
+  auto leaf{[data, n](const std::size_t b) {
+    const auto begin{b * reduce_leaf_size};
+    return sum_block(data + begin, std::min(reduce_leaf_size, n - begin));
+  }};
+  auto plus{[](const double a, const double b) { return a + b; }};
+  return tree_reduce(0, reduce_leaf_count(n), leaf, plus);
+}
+
+/**
+ * @brief True for the 8-bit integer types summed by the byte kernels.
+ */
+template <typename T>
+inline constexpr bool has_byte_sum_kernel_v =
+    std::is_integral_v<T> && sizeof(T) == 1 && !std::is_same_v<T, bool>;
+
+template <typename T>
+sum_accumulator_t<T> byte_sum_scalar(const T *data, const std::size_t n,
+                                     sum_accumulator_t<T> sum) noexcept {
+  for (std::size_t i{0}; i < n; ++i) {
+    sum += static_cast<sum_accumulator_t<T>>(data[i]);
+  }
+  return sum;
+}
+
+#if LIBUTILS_X86_SIMD
+/*
+ * Defines byte_sum_<ISA>(data, n) for 8-bit integers. SAD against zero adds
+ * groups of eight bytes into 64-bit lanes in one instruction; signed bytes are
+ * first offset by 128 with their sign bit flipped, the offset being removed
+ * from the total.
+ */
+#define LIBUTILS_DEFINE_BYTE_SUM_KERNEL(ISA, TARGET, VEC, BYTES, LOAD, ZERO,   \
+                                        SET1, XOR, ADD, SAD, STORE)            \
+  template <typename T>                                                        \
+  TARGET sum_accumulator_t<T> byte_sum_##ISA(const T *data,                    \
+                                             const std::size_t n) noexcept {   \
+    const auto bias{SET1(static_cast<char>(std::is_signed_v<T> ? 0x80 : 0))};  \
+    auto acc{ZERO()};                                                          \
+    std::size_t i{0};                                                          \
+    for (; i + BYTES <= n; i += BYTES) {                                       \
+      const auto x{XOR(LOAD(reinterpret_cast<const VEC *>(data + i)), bias)};  \
+      acc = ADD(acc, SAD(x, ZERO()));                                          \
+    }                                                                          \
+    std::uint64_t lanes[BYTES / 8];                                            \
+    STORE(reinterpret_cast<VEC *>(lanes), acc);                                \
+    std::uint64_t total{0};                                                    \
+    for (const auto lane : lanes) {                                            \
+      total += lane;                                                           \
+    }                                                                          \
+    auto sum{static_cast<sum_accumulator_t<T>>(total)};                        \
+    if constexpr (std::is_signed_v<T>) {                                       \
+      sum -= static_cast<sum_accumulator_t<T>>(128 * i);                       \
+    }                                                                          \
+    return byte_sum_scalar(data + i, n - i, sum);                              \
+  }
+
+LIBUTILS_DEFINE_BYTE_SUM_KERNEL(sse42, LIBUTILS_TARGET_SSE42, __m128i, 16,
+                                _mm_loadu_si128, _mm_setzero_si128,
+                                _mm_set1_epi8, _mm_xor_si128, _mm_add_epi64,
+                                _mm_sad_epu8, _mm_storeu_si128)
+LIBUTILS_DEFINE_BYTE_SUM_KERNEL(avx2, LIBUTILS_TARGET_AVX2, __m256i, 32,
+                                _mm256_loadu_si256, _mm256_setzero_si256,
+                                _mm256_set1_epi8, _mm256_xor_si256,
+                                _mm256_add_epi64, _mm256_sad_epu8,
+                                _mm256_storeu_si256)
+LIBUTILS_DEFINE_BYTE_SUM_KERNEL(avx512, LIBUTILS_TARGET_AVX512, __m512i, 64,
+                                _mm512_loadu_si512, _mm512_setzero_si512,
+                                _mm512_set1_epi8, _mm512_xor_si512,
+                                _mm512_add_epi64, _mm512_sad_epu8,
+                                _mm512_storeu_si512)
+
+#undef LIBUTILS_DEFINE_BYTE_SUM_KERNEL
+#endif // LIBUTILS_X86_SIMD
+
+/**
+ * @brief Sums the n 8-bit integers at data exactly on the best kernel.
+ */
+template <typename T>
+sum_accumulator_t<T> byte_sum(const T *data, const std::size_t n) noexcept {
+#if LIBUTILS_X86_SIMD
+  switch (active_simd_level()) {
+  case simd_level::avx512:
+    return byte_sum_avx512(data, n);
+  case simd_level::avx2:
+    return byte_sum_avx2(data, n);
+  case simd_level::sse42:
+    return byte_sum_sse42(data, n);
+  default:
+    break;
+  }
+#endif
+  return byte_sum_scalar(data, n, sum_accumulator_t<T>(0));
+}
+
+/**
+ * @brief Sums [first, last) in sum_accumulator_t of its value type.
+ *
+ * Contiguous ranges of the has_sum_kernel_v types use pairwise_sum(), those of
+ * 8-bit integers byte_sum(), other ranges a sequential loop in the widened
+ * type; integer sums are exact as long as they fit 64 bits, so their order
+ * does not matter.
+ */
+template <typename InputIt>
+auto widened_sum(InputIt first, const InputIt last) {
+  using value_type = remove_cvref_t<decltype(*first)>;
+  using accumulator = sum_accumulator_t<value_type>;
+  if constexpr (is_contiguous_iterator_v<InputIt> &&
+                has_sum_kernel_v<value_type>) {
+    const auto n{static_cast<std::size_t>(std::distance(first, last))};
+    return n ? static_cast<accumulator>(pairwise_sum(std::addressof(*first), n))
+             : accumulator(0);
+  } else if constexpr (is_contiguous_iterator_v<InputIt> &&
+                       has_byte_sum_kernel_v<value_type>) {
+    const auto n{static_cast<std::size_t>(std::distance(first, last))};
+    return n ? byte_sum(std::addressof(*first), n) : accumulator(0);
+  } else {
+    accumulator sum(0);
+    for (; first != last; ++first) {
+      sum += static_cast<accumulator>(*first);
+    }
+    return sum;
+  }
+}
+
+/**
+ * @brief Returns the mean as a T from the sum of n arithmetic elements.
+ *
+ * Floating point results are divided in at least double precision, integral
+ * ones in the type of the sum, truncating towards zero.
+ */
+template <typename T, typename S>
+constexpr T mean_from_sum(const S sum, const std::size_t n) {
+  if constexpr (std::is_floating_point_v<T>) {
+    using wide = std::common_type_t<T, double>;
+    return static_cast<T>(static_cast<wide>(sum) / static_cast<wide>(n));
+  } else {
+    return static_cast<T>(sum / static_cast<S>(n));
+  }
+}
+
+/**
+ * @brief Mean of [first, last) as a T. Arithmetic elements are summed with
+ * widened_sum(), other elements are accumulated in T.
+ */
+template <typename T, typename InputIt>
+T mean(InputIt first, const InputIt last) {
+  using value_type = remove_cvref_t<decltype(*first)>;
+  const auto distance{std::distance(first, last)};
+  if (!distance) {
+    return T(0);
+  }
+  if constexpr (has_widened_sum_v<value_type> && has_widened_sum_v<T>) {
+    return mean_from_sum<T>(widened_sum(first, last),
+                            static_cast<std::size_t>(distance));
+  } else {
+    return std::accumulate(first, last, T(0)) / distance;
+  }
+}
+
+/**
+ * @brief Mean of [first, last) as a T, summed by tree_reduce() over leaves of
+ * reduce_leaf_size elements with the threads of the policy.
+ *
+ * Leaves are summed like mean(first, last) sums a whole range, so contiguous
+ * float and double ranges and integral ranges give exactly the same result as
+ * the sequential mean; other ranges give a result that does not depend on the
+ * number of threads.
+ */
+template <typename T, typename RandomIt>
+T mean(const execution::parallel_policy &policy, RandomIt first,
+       const RandomIt last) {
+  using value_type = remove_cvref_t<decltype(*first)>;
+  const auto n{static_cast<std::size_t>(std::distance(first, last))};
+  if (!n) {
+    return T(0);
+  }
+  const auto leaf_range{[first, n](const std::size_t b) {
+    const auto begin{b * reduce_leaf_size};
+    return std::make_pair(std::next(first, begin),
+                          std::next(first, std::min(n, begin + reduce_leaf_size)));
+  }};
+  const auto plus{[](auto a, auto b) { return a + b; }};
+  if constexpr (has_widened_sum_v<value_type> && has_widened_sum_v<T>) {
+    const auto sum{tree_reduce(policy, reduce_leaf_count(n),
+                               [&](const std::size_t b) {
+                                 const auto [begin, end]{leaf_range(b)};
+                                 return widened_sum(begin, end);
+                               },
+                               plus)};
+    return mean_from_sum<T>(sum, n);
+  } else {
+    const auto sum{tree_reduce(policy, reduce_leaf_count(n),
+                               [&](const std::size_t b) {
+                                 const auto [begin, end]{leaf_range(b)};
+                                 return std::accumulate(begin, end, T(0));
+                               },
+                               plus)};
+    return sum / static_cast<std::ptrdiff_t>(n);
+  }
+}
+} // namespace details
+} // namespace utils
+
+#endif // DETAILS_SUM_KERNELS_HPP
@@ -0,0 +1,121 @@
+#ifndef DETAILS_TOPK_HPP
+#define DETAILS_TOPK_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace utils {
+namespace details {
+/**
+ * @brief Returns true if (a, i) ranks before (b, j): a greater value, or an
+ * equal value at a lower index, as in argmax().
+ */
+template <typename T>
+bool ranks_before(const T &a, const std::size_t i, const T &b,
+                  const std::size_t j) {
+  return b < a || (!(a < b) && i < j);
+}
+
+/**
+ * @brief Bounded heap keeping the k best (value, index) pairs pushed so far.
+ *
+ * Indices must be pushed in increasing order: a new element then only enters
+ * a full heap if its value is strictly greater than the worst kept value,
+ * which is exposed as threshold() for pre-filtering.
+ */
+template <typename T> class topk_heap {
+public:
+  explicit topk_heap(const std::size_t k) : k_{k} { entries_.reserve(k); }
+
+  bool full() const noexcept { return entries_.size() == k_; }
+
+  const T &threshold() const noexcept { return entries_.front().first; }
+
+  void push(const T &value, const std::size_t index) {
+    if (!full()) {
+      entries_.emplace_back(value, index);
+      std::push_heap(entries_.begin(), entries_.end(), compare);
+      return;
+    }
+    if (!(threshold() < value)) {
+      return;
+    }
+    std::pop_heap(entries_.begin(), entries_.end(), compare);
+    entries_.back() = {value, index};
+    std::push_heap(entries_.begin(), entries_.end(), compare);
+  }
+
+  template <typename OutputIt>
+  OutputIt write(OutputIt d_first, const bool sorted) {
+    if (sorted) {
+      std::sort_heap(entries_.begin(), entries_.end(), compare);
+    }
+    return std::transform(entries_.begin(), entries_.end(), d_first,
+                          [](const auto &entry) { return entry.second; });
+  }
+
+private:
+  // The heap top is the entry ranking last.
+  static bool compare(const std::pair<T, std::size_t> &a,
+                      const std::pair<T, std::size_t> &b) {
+    return ranks_before(a.first, a.second, b.first, b.second);
+  }
+
+  std::size_t k_;
+  std::vector<std::pair<T, std::size_t>> entries_;
+};
+
+/**
+ * @brief Writes the k best of the given candidate indices into d_first using
+ * std::nth_element, sorting them by rank if requested.
+ */
+template <typename RandomIt, typename Index, typename OutputIt>
+OutputIt topk_select(RandomIt first, std::vector<Index> &indices,
+                     std::size_t k, OutputIt d_first, const bool sorted) {
+  k = std::min(k, indices.size());
+  const auto compare{[first](const Index i, const Index j) {
+    return ranks_before(first[i], i, first[j], j);
+  }};
+  const auto middle{indices.begin() + static_cast<std::ptrdiff_t>(k)};
+  if (k && k < indices.size()) {
+    std::nth_element(indices.begin(), middle - 1, indices.end(), compare);
+  }
+  if (sorted) {
+    std::sort(indices.begin(), middle, compare);
+  }
+  return std::transform(indices.begin(), middle, d_first, [](const Index i) {
+    return static_cast<std::size_t>(i);
+  });
+}
+
+/**
+ * @brief Collects the indices in [0, n) accepted by eligible and forwards them
+ * to topk_select(), using 32-bit indices when n allows it.
+ */
+template <typename RandomIt, typename OutputIt, typename Eligible>
+OutputIt topk_select_if(RandomIt first, const std::size_t n,
+                        const std::size_t k, OutputIt d_first,
+                        const bool sorted, Eligible eligible) {
+  const auto run{[&](auto index_tag) {
+    using Index = decltype(index_tag);
+    std::vector<Index> indices;
+    indices.reserve(n);
+    for (std::size_t i{0}; i < n; ++i) {
+      if (eligible(i)) {
+        indices.push_back(static_cast<Index>(i));
+      }
+    }
+    return topk_select(first, indices, k, d_first, sorted);
+  }};
+  if (n <= std::size_t{0xFFFFFFFF}) {
+    return run(std::uint32_t{});
+  }
+  return run(std::size_t{});
+}
+} // namespace details
+} // namespace utils
+
+#endif // DETAILS_TOPK_HPP
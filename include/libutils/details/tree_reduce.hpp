@@ -0,0 +1,142 @@
+#ifndef DETAILS_TREE_REDUCE_HPP
+#define DETAILS_TREE_REDUCE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "../execution.hpp"
+#include "../utility.hpp"
+
+namespace utils {
+namespace details {
+/**
+ * @brief Number of elements per leaf of the reduction trees of product and
+ * mean. It never depends on the policy, so neither do the results.
+ */
+inline constexpr std::size_t reduce_leaf_size{2048};
+
+/**
+ * @brief Returns the number of leaves of reduce_leaf_size elements covering n
+ * elements.
+ */
+constexpr std::size_t reduce_leaf_count(const std::size_t n) noexcept {
+  return (n + reduce_leaf_size - 1) / reduce_leaf_size;
+}
+
+/**
+ * @brief Reduces the leaves [first, last) pairwise: both halves are reduced
+ * recursively, left before right, and combined with combine(left, right).
+ *
+ * The tree only depends on the number of leaves, so the result does too.
+ */
+template <typename Leaf, typename Combine>
+auto tree_reduce(const std::size_t first, const std::size_t last, Leaf &leaf,
+                 Combine &combine) {
+  if (last - first == 1) {
+    return leaf(first);
+  }
+  const auto middle{first + (last - first) / 2};
+  auto left{tree_reduce(first, middle, leaf, combine)};
+  return combine(std::move(left), tree_reduce(middle, last, leaf, combine));
+}
+
+/**
+ * @brief Appends to nodes the subtrees of [first, last) that have at most
+ * cutoff leaves, from left to right.
+ */
+inline void tree_reduce_nodes(
+    const std::size_t first, const std::size_t last, const std::size_t cutoff,
+    std::vector<std::pair<std::size_t, std::size_t>> &nodes) {
+  if (last - first <= cutoff) {
+    nodes.emplace_back(first, last);
+    return;
+  }
+  const auto middle{first + (last - first) / 2};
+  tree_reduce_nodes(first, middle, cutoff, nodes);
+  tree_reduce_nodes(middle, last, cutoff, nodes);
+}
+
+/**
+ * @brief Combines the subtree results produced for tree_reduce_nodes() into
+ * the result of [first, last), consuming them from next.
+ */
+template <typename R, typename Combine>
+R tree_reduce_combine(const std::size_t first, const std::size_t last,
+                      const std::size_t cutoff,
+                      std::vector<std::optional<R>> &results,
+                      std::size_t &next, Combine &combine) {
+  if (last - first <= cutoff) {
+    return std::move(*results[next++]);
+  }
+  const auto middle{first + (last - first) / 2};
+  auto left{
+      tree_reduce_combine(first, middle, cutoff, results, next, combine)};
+  return combine(std::move(left), tree_reduce_combine(middle, last, cutoff,
+                                                      results, next, combine));
+}
+
+/**
+ * @brief Reduces the leaves [0, leaves) with the threads of the policy.
+ *
+ * The subtrees below the chunk size of the policy are reduced in parallel and
+ * then combined on the calling thread along the same tree, so the result is
+ * bit-identical to tree_reduce(0, leaves, leaf, combine) whatever the number
+ * of threads or the grain size.
+ *
+ * @param leaves Number of leaves, at least 1.
+ */
+template <typename Leaf, typename Combine>
+auto tree_reduce(const execution::parallel_policy &policy,
+                 const std::size_t leaves, Leaf leaf, Combine combine) {
+  using result_type = decltype(leaf(std::size_t{0}));
+  const auto cutoff{std::max<std::size_t>(
+      1, chunk_size(policy, leaves * reduce_leaf_size, reduce_leaf_size) /
+             reduce_leaf_size)};
+  std::vector<std::pair<std::size_t, std::size_t>> nodes;
+  tree_reduce_nodes(0, leaves, cutoff, nodes);
+  std::vector<std::optional<result_type>> results(nodes.size());
+  parallel_for(policy, nodes.size(), [&](const std::size_t task) {
+    results[task].emplace(
+        tree_reduce(nodes[task].first, nodes[task].second, leaf, combine));
+  });
+  std::size_t next{0};
+  return tree_reduce_combine(std::size_t{0}, leaves, cutoff, results, next,
+                             combine);
+}
+
+/**
+ * @brief Reduces the first Width lanes of values with op, at compile time if
+ * possible.
+ *
+ * Each step combines the adjacent lanes 2i and 2i + 1 into lane i, carrying
+ * an odd last lane forward, unrolled with constexpr_for, so the reduction of
+ * N lanes is a tree of depth ceil(log2(N)) whose steps are independent
+ * operations. Operands are regrouped but never reordered, so op need not be
+ * commutative.
+ *
+ * @param values The lanes, overwritten by partial results. Width must be at
+ * least 1.
+ */
+template <std::size_t Width, typename T, std::size_t N, typename Op>
+constexpr T fold_lanes(std::array<T, N> &values, Op &op) {
+  if constexpr (Width == 1) {
+    return values[0];
+  } else {
+    constexpr std::size_t half{Width / 2};
+    constexpr_for<std::size_t{0}, half, std::size_t{1}>([&](const auto i) {
+      values[i] = op(values[2 * i], values[2 * i + 1]);
+    });
+    if constexpr (Width % 2) {
+      values[half] = values[Width - 1];
+    }
+    return fold_lanes<Width - half>(values, op);
+  }
+}
+} // namespace details
+} // namespace utils
+
+#endif // DETAILS_TREE_REDUCE_HPP
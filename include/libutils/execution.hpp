@@ -0,0 +1,181 @@
+#ifndef EXECUTION_HPP
+#define EXECUTION_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace utils {
+namespace execution {
+/**
+ * @brief Execution policy requesting that an algorithm runs on the calling
+ * thread only.
+ */
+struct sequenced_policy {};
+
+/**
+ * @brief Execution policy requesting that an algorithm splits its range into
+ * chunks processed by several threads.
+ *
+ * Chunk results are always merged in an order that only depends on the input
+ * and at most on the grain size, so algorithms taking this policy are
+ * deterministic: they return the same result whatever the number of threads.
+ * They return the same result as their sequential counterparts only where
+ * their documentation says so; floating point reductions and scans may differ
+ * from them in the last bits.
+ */
+class parallel_policy {
+public:
+  constexpr parallel_policy() noexcept = default;
+
+  /**
+   * @brief Constructs a policy with an explicit thread count and grain size.
+   *
+   * @param threads Number of threads to use, 0 means
+   * std::thread::hardware_concurrency().
+   * @param grain_size Number of elements per chunk, 0 lets the algorithm
+   * decide.
+   */
+  explicit constexpr parallel_policy(const std::size_t threads,
+                                     const std::size_t grain_size = 0) noexcept
+      : threads_{threads}, grain_size_{grain_size} {}
+
+  /**
+   * @brief Returns the number of threads to use, always at least 1.
+   */
+  std::size_t threads() const noexcept {
+    if (threads_) {
+      return threads_;
+    }
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  /**
+   * @brief Returns the requested number of elements per chunk, 0 if the
+   * algorithm should decide.
+   */
+  constexpr std::size_t grain_size() const noexcept { return grain_size_; }
+
+private:
+  std::size_t threads_{0};
+  std::size_t grain_size_{0};
+};
+
+/**
+ * @brief Instance of sequenced_policy.
+ */
+inline constexpr sequenced_policy seq{};
+
+/**
+ * @brief Instance of parallel_policy using all hardware threads.
+ */
+inline constexpr parallel_policy par{};
+
+/** @defgroup is_execution_policy_struct IsExecutionPolicy
+ * @{
+ */
+
+/**
+ * @brief Trait to check if a type is one of the library's execution policies.
+ *
+ * @tparam T The type to check.
+ */
+template <typename T> struct is_execution_policy : std::false_type {};
+
+template <> struct is_execution_policy<sequenced_policy> : std::true_type {};
+
+template <> struct is_execution_policy<parallel_policy> : std::true_type {};
+
+/**
+ * @brief Helper variable template for is_execution_policy.
+ *
+ * @tparam T The type to check.
+ */
+template <typename T>
+inline constexpr bool is_execution_policy_v = is_execution_policy<T>::value;
+
+/** @} */ // end of is_execution_policy_struct
+} // namespace execution
+
+namespace details {
+/**
+ * @brief Returns the number of elements per chunk when splitting n elements
+ * for the given policy.
+ *
+ * Unless the policy fixes the grain size, about four chunks per thread are
+ * used, but never fewer than min_grain elements per chunk.
+ */
+inline std::size_t chunk_size(const execution::parallel_policy &policy,
+                              const std::size_t n,
+                              const std::size_t min_grain) noexcept {
+  if (policy.grain_size()) {
+    return policy.grain_size();
+  }
+  const auto chunks{policy.threads() * 4};
+  return std::max(min_grain, (n + chunks - 1) / chunks);
+}
+
+/**
+ * @brief Calls f(task) for every task in [0, tasks) using the threads of the
+ * policy.
+ *
+ * Tasks are handed out in increasing order through an atomic counter and the
+ * calling thread takes part in the work. If a task throws, no new tasks are
+ * started and the first exception is rethrown once all threads have joined.
+ */
+template <typename F>
+void parallel_for(const execution::parallel_policy &policy,
+                  const std::size_t tasks, F &&f) {
+  const auto threads{std::min(policy.threads(), tasks)};
+  if (threads <= 1) {
+    for (std::size_t task{0}; task < tasks; ++task) {
+      f(task);
+    }
+    return;
+  }
+
+  std::atomic<std::size_t> next{0};
+  std::atomic<bool> failed{false};
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  auto worker{[&] {
+    try {
+      for (auto task{next++}; task < tasks && !failed; task = next++) {
+        f(task);
+      }
+    } catch (...) {
+      std::lock_guard lock{error_mutex};
+      if (!error) {
+        error = std::current_exception();
+      }
+      failed = true;
+    }
+  }};
+
+  std::vector<std::thread> pool;
+  pool.reserve(threads - 1);
+  try {
+    for (std::size_t i{1}; i < threads; ++i) {
+      pool.emplace_back(worker);
+    }
+  } catch (const std::system_error &) {
+    // Continue with the threads that could be started.
+  }
+  worker();
+  for (auto &thread : pool) {
+    thread.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+} // namespace details
+} // namespace utils
+
+#endif // EXECUTION_HPP
@@ -1,10 +1,302 @@
 #ifndef FILES_HPP
 #define FILES_HPP
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "details/directory_walker.hpp"
+#include "details/dirent_reader.hpp"
+#include "details/inotify.hpp"
+#include "execution.hpp"
 #include "type_traits.hpp"
 
 namespace utils {
+/**
+ * Entry of a directory as reported by the kernel when listing the directory, without its path.
+ */
+struct directory_record {
+  /**
+   * Name of the entry in its directory. It points into the directory_listing holding the record.
+   */
+  std::string_view name;
+
+  /**
+   * Type of the entry, not following symbolic links. It comes from the listing itself; only on file systems that
+   * do not report types when listing directories is the entry looked up with lstat, and the type is
+   * std::filesystem::file_type::unknown if that fails.
+   */
+  std::filesystem::file_type type;
+
+  /**
+   * Inode number of the entry, 0 if not available.
+   */
+  std::uint64_t inode;
+
+  /**
+   * Returns true if the entry is a regular file. Unlike std::filesystem::directory_entry::is_regular_file(), symbolic
+   * links are not followed, as with lstat: a symbolic link to a regular file is a symbolic link.
+   */
+  bool is_regular_file() const noexcept { return type == std::filesystem::file_type::regular; }
+
+  /**
+   * Returns true if the entry is a directory. Unlike std::filesystem::directory_entry::is_directory(), symbolic links
+   * are not followed, as with lstat: a symbolic link to a directory is a symbolic link.
+   */
+  bool is_directory() const noexcept { return type == std::filesystem::file_type::directory; }
+
+  /**
+   * Returns true if the entry is a symbolic link, whatever it points to.
+   */
+  bool is_symlink() const noexcept { return type == std::filesystem::file_type::symlink; }
+
+  /**
+   * Returns the extension of the name, from its last dot, or an empty view if it has none, following
+   * std::filesystem::path::extension(): ".profile" has no extension.
+   */
+  std::string_view extension() const noexcept {
+    const auto dot{name.rfind('.')};
+    if (dot == std::string_view::npos || dot == 0 || name == "..") {
+      return {};
+    }
+    return name.substr(dot);
+  }
+};
+
+/**
+ * Filters evaluated on directory records, from the data returned by listing the directory, without a stat per
+ * entry. They are passed to read_directory_if, with or without directory_records, and combined with &&, || and !.
+ */
+namespace filters {
+/**
+ * Base of the filters, by which read_directory_if recognizes them.
+ */
+struct entry_filter {};
+
+/**
+ * Keeps the entries of a given type, symbolic links not being followed: a symbolic link to a regular file only
+ * passes a filter for file_type::symlink.
+ */
+struct type_filter : entry_filter {
+  explicit type_filter(const std::filesystem::file_type type) noexcept : type{type} {}
+  bool operator()(const directory_record &record) const noexcept { return record.type == type; }
+
+  std::filesystem::file_type type;
+};
+
+/**
+ * Keeps the entries whose name has a given extension, dot included, compared case sensitively.
+ */
+struct extension_filter : entry_filter {
+  explicit extension_filter(std::string extension) : extension{std::move(extension)} {}
+  bool operator()(const directory_record &record) const noexcept { return record.extension() == extension; }
+
+  std::string extension;
+};
+
+/**
+ * Keeps the entries whose name starts with a given prefix.
+ */
+struct prefix_filter : entry_filter {
+  explicit prefix_filter(std::string prefix) : prefix{std::move(prefix)} {}
+  bool operator()(const directory_record &record) const noexcept {
+    return record.name.substr(0, prefix.size()) == prefix;
+  }
+
+  std::string prefix;
+};
+
+/**
+ * Keeps the entries kept by both filters.
+ */
+template <typename F, typename G> struct and_filter : entry_filter {
+  and_filter(F f, G g) : f{std::move(f)}, g{std::move(g)} {}
+  bool operator()(const directory_record &record) const { return f(record) && g(record); }
+
+  F f;
+  G g;
+};
+
+/**
+ * Keeps the entries kept by either filter.
+ */
+template <typename F, typename G> struct or_filter : entry_filter {
+  or_filter(F f, G g) : f{std::move(f)}, g{std::move(g)} {}
+  bool operator()(const directory_record &record) const { return f(record) || g(record); }
+
+  F f;
+  G g;
+};
+
+/**
+ * Keeps the entries rejected by a filter.
+ */
+template <typename F> struct not_filter : entry_filter {
+  explicit not_filter(F f) : f{std::move(f)} {}
+  bool operator()(const directory_record &record) const { return !f(record); }
+
+  F f;
+};
+
+/**
+ * Returns a filter keeping the entries of a given type.
+ */
+inline type_filter type(const std::filesystem::file_type type) noexcept { return type_filter{type}; }
+
+/**
+ * Returns a filter keeping the regular files.
+ */
+inline type_filter regular_files() noexcept { return type_filter{std::filesystem::file_type::regular}; }
+
+/**
+ * Returns a filter keeping the directories.
+ */
+inline type_filter directories() noexcept { return type_filter{std::filesystem::file_type::directory}; }
+
+/**
+ * Returns a filter keeping the entries with a given extension, such as ".txt".
+ */
+inline extension_filter extension(std::string extension) { return extension_filter{std::move(extension)}; }
+
+/**
+ * Returns a filter keeping the entries whose name starts with a given prefix.
+ */
+inline prefix_filter name_prefix(std::string prefix) { return prefix_filter{std::move(prefix)}; }
+
+/**
+ * Returns a filter keeping the entries kept by both f and g.
+ */
+template <typename F, typename G,
+          typename = std::enable_if_t<std::is_base_of_v<entry_filter, F> && std::is_base_of_v<entry_filter, G>>>
+and_filter<F, G> operator&&(F f, G g) {
+  return and_filter<F, G>{std::move(f), std::move(g)};
+}
+
+/**
+ * Returns a filter keeping the entries kept by f or g.
+ */
+template <typename F, typename G,
+          typename = std::enable_if_t<std::is_base_of_v<entry_filter, F> && std::is_base_of_v<entry_filter, G>>>
+or_filter<F, G> operator||(F f, G g) {
+  return or_filter<F, G>{std::move(f), std::move(g)};
+}
+
+/**
+ * Returns a filter keeping the entries rejected by f.
+ */
+template <typename F, typename = std::enable_if_t<std::is_base_of_v<entry_filter, F>>>
+not_filter<F> operator!(F f) {
+  return not_filter<F>{std::move(f)};
+}
+} // namespace filters
+
+/** @defgroup is_entry_filter_struct IsEntryFilter
+ * @{
+ */
+
+/**
+ * @brief Checks whether T is one of the filters of the filters namespace.
+ *
+ * @tparam T The type to check.
+ */
+template <typename T>
+struct is_entry_filter : std::is_base_of<filters::entry_filter, remove_cvref_t<T>> {};
+
+/**
+ * @brief Helper variable template for is_entry_filter.
+ *
+ * @tparam T The type to check.
+ */
+template <typename T>
+inline constexpr bool is_entry_filter_v = is_entry_filter<T>::value;
+
+/** @} */
+
+/**
+ * Entries of a directory read without constructing paths.
+ *
+ * On Linux the entries are read with the getdents64 system call into blocks of 256 KiB that the listing keeps,
+ * and the names of the records point into these blocks: listing a directory allocates memory per block rather
+ * than per entry. Elsewhere the entries are read with std::filesystem::directory_iterator and their names are
+ * copied into blocks. Moving a listing keeps its records valid.
+ */
+class directory_listing {
+public:
+  using value_type = directory_record;
+  using const_iterator = std::vector<directory_record>::const_iterator;
+  using iterator = const_iterator;
+  using size_type = std::size_t;
+
+  /**
+   * Reads the entries of a directory, except . and .., that satisfy a given predicate.
+   *
+   * @tparam UnaryPred Type of the unary predicate.
+   * @param path Path to the directory to be read.
+   * @param p Unary predicate taking a const directory_record & that returns true for the entries to be kept.
+   *
+   * @throws std::filesystem::filesystem_error if the directory cannot be read.
+   */
+  template <typename UnaryPred>
+  directory_listing(const std::string &path, UnaryPred p) : directory_{path} {
+    auto keep{[this, &p](const std::string_view name, const std::filesystem::file_type type,
+                         const std::uint64_t inode) {
+      const directory_record record{name, type, inode};
+      if (!p(record)) {
+        return false;
+      }
+      records_.push_back(record);
+      return true;
+    }};
+    details::read_dirents(path, blocks_, keep);
+  }
+
+  directory_listing(directory_listing &&) noexcept = default;
+  directory_listing &operator=(directory_listing &&) noexcept = default;
+
+  /**
+   * Returns the path of the directory that was read.
+   */
+  const std::filesystem::path &directory() const noexcept { return directory_; }
+
+  /**
+   * Returns the path of an entry of the listing, constructed on demand.
+   */
+  std::filesystem::path path(const directory_record &record) const { return directory_ / record.name; }
+
+  const_iterator begin() const noexcept { return records_.begin(); }
+  const_iterator end() const noexcept { return records_.end(); }
+  size_type size() const noexcept { return records_.size(); }
+  bool empty() const noexcept { return records_.empty(); }
+  const directory_record &operator[](const size_type i) const noexcept { return records_[i]; }
+
+private:
+  std::filesystem::path directory_;
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  std::vector<directory_record> records_;
+};
+
+/**
+ * Tag selecting the overloads of read_directory and read_directory_if that return a directory_listing.
+ */
+struct directory_records_t {};
+
+/**
+ * Instance of directory_records_t.
+ */
+inline constexpr directory_records_t directory_records{};
 
 /**
  * Reads the contents of a directory and copies the paths to an output iterator.
@@ -32,7 +324,12 @@ OutputIt read_directory(const std::string &path, OutputIt first) {
  * @tparam UnaryPred Type of the unary predicate.
  * @param path Path to the directory to be read.
  * @param first Output iterator to which the directory contents will be copied.
- * @param p Unary predicate that returns true for the elements to be copied.
+ * @param p Unary predicate that returns true for the elements to be copied. If it is one of the filters of the
+ * filters namespace, it is evaluated on the directory records, without a stat per entry, and only the paths of the
+ * kept entries are constructed. Types are then those of lstat: unlike a predicate calling
+ * std::filesystem::directory_entry::is_regular_file(), filters::regular_files() does not keep symbolic links to
+ * regular files. Paths are written if the output iterator accepts them, otherwise std::filesystem::directory_entry
+ * objects, whose construction queries the status of the kept entries.
  * @return Output iterator pointing to the end of the copied range.
  *
  * @throws std::filesystem::filesystem_error if the directory cannot be read. For some compilers, this exception may not
@@ -42,8 +339,25 @@ template <typename OutputIt, typename UnaryPred>
 OutputIt read_directory_if(const std::string &path, OutputIt first,
                            UnaryPred p) {
   namespace fs = std::filesystem;
-  auto dir_iter{fs::directory_iterator{path}};
-  return std::copy_if(dir_iter, fs::directory_iterator{}, first, p);
+  if constexpr (is_entry_filter_v<UnaryPred>) {
+    const fs::path directory{path};
+    std::vector<std::unique_ptr<char[]>> blocks;
+    auto keep{[&](const std::string_view name, const fs::file_type type, const std::uint64_t inode) {
+      if (p(directory_record{name, type, inode})) {
+        if constexpr (std::is_assignable_v<decltype(*first), fs::path>) {
+          *first++ = directory / name;
+        } else {
+          *first++ = fs::directory_entry{directory / name};
+        }
+      }
+      return false;
+    }};
+    details::read_dirents(path, blocks, keep);
+    return first;
+  } else {
+    auto dir_iter{fs::directory_iterator{path}};
+    return std::copy_if(dir_iter, fs::directory_iterator{}, first, p);
+  }
 }
 
 /**
@@ -71,7 +385,9 @@ Container read_directory(const std::string &directory) {
  * Defaults to std::vector<std::filesystem::path>.
  * @tparam UnaryPred Type of the unary predicate.
  * @param path Path to the directory to be read.
- * @param p Unary predicate that returns true for the elements to be copied.
+ * @param p Unary predicate that returns true for the elements to be copied. If it is one of the filters of the
+ * filters namespace, it is evaluated on the directory records, without a stat per entry and without following
+ * symbolic links.
  * @return A container with the paths of the directory contents that satisfy the
  * predicate.
  *
@@ -83,16 +399,698 @@ template <typename Container = std::vector<std::filesystem::path>,
 Container read_directory_if(const std::string &path, UnaryPred p) {
   namespace fs = std::filesystem;
   Container result;
-  auto dir_iter{fs::directory_iterator{path}};
-  if constexpr (has_insert<Container>::value) {
-    std::copy_if(dir_iter, fs::directory_iterator{},
-                 std::inserter(result, result.end()), p);
-    return result;
+  if constexpr (is_entry_filter_v<UnaryPred>) {
+    if constexpr (has_push_back_v<Container>) {
+      read_directory_if(path, std::back_inserter(result), p);
+    } else {
+      read_directory_if(path, std::inserter(result, result.end()), p);
+    }
+  } else {
+    auto dir_iter{fs::directory_iterator{path}};
+    if constexpr (has_insert<Container>::value) {
+      std::copy_if(dir_iter, fs::directory_iterator{},
+                   std::inserter(result, result.end()), p);
+      return result;
+    }
+    std::copy_if(dir_iter, fs::directory_iterator{}, std::back_inserter(result),
+                 p);
   }
-  std::copy_if(dir_iter, fs::directory_iterator{}, std::back_inserter(result),
-               p);
   return result;
 }
+
+/**
+ * Reads the contents of a directory as records, without constructing paths.
+ *
+ * @param path Path to the directory to be read.
+ * @return A directory_listing with a record for every entry of the directory, except . and .., in the order
+ * the kernel returned them.
+ *
+ * @throws std::filesystem::filesystem_error if the directory cannot be read.
+ */
+inline directory_listing read_directory(const std::string &path, directory_records_t) {
+  return directory_listing(path, [](const directory_record &) { return true; });
+}
+
+/**
+ * Reads the contents of a directory as records, without constructing paths, and keeps those that satisfy a
+ * given predicate.
+ *
+ * @tparam UnaryPred Type of the unary predicate.
+ * @param path Path to the directory to be read.
+ * @param p Unary predicate taking a const directory_record & that returns true for the records to be kept.
+ * @return A directory_listing with the records that satisfy the predicate.
+ *
+ * @throws std::filesystem::filesystem_error if the directory cannot be read.
+ */
+template <typename UnaryPred>
+directory_listing read_directory_if(const std::string &path, directory_records_t, UnaryPred p) {
+  return directory_listing(path, p);
+}
+
+/**
+ * Default number of paths in the batches of directory_batch_reader and read_directory_batched.
+ */
+inline constexpr std::size_t default_directory_batch_size{1024};
+
+/**
+ * Pull-based reader of the paths in a directory, in batches of at most a fixed size, as they are read.
+ *
+ * Unlike read_directory, which returns once the whole directory is listed, each call to next() reads only as
+ * much of the directory as the batch needs, so that the first batch is available at once and processing can
+ * overlap with listing, for instance by handing batches to other threads. The memory used is bounded by one batch
+ * and, on Linux, one 256 KiB block of directory entries, whatever the size of the directory. Entries come in the
+ * order the kernel returns them; entries created or deleted while the directory is read may or may not be seen.
+ */
+class directory_batch_reader {
+public:
+  /**
+   * Opens a directory for reading.
+   *
+   * @param path Path to the directory to be read.
+   * @param batch_size Maximum number of paths in a batch, at least 1.
+   *
+   * @throws std::filesystem::filesystem_error if the directory cannot be opened.
+   */
+  explicit directory_batch_reader(const std::string &path,
+                                  const std::size_t batch_size = default_directory_batch_size)
+      : directory_{path}, batch_size_{std::max(batch_size, std::size_t{1})}, stream_{path} {}
+
+  /**
+   * Returns the path of the directory being read.
+   */
+  const std::filesystem::path &directory() const noexcept { return directory_; }
+
+  /**
+   * Returns the maximum number of paths in a batch.
+   */
+  std::size_t batch_size() const noexcept { return batch_size_; }
+
+  /**
+   * Replaces the contents of batch with the paths of the next entries, except . and .., keeping its capacity.
+   *
+   * @param batch Vector receiving at most batch_size() paths.
+   * @return false, with batch empty, once every entry has been read.
+   *
+   * @throws std::filesystem::filesystem_error if the directory cannot be read.
+   */
+  bool next(std::vector<std::filesystem::path> &batch) {
+    return next(batch, [](const directory_record &) { return true; });
+  }
+
+  /**
+   * Replaces the contents of batch with the paths of the next entries, except . and .., that satisfy a given
+   * predicate, keeping its capacity.
+   *
+   * @tparam UnaryPred Type of the unary predicate.
+   * @param batch Vector receiving at most batch_size() paths.
+   * @param p Unary predicate taking a const directory_record &, such as the filters of the filters namespace,
+   * that returns true for the entries to be kept.
+   * @return false, with batch empty, once every entry has been read.
+   *
+   * @throws std::filesystem::filesystem_error if the directory cannot be read.
+   */
+  template <typename UnaryPred>
+  bool next(std::vector<std::filesystem::path> &batch, UnaryPred p) {
+    batch.clear();
+    auto add{[&](const std::string_view name, const std::filesystem::file_type type, const std::uint64_t inode) {
+      if (p(directory_record{name, type, inode})) {
+        batch.push_back(directory_ / name);
+      }
+    }};
+    while (batch.size() < batch_size_ && stream_.next(add)) {
+    }
+    return !batch.empty();
+  }
+
+private:
+  std::filesystem::path directory_;
+  std::size_t batch_size_;
+  details::dirent_stream stream_;
+};
+
+/**
+ * Reads the contents of a directory in batches of the paths that satisfy a given predicate and passes each batch
+ * to a sink as soon as it is full.
+ *
+ * @tparam UnaryPred Type of the unary predicate.
+ * @tparam Sink Type of the sink.
+ * @param path Path to the directory to be read.
+ * @param batch_size Maximum number of paths in a batch, at least 1.
+ * @param p Unary predicate taking a const directory_record &, such as the filters of the filters namespace, that
+ * returns true for the entries to be kept.
+ * @param sink Callable taking a std::vector<std::filesystem::path> &, which it may move from. If it returns bool,
+ * returning false stops the reading.
+ *
+ * @throws std::filesystem::filesystem_error if the directory cannot be read.
+ */
+template <typename UnaryPred, typename Sink>
+void read_directory_batched_if(const std::string &path, const std::size_t batch_size, UnaryPred p, Sink sink) {
+  directory_batch_reader reader{path, batch_size};
+  std::vector<std::filesystem::path> batch;
+  while (reader.next(batch, p)) {
+    if constexpr (std::is_same_v<decltype(sink(batch)), bool>) {
+      if (!sink(batch)) {
+        return;
+      }
+    } else {
+      sink(batch);
+    }
+  }
+}
+
+/**
+ * Reads the contents of a directory in batches and passes each batch to a sink as soon as it is full.
+ *
+ * @tparam Sink Type of the sink.
+ * @param path Path to the directory to be read.
+ * @param batch_size Maximum number of paths in a batch, at least 1.
+ * @param sink Callable taking a std::vector<std::filesystem::path> &, which it may move from. If it returns bool,
+ * returning false stops the reading.
+ *
+ * @throws std::filesystem::filesystem_error if the directory cannot be read.
+ */
+template <typename Sink>
+void read_directory_batched(const std::string &path, const std::size_t batch_size, Sink sink) {
+  read_directory_batched_if(path, batch_size, [](const directory_record &) { return true; }, sink);
+}
+
+/**
+ * Depth limit of the recursive listings under which every level is visited.
+ */
+inline constexpr std::size_t unlimited_depth{std::numeric_limits<std::size_t>::max()};
+
+/**
+ * Reads the contents of a directory and of its subdirectories, using an execution policy, and copies the
+ * entries that satisfy a given predicate to an output iterator.
+ *
+ * With execution::parallel_policy the subdirectories are spread over the threads of the policy: each thread
+ * lists the directories it discovers depth first and idle threads steal the shallowest pending directories of
+ * the others. Symbolic links to directories are listed but not followed.
+ *
+ * @tparam ExecutionPolicy execution::sequenced_policy or execution::parallel_policy.
+ * @tparam OutputIt Type of the output iterator.
+ * @tparam UnaryPred Type of the unary predicate.
+ * @tparam PrunePred Type of the pruning predicate.
+ * @param policy The execution policy to use.
+ * @param path Path to the directory to be read.
+ * @param first Output iterator to which the directory entries will be copied.
+ * @param p Unary predicate that returns true for the entries to be copied.
+ * @param prune Unary predicate that returns true for the subdirectories whose contents must not be read. By
+ * default no subdirectory is pruned.
+ * @param max_depth Maximum depth of the entries to be read, the entries of path having depth 0. By default
+ * every level is read.
+ * @param options Options of the directory iterators. With skip_permission_denied, the directories that cannot be
+ * read for lack of permission are skipped, with their subtrees, instead of stopping the walk.
+ * @return Output iterator pointing to the end of the copied range.
+ *
+ * @throws std::filesystem::filesystem_error if the directory or one of its subdirectories cannot be read.
+ *
+ * @note The order of the entries is unspecified. With execution::parallel_policy the predicates are called
+ * concurrently from several threads, while the output iterator is only used by one thread at a time.
+ */
+template <typename ExecutionPolicy, typename OutputIt, typename UnaryPred,
+          typename PrunePred = details::never_prune>
+std::enable_if_t<execution::is_execution_policy_v<remove_cvref_t<ExecutionPolicy>> &&
+                     !std::is_invocable_v<OutputIt &, const std::filesystem::directory_entry &>,
+                 OutputIt>
+read_directory_recursive_if(ExecutionPolicy &&policy, const std::string &path, OutputIt first, UnaryPred p,
+                            PrunePred prune = {}, const std::size_t max_depth = unlimited_depth,
+                            const std::filesystem::directory_options options = std::filesystem::directory_options::none) {
+  auto sink{[&first](std::vector<std::filesystem::directory_entry> &batch) {
+    first = std::move(batch.begin(), batch.end(), first);
+  }};
+  if constexpr (std::is_same_v<remove_cvref_t<ExecutionPolicy>, execution::sequenced_policy>) {
+    details::walk_directory(execution::parallel_policy{1}, path, max_depth, options, p, prune, sink);
+  } else {
+    details::walk_directory(policy, path, max_depth, options, p, prune, sink);
+  }
+  return first;
+}
+
+/**
+ * Reads the contents of a directory and of its subdirectories and copies the entries that satisfy a given
+ * predicate to an output iterator.
+ *
+ * Same as read_directory_recursive_if(execution::seq, path, first, p, prune, max_depth, options).
+ *
+ * @tparam OutputIt Type of the output iterator.
+ * @tparam UnaryPred Type of the unary predicate.
+ * @tparam PrunePred Type of the pruning predicate.
+ * @param path Path to the directory to be read.
+ * @param first Output iterator to which the directory entries will be copied.
+ * @param p Unary predicate that returns true for the entries to be copied.
+ * @param prune Unary predicate that returns true for the subdirectories whose contents must not be read.
+ * @param max_depth Maximum depth of the entries to be read, the entries of path having depth 0.
+ * @param options Options of the directory iterators.
+ * @return Output iterator pointing to the end of the copied range.
+ *
+ * @throws std::filesystem::filesystem_error if the directory or one of its subdirectories cannot be read.
+ */
+template <typename OutputIt, typename UnaryPred, typename PrunePred = details::never_prune>
+std::enable_if_t<!std::is_invocable_v<OutputIt &, const std::filesystem::directory_entry &>, OutputIt>
+read_directory_recursive_if(const std::string &path, OutputIt first, UnaryPred p, PrunePred prune = {},
+                            const std::size_t max_depth = unlimited_depth,
+                            const std::filesystem::directory_options options = std::filesystem::directory_options::none) {
+  return read_directory_recursive_if(execution::seq, path, first, p, prune, max_depth, options);
+}
+
+/**
+ * Reads the contents of a directory and of its subdirectories, using an execution policy, and copies the
+ * entries to an output iterator.
+ *
+ * Same as read_directory_recursive_if(policy, path, first, p, {}, max_depth, options) with a predicate accepting
+ * every entry.
+ *
+ * @tparam ExecutionPolicy execution::sequenced_policy or execution::parallel_policy.
+ * @tparam OutputIt Type of the output iterator.
+ * @param policy The execution policy to use.
+ * @param path Path to the directory to be read.
+ * @param first Output iterator to which the directory entries will be copied.
+ * @param max_depth Maximum depth of the entries to be read, the entries of path having depth 0.
+ * @param options Options of the directory iterators.
+ * @return Output iterator pointing to the end of the copied range.
+ *
+ * @throws std::filesystem::filesystem_error if the directory or one of its subdirectories cannot be read.
+ */
+template <typename ExecutionPolicy, typename OutputIt>
+std::enable_if_t<execution::is_execution_policy_v<remove_cvref_t<ExecutionPolicy>> && !std::is_integral_v<OutputIt>,
+                 OutputIt>
+read_directory_recursive(ExecutionPolicy &&policy, const std::string &path, OutputIt first,
+                         const std::size_t max_depth = unlimited_depth,
+                         const std::filesystem::directory_options options = std::filesystem::directory_options::none) {
+  return read_directory_recursive_if(std::forward<ExecutionPolicy>(policy), path, first,
+                                     [](const std::filesystem::directory_entry &) { return true; },
+                                     details::never_prune{}, max_depth, options);
+}
+
+/**
+ * Reads the contents of a directory and of its subdirectories and copies the entries to an output iterator.
+ *
+ * @tparam OutputIt Type of the output iterator.
+ * @param path Path to the directory to be read.
+ * @param first Output iterator to which the directory entries will be copied.
+ * @param max_depth Maximum depth of the entries to be read, the entries of path having depth 0.
+ * @param options Options of the directory iterators.
+ * @return Output iterator pointing to the end of the copied range.
+ *
+ * @throws std::filesystem::filesystem_error if the directory or one of its subdirectories cannot be read.
+ */
+template <typename OutputIt>
+std::enable_if_t<!std::is_integral_v<OutputIt>, OutputIt>
+read_directory_recursive(const std::string &path, OutputIt first, const std::size_t max_depth = unlimited_depth,
+                         const std::filesystem::directory_options options = std::filesystem::directory_options::none) {
+  return read_directory_recursive(execution::seq, path, first, max_depth, options);
+}
+
+/**
+ * Reads the contents of a directory and of its subdirectories, using an execution policy, and returns them in
+ * a container.
+ *
+ * @tparam Container Type of the container to store the directory contents.
+ * Defaults to std::vector<std::filesystem::path>.
+ * @tparam ExecutionPolicy execution::sequenced_policy or execution::parallel_policy.
+ * @param policy The execution policy to use.
+ * @param directory Path to the directory to be read.
+ * @param max_depth Maximum depth of the entries to be read, the entries of directory having depth 0.
+ * @param options Options of the directory iterators.
+ * @return A container with the paths of the directory contents, in an unspecified order.
+ *
+ * @throws std::filesystem::filesystem_error if the directory or one of its subdirectories cannot be read.
+ */
+template <typename Container = std::vector<std::filesystem::path>, typename ExecutionPolicy>
+std::enable_if_t<execution::is_execution_policy_v<remove_cvref_t<ExecutionPolicy>>, Container>
+read_directory_recursive(ExecutionPolicy &&policy, const std::string &directory,
+                         const std::size_t max_depth = unlimited_depth,
+                         const std::filesystem::directory_options options = std::filesystem::directory_options::none) {
+  Container result;
+  if constexpr (has_push_back_v<Container>) {
+    read_directory_recursive(std::forward<ExecutionPolicy>(policy), directory, std::back_inserter(result), max_depth,
+                             options);
+  } else {
+    read_directory_recursive(std::forward<ExecutionPolicy>(policy), directory, std::inserter(result, result.end()),
+                             max_depth, options);
+  }
+  return result;
+}
+
+/**
+ * Reads the contents of a directory and of its subdirectories and returns them in a container.
+ *
+ * Same as read_directory_recursive<Container>(execution::seq, directory, max_depth, options).
+ *
+ * @tparam Container Type of the container to store the directory contents.
+ * Defaults to std::vector<std::filesystem::path>.
+ * @param directory Path to the directory to be read.
+ * @param max_depth Maximum depth of the entries to be read, the entries of directory having depth 0.
+ * @param options Options of the directory iterators.
+ * @return A container with the paths of the directory contents, in an unspecified order.
+ *
+ * @throws std::filesystem::filesystem_error if the directory or one of its subdirectories cannot be read.
+ */
+template <typename Container = std::vector<std::filesystem::path>>
+Container read_directory_recursive(const std::string &directory, const std::size_t max_depth = unlimited_depth,
+                                   const std::filesystem::directory_options options =
+                                       std::filesystem::directory_options::none) {
+  return read_directory_recursive<Container>(execution::seq, directory, max_depth, options);
+}
+
+/**
+ * Reads the contents of a directory and of its subdirectories, using an execution policy, and copies the paths
+ * that satisfy a given predicate to a container.
+ *
+ * @tparam Container Type of the container to store the directory contents.
+ * Defaults to std::vector<std::filesystem::path>.
+ * @tparam ExecutionPolicy execution::sequenced_policy or execution::parallel_policy.
+ * @tparam UnaryPred Type of the unary predicate.
+ * @tparam PrunePred Type of the pruning predicate.
+ * @param policy The execution policy to use.
+ * @param path Path to the directory to be read.
+ * @param p Unary predicate that returns true for the elements to be copied.
+ * @param prune Unary predicate that returns true for the subdirectories whose contents must not be read. By
+ * default no subdirectory is pruned.
+ * @param max_depth Maximum depth of the entries to be read, the entries of path having depth 0.
+ * @param options Options of the directory iterators.
+ * @return A container with the paths of the directory contents that satisfy the predicate, in an unspecified
+ * order.
+ *
+ * @throws std::filesystem::filesystem_error if the directory or one of its subdirectories cannot be read.
+ */
+template <typename Container = std::vector<std::filesystem::path>, typename ExecutionPolicy, typename UnaryPred,
+          typename PrunePred = details::never_prune>
+std::enable_if_t<execution::is_execution_policy_v<remove_cvref_t<ExecutionPolicy>> &&
+                     std::is_invocable_v<UnaryPred &, const std::filesystem::directory_entry &>,
+                 Container>
+read_directory_recursive_if(ExecutionPolicy &&policy, const std::string &path, UnaryPred p, PrunePred prune = {},
+                            const std::size_t max_depth = unlimited_depth,
+                            const std::filesystem::directory_options options = std::filesystem::directory_options::none) {
+  Container result;
+  if constexpr (has_push_back_v<Container>) {
+    read_directory_recursive_if(std::forward<ExecutionPolicy>(policy), path, std::back_inserter(result), p, prune,
+                                max_depth, options);
+  } else {
+    read_directory_recursive_if(std::forward<ExecutionPolicy>(policy), path, std::inserter(result, result.end()), p,
+                                prune, max_depth, options);
+  }
+  return result;
+}
+
+/**
+ * Reads the contents of a directory and of its subdirectories and copies the paths that satisfy a given predicate
+ * to a container.
+ *
+ * Same as read_directory_recursive_if<Container>(execution::seq, path, p, prune, max_depth, options).
+ *
+ * @tparam Container Type of the container to store the directory contents.
+ * Defaults to std::vector<std::filesystem::path>.
+ * @tparam UnaryPred Type of the unary predicate.
+ * @tparam PrunePred Type of the pruning predicate.
+ * @param path Path to the directory to be read.
+ * @param p Unary predicate that returns true for the elements to be copied.
+ * @param prune Unary predicate that returns true for the subdirectories whose contents must not be read.
+ * @param max_depth Maximum depth of the entries to be read, the entries of path having depth 0.
+ * @param options Options of the directory iterators.
+ * @return A container with the paths of the directory contents that satisfy the predicate, in an unspecified
+ * order.
+ *
+ * @throws std::filesystem::filesystem_error if the directory or one of its subdirectories cannot be read.
+ */
+template <typename Container = std::vector<std::filesystem::path>, typename UnaryPred,
+          typename PrunePred = details::never_prune>
+std::enable_if_t<std::is_invocable_v<UnaryPred &, const std::filesystem::directory_entry &>, Container>
+read_directory_recursive_if(const std::string &path, UnaryPred p, PrunePred prune = {},
+                            const std::size_t max_depth = unlimited_depth,
+                            const std::filesystem::directory_options options = std::filesystem::directory_options::none) {
+  return read_directory_recursive_if<Container>(execution::seq, path, p, prune, max_depth, options);
+}
+
+#if defined(__linux__)
+/**
+ * Listings of directories kept in memory and updated from inotify events, for directories that are read far
+ * more often than they change.
+ *
+ * A directory is read once, when it is watched or first queried, and its watch then reports the entries created,
+ * deleted and moved in or out of it to a background thread, which applies them to the listing. Queries only take
+ * a shared lock and copy the cached names: they make no system calls. If the inotify queue overflows, every
+ * directory is read again. A watched directory that is deleted or moved is read again, and watched again, by the
+ * next query for its path.
+ *
+ * The listings are eventually consistent: a change becomes visible once the background thread has processed its
+ * event, usually well within a millisecond. Entries are returned sorted by name. Only the entries themselves are
+ * cached, not their types or metadata. Available on Linux only.
+ */
+class directory_cache {
+public:
+  /**
+   * Creates an empty cache and starts its background thread.
+   *
+   * @throws std::system_error if the inotify instance cannot be created.
+   */
+  directory_cache() : thread_{[this] { run(); }} {}
+
+  directory_cache(const directory_cache &) = delete;
+  directory_cache &operator=(const directory_cache &) = delete;
+
+  ~directory_cache() {
+    inotify_.wake();
+    thread_.join();
+  }
+
+  /**
+   * Reads a directory into the cache and watches it for changes. Watching a directory that is already watched
+   * reads it again.
+   *
+   * @param path Path to the directory to be watched.
+   *
+   * @throws std::filesystem::filesystem_error if the directory cannot be watched or read.
+   */
+  void watch(const std::string &path) {
+    const auto key{std::filesystem::path(path).lexically_normal().string()};
+    std::unique_lock lock{mutex_};
+    forget(key);
+    auto &entry{directories_[key]};
+    try {
+      entry.wd = inotify_.add_watch(key);
+      directories_by_wd_.emplace(entry.wd, key);
+      scan(key, entry);
+    } catch (...) {
+      forget(key);
+      throw;
+    }
+  }
+
+  /**
+   * Stops watching a directory and drops its listing. Does nothing if the directory is not watched.
+   *
+   * @param path Path to the directory.
+   */
+  void unwatch(const std::string &path) {
+    const auto key{std::filesystem::path(path).lexically_normal().string()};
+    std::unique_lock lock{mutex_};
+    forget(key);
+  }
+
+  /**
+   * Reads every watched directory again, as is done when the inotify queue overflows.
+   */
+  void refresh() {
+    std::unique_lock lock{mutex_};
+    rescan();
+  }
+
+  /**
+   * Returns true if a directory is watched and its listing is up to date.
+   */
+  bool watched(const std::string &path) const {
+    const auto key{std::filesystem::path(path).lexically_normal().string()};
+    std::shared_lock lock{mutex_};
+    const auto it{directories_.find(key)};
+    return it != directories_.end() && !it->second.stale;
+  }
+
+  /**
+   * Copies the paths of the cached entries of a directory to an output iterator, watching the directory first if
+   * needed.
+   *
+   * @tparam OutputIt Type of the output iterator.
+   * @param path Path to the directory to be read.
+   * @param first Output iterator to which the paths will be copied.
+   * @return Output iterator pointing to the end of the copied range.
+   *
+   * @throws std::filesystem::filesystem_error if the directory is not watched and cannot be watched or read.
+   */
+  template <typename OutputIt>
+  OutputIt read_directory(const std::string &path, OutputIt first) {
+    return read_directory_if(path, first, [](const std::filesystem::path &) { return true; });
+  }
+
+  /**
+   * Copies the paths of the cached entries of a directory that satisfy a given predicate to an output iterator,
+   * watching the directory first if needed. The predicate is called under a shared lock of the cache and must
+   * not watch or unwatch directories.
+   *
+   * @tparam OutputIt Type of the output iterator.
+   * @tparam UnaryPred Type of the unary predicate.
+   * @param path Path to the directory to be read.
+   * @param first Output iterator to which the paths will be copied.
+   * @param p Unary predicate taking a const std::filesystem::path & that returns true for the paths to be copied.
+   * @return Output iterator pointing to the end of the copied range.
+   *
+   * @throws std::filesystem::filesystem_error if the directory is not watched and cannot be watched or read.
+   */
+  template <typename OutputIt, typename UnaryPred>
+  OutputIt read_directory_if(const std::string &path, OutputIt first, UnaryPred p) {
+    const auto key{std::filesystem::path(path).lexically_normal().string()};
+    for (;;) {
+      {
+        std::shared_lock lock{mutex_};
+        const auto it{directories_.find(key)};
+        if (it != directories_.end() && !it->second.stale) {
+          const std::filesystem::path directory{key};
+          for (const auto &name : it->second.names) {
+            auto entry{directory / name};
+            if (p(entry)) {
+              *first++ = std::move(entry);
+            }
+          }
+          return first;
+        }
+      }
+      watch(key);
+    }
+  }
+
+  /**
+   * Returns the paths of the cached entries of a directory in a container, watching the directory first if
+   * needed.
+   *
+   * @tparam Container Type of the container. Defaults to std::vector<std::filesystem::path>.
+   * @param path Path to the directory to be read.
+   * @return A container with the paths of the cached entries.
+   *
+   * @throws std::filesystem::filesystem_error if the directory is not watched and cannot be watched or read.
+   */
+  template <typename Container = std::vector<std::filesystem::path>>
+  Container read_directory(const std::string &path) {
+    return read_directory_if<Container>(path, [](const std::filesystem::path &) { return true; });
+  }
+
+  /**
+   * Returns the paths of the cached entries of a directory that satisfy a given predicate in a container,
+   * watching the directory first if needed.
+   *
+   * @tparam Container Type of the container. Defaults to std::vector<std::filesystem::path>.
+   * @tparam UnaryPred Type of the unary predicate.
+   * @param path Path to the directory to be read.
+   * @param p Unary predicate taking a const std::filesystem::path & that returns true for the paths to be copied.
+   * @return A container with the paths of the cached entries that satisfy the predicate.
+   *
+   * @throws std::filesystem::filesystem_error if the directory is not watched and cannot be watched or read.
+   */
+  template <typename Container = std::vector<std::filesystem::path>, typename UnaryPred>
+  Container read_directory_if(const std::string &path, UnaryPred p) {
+    Container result;
+    if constexpr (has_push_back_v<Container>) {
+      read_directory_if(path, std::back_inserter(result), p);
+    } else {
+      read_directory_if(path, std::inserter(result, result.end()), p);
+    }
+    return result;
+  }
+
+private:
+  struct listing {
+    int wd{-1};
+    bool stale{false};
+    std::set<std::string, std::less<>> names;
+  };
+
+  static void scan(const std::string &path, listing &entry) {
+    std::set<std::string, std::less<>> names;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    auto keep{[&names](const std::string_view name, std::filesystem::file_type, std::uint64_t) {
+      names.emplace(name);
+      return false;
+    }};
+    details::read_dirents(path, blocks, keep);
+    entry.names = std::move(names);
+    entry.stale = false;
+  }
+
+  // Drops the listing and the watch of a directory. Called with the lock held.
+  void forget(const std::string &key) {
+    const auto it{directories_.find(key)};
+    if (it == directories_.end()) {
+      return;
+    }
+    const auto wd{it->second.wd};
+    directories_.erase(it);
+    if (wd < 0) {
+      return;
+    }
+    const auto [first, last]{directories_by_wd_.equal_range(wd)};
+    for (auto by_wd{first}; by_wd != last; ++by_wd) {
+      if (by_wd->second == key) {
+        directories_by_wd_.erase(by_wd);
+        break;
+      }
+    }
+    // Paths naming the same directory share its watch descriptor.
+    if (!directories_by_wd_.count(wd)) {
+      inotify_.remove_watch(wd);
+    }
+  }
+
+  // Reads every watched directory again, leaving those whose watch was lost to the next query. Called with the
+  // lock held.
+  void rescan() {
+    for (auto &[key, entry] : directories_) {
+      if (entry.stale) {
+        continue;
+      }
+      try {
+        scan(key, entry);
+      } catch (const std::filesystem::filesystem_error &) {
+        entry.stale = true;
+      }
+    }
+  }
+
+  void apply(const int wd, const std::uint32_t mask, const std::string_view name) {
+    if (mask & IN_Q_OVERFLOW) {
+      rescan();
+      return;
+    }
+    const auto [first, last]{directories_by_wd_.equal_range(wd)};
+    for (auto by_wd{first}; by_wd != last; ++by_wd) {
+      auto &entry{directories_[by_wd->second]};
+      if (mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+        entry.stale = true;
+      } else if (mask & (IN_CREATE | IN_MOVED_TO)) {
+        entry.names.emplace(name);
+      } else if (mask & (IN_DELETE | IN_MOVED_FROM)) {
+        if (const auto it{entry.names.find(name)}; it != entry.names.end()) {
+          entry.names.erase(it);
+        }
+      }
+    }
+  }
+
+  void run() {
+    while (inotify_.wait()) {
+      std::unique_lock lock{mutex_};
+      inotify_.read_events([this](const int wd, const std::uint32_t mask, const std::string_view name) {
+        apply(wd, mask, name);
+      });
+    }
+  }
+
+  mutable std::shared_mutex mutex_;
+  std::map<std::string, listing, std::less<>> directories_;
+  std::unordered_multimap<int, std::string> directories_by_wd_;
+  details::inotify_handle inotify_;
+  std::thread thread_;
+};
+#endif // __linux__
 } // namespace utils
 
 #endif //FILES_HPP
@@ -0,0 +1,194 @@
+#ifndef FLOAT16_HPP
+#define FLOAT16_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace utils {
+namespace details {
+inline float float_from_bits(const std::uint32_t bits) noexcept {
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+inline std::uint32_t float_to_bits(const float value) noexcept {
+  std::uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+/**
+ * @brief Converts the bits of an IEEE 754 binary16 value to float, exactly.
+ */
+inline float half_to_float(const std::uint16_t half) noexcept {
+  const auto sign{static_cast<std::uint32_t>(half & 0x8000) << 16};
+  const auto exponent{static_cast<std::uint32_t>(half >> 10) & 0x1f};
+  const auto mantissa{static_cast<std::uint32_t>(half) & 0x3ff};
+  if (exponent == 0x1f) {
+    return float_from_bits(sign | 0x7f800000 | (mantissa << 13));
+  }
+  if (!exponent) {
+    const auto value{static_cast<float>(mantissa) * 0x1p-24f};
+    return sign ? -value : value;
+  }
+  return float_from_bits(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+/**
+ * @brief Converts a float to the bits of an IEEE 754 binary16 value, rounding
+ * to nearest, ties to even.
+ */
+inline std::uint16_t float_to_half(const float value) noexcept {
+  auto bits{float_to_bits(value)};
+  const auto sign{static_cast<std::uint16_t>((bits >> 16) & 0x8000)};
+  bits &= 0x7fffffff;
+  if (bits >= 0x7f800000) {
+    // Infinity, or a quiet NaN keeping the top bits of the payload.
+    return static_cast<std::uint16_t>(sign | 0x7c00 |
+                                      (bits > 0x7f800000 ? 0x200 | ((bits >> 13) & 0x3ff) : 0));
+  }
+  if (bits >= 0x477ff000) {
+    return static_cast<std::uint16_t>(sign | 0x7c00);
+  }
+  if (bits < 0x38800000) {
+    // Subnormal result, in units of 2^-24.
+    if (bits <= 0x33000000) {
+      return sign;
+    }
+    const auto shift{126 - (bits >> 23)};
+    const auto mantissa{(bits & 0x7fffff) | 0x800000};
+    auto quotient{mantissa >> shift};
+    const auto remainder{mantissa & ((std::uint32_t{1} << shift) - 1)};
+    const auto half{std::uint32_t{1} << (shift - 1)};
+    if (remainder > half || (remainder == half && (quotient & 1))) {
+      ++quotient;
+    }
+    return static_cast<std::uint16_t>(sign | quotient);
+  }
+  // Rebias the exponent from 127 to 15 and round the 13 dropped bits.
+  bits += 0xc8000fff + ((bits >> 13) & 1);
+  return static_cast<std::uint16_t>(sign | (bits >> 13));
+}
+
+/**
+ * @brief Converts a float to the bits of a bfloat16 value, rounding to
+ * nearest, ties to even. NaNs stay quiet NaNs.
+ */
+inline std::uint16_t float_to_bfloat16(const float value) noexcept {
+  auto bits{float_to_bits(value)};
+  if ((bits & 0x7fffffff) > 0x7f800000) {
+    return static_cast<std::uint16_t>((bits >> 16) | 0x40);
+  }
+  bits += 0x7fff + ((bits >> 16) & 1);
+  return static_cast<std::uint16_t>(bits >> 16);
+}
+} // namespace details
+
+/**
+ * @brief IEEE 754 binary16 floating point value, stored as its bit pattern.
+ *
+ * float16 is a storage type: it converts implicitly to float, in which all
+ * arithmetic is carried out, and is constructed explicitly from float. The
+ * reductions of the numeric header read ranges of float16 directly, widening
+ * them in SIMD registers, and accumulate in double.
+ */
+class float16 {
+public:
+  float16() noexcept = default;
+
+  /**
+   * @brief Constructs the float16 nearest to value, ties to even.
+   */
+  explicit float16(const float value) noexcept : bits_{details::float_to_half(value)} {}
+
+  /**
+   * @brief Returns the value as a float, which is exact.
+   */
+  operator float() const noexcept { return details::half_to_float(bits_); }
+
+  /**
+   * @brief Returns the float16 with the given bit pattern.
+   */
+  static float16 from_bits(const std::uint16_t bits) noexcept {
+    float16 value;
+    value.bits_ = bits;
+    return value;
+  }
+
+  /**
+   * @brief Returns the bit pattern of the value.
+   */
+  std::uint16_t bits() const noexcept { return bits_; }
+
+private:
+  std::uint16_t bits_;
+};
+
+/**
+ * @brief bfloat16 floating point value, the upper half of a float, stored as
+ * its bit pattern.
+ *
+ * Like float16, bfloat16 is a storage type converting implicitly to float and
+ * explicitly from float.
+ */
+class bfloat16 {
+public:
+  bfloat16() noexcept = default;
+
+  /**
+   * @brief Constructs the bfloat16 nearest to value, ties to even.
+   */
+  explicit bfloat16(const float value) noexcept : bits_{details::float_to_bfloat16(value)} {}
+
+  /**
+   * @brief Returns the value as a float, which is exact.
+   */
+  operator float() const noexcept {
+    return details::float_from_bits(static_cast<std::uint32_t>(bits_) << 16);
+  }
+
+  /**
+   * @brief Returns the bfloat16 with the given bit pattern.
+   */
+  static bfloat16 from_bits(const std::uint16_t bits) noexcept {
+    bfloat16 value;
+    value.bits_ = bits;
+    return value;
+  }
+
+  /**
+   * @brief Returns the bit pattern of the value.
+   */
+  std::uint16_t bits() const noexcept { return bits_; }
+
+private:
+  std::uint16_t bits_;
+};
+
+/** @defgroup is_narrow_float_struct IsNarrowFloat
+ * @{
+ */
+
+/**
+ * @brief Checks whether T is float16 or bfloat16.
+ *
+ * @tparam T The type to check.
+ */
+template <typename T>
+struct is_narrow_float
+    : std::bool_constant<std::is_same_v<T, float16> || std::is_same_v<T, bfloat16>> {};
+
+/**
+ * @brief Helper variable template for is_narrow_float.
+ *
+ * @tparam T The type to check.
+ */
+template <typename T>
+inline constexpr bool is_narrow_float_v = is_narrow_float<T>::value;
+
+/** @} */
+} // namespace utils
+
+#endif // FLOAT16_HPP
@@ -158,6 +158,13 @@ public:
                       iterators_);
   }
 
+  /**
+   * @brief Returns the underlying iterators.
+   *
+   * @return A tuple of the iterators, in the order of the template parameters.
+   */
+  const std::tuple<InputIts...> &base() const noexcept { return iterators_; }
+
   /**
    * @brief Accesses the elements pointed to by the iterators.
    *
@@ -1,8 +1,33 @@
 #ifndef NUMERICS_HPP
 #define NUMERICS_HPP
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "details/dot_kernels.hpp"
+#include "details/exact_mean_kernels.hpp"
+#include "details/product_kernels.hpp"
+#include "details/quantile_sketch.hpp"
+#include "details/scan_kernels.hpp"
+#include "details/stats_kernels.hpp"
+#include "details/sum_kernels.hpp"
+#include "details/tree_reduce.hpp"
+#include "execution.hpp"
+#include "float16.hpp"
+#include "iterator.hpp"
 #include "type_traits.hpp"
+#include "utility.hpp"
 
 namespace utils {
 /**
@@ -19,10 +44,269 @@ namespace utils {
  * @param init The initial value to start the product.
  *
  * @return T The product of the elements in the range.
+ *
+ * @note If T is float16 or bfloat16 the product is accumulated in double and
+ * rounded to T once.
  */
 template <typename InputIt, typename T>
 T product(InputIt first, const InputIt last, T init) {
-  return std::accumulate(first, last, init, std::multiplies());
+  if constexpr (is_narrow_float_v<T>) {
+    return T(static_cast<float>(product(first, last, static_cast<double>(init))));
+  } else {
+    return std::accumulate(first, last, init, std::multiplies());
+  }
+}
+
+namespace numeric {
+/**
+ * @brief Product mode checking integral products for overflow.
+ */
+struct checked_policy {};
+
+/**
+ * @brief Product mode keeping floating point products as a mantissa and a
+ * power of two, see scaled_value.
+ */
+struct scaled_policy {};
+
+/**
+ * @brief Product mode returning the natural logarithm of the product.
+ */
+struct log_domain_policy {};
+
+/**
+ * @brief Mean mode summing integers exactly and rounding the quotient once.
+ */
+struct exact_policy {};
+
+/**
+ * @brief Instance of checked_policy.
+ */
+inline constexpr checked_policy checked{};
+
+/**
+ * @brief Instance of scaled_policy.
+ */
+inline constexpr scaled_policy scaled{};
+
+/**
+ * @brief Instance of log_domain_policy.
+ */
+inline constexpr log_domain_policy log_domain{};
+
+/**
+ * @brief Instance of exact_policy.
+ */
+inline constexpr exact_policy exact{};
+} // namespace numeric
+
+/**
+ * @brief Floating point value stored as mantissa * 2^exponent, with a range
+ * wide enough for any product of doubles.
+ *
+ * @tparam T The floating point type of the mantissa.
+ */
+template <typename T>
+struct scaled_value {
+  /**
+   * @brief Mantissa, in [0.5, 1) in magnitude unless it is zero, infinite or
+   * NaN, in which case exponent is 0.
+   */
+  T mantissa;
+
+  /**
+   * @brief Power of two by which the mantissa is multiplied.
+   */
+  std::int64_t exponent;
+
+  /**
+   * @brief Returns mantissa * 2^exponent, which may overflow to infinity or
+   * underflow to zero.
+   */
+  T value() const {
+    constexpr auto limit{std::int64_t{std::numeric_limits<int>::max()}};
+    return std::ldexp(mantissa, static_cast<int>(std::clamp(exponent, -limit, limit)));
+  }
+
+  /**
+   * @brief Returns the natural logarithm of the value: -inf for zero and NaN
+   * for negative values.
+   */
+  T log() const {
+    if (!(mantissa > T(0))) {
+      return std::log(mantissa);
+    }
+    return std::log(mantissa) +
+           static_cast<T>(exponent) * static_cast<T>(0.693147180559945309417232121458176568L);
+  }
+};
+
+/**
+ * @brief Computes the product of a range of integral elements, detecting
+ * overflow.
+ *
+ * Overflow is checked with compiler builtins once per batch of elements and
+ * stops the product at the end of the first batch that overflowed.
+ *
+ * @tparam InputIt Input iterator type for the range.
+ * @tparam T The integral type of the initial value and the result.
+ *
+ * @param first The beginning of the range.
+ * @param last The end of the range.
+ * @param init The initial value to start the product.
+ *
+ * @return A pair where the first element is false if the product overflowed
+ * T, and the second element is the product, 0 on overflow.
+ */
+template <typename InputIt, typename T>
+std::pair<bool, T> product(numeric::checked_policy, InputIt first, const InputIt last, T init) {
+  static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>,
+                "checked product requires an integral type");
+  return details::checked_product(first, last, init);
+}
+
+/**
+ * @brief Computes the product of a range of elements as a mantissa and a
+ * power of two, so that it neither overflows nor underflows.
+ *
+ * Elements are converted to at least double and split into mantissa and
+ * exponent; mantissas are multiplied in several independent lanes and
+ * exponents summed as integers. The product of 10^5 probabilities, which is
+ * 0 in double, keeps its full precision.
+ *
+ * @tparam InputIt Input iterator type for the range.
+ * @tparam T The arithmetic type of the initial value.
+ *
+ * @param first The beginning of the range.
+ * @param last The end of the range.
+ * @param init The initial value to start the product.
+ *
+ * @return scaled_value The product of the elements in the range.
+ */
+template <typename InputIt, typename T>
+scaled_value<std::common_type_t<T, double>> product(numeric::scaled_policy, InputIt first,
+                                                   const InputIt last, T init) {
+  using S = std::common_type_t<T, double>;
+  const auto [mantissa, exponent] = details::scaled_product(first, last, static_cast<S>(init));
+  return scaled_value<S>{mantissa, exponent};
+}
+
+/**
+ * @brief Computes the natural logarithm of the product of a range of
+ * elements.
+ *
+ * The product is computed as with numeric::scaled and its logarithm taken
+ * once, which is both faster and more accurate than summing the logarithms of
+ * the elements. The result is -inf if an element is zero and NaN if the
+ * product is negative.
+ *
+ * @tparam InputIt Input iterator type for the range.
+ * @tparam T The arithmetic type of the initial value.
+ *
+ * @param first The beginning of the range.
+ * @param last The end of the range.
+ * @param init The initial value to start the product.
+ *
+ * @return The natural logarithm of the product, in at least double.
+ */
+template <typename InputIt, typename T>
+std::common_type_t<T, double> product(numeric::log_domain_policy, InputIt first, const InputIt last,
+                                      T init) {
+  return product(numeric::scaled, first, last, init).log();
+}
+
+/**
+ * @brief Computes the product of the elements of a fixed-size array, at
+ * compile time if possible.
+ *
+ * The multiplications are unrolled into a tree of depth ceil(log2(N)), which
+ * shortens the dependency chain of std::accumulate from N to log2(N)
+ * multiplications. Floating point results may differ from product(first,
+ * last, init) in the last bits.
+ *
+ * @tparam T The type of the elements and the result.
+ * @tparam N The number of elements.
+ *
+ * @param values The array.
+ * @param init The initial value to start the product.
+ *
+ * @return T The product of init and the elements.
+ */
+template <typename T, std::size_t N>
+constexpr T product(const std::array<T, N> &values,
+                    const typename std::array<T, N>::value_type init) {
+  if constexpr (N == 0) {
+    return init;
+  } else {
+    auto lanes{values};
+    auto multiplies{[](const T &a, const T &b) { return a * b; }};
+    return init * details::fold_lanes<N>(lanes, multiplies);
+  }
+}
+
+/**
+ * @brief Computes the product of the elements of a fixed-size array, at
+ * compile time if possible.
+ *
+ * Same as product(values, T(1)).
+ *
+ * @tparam T The type of the elements and the result.
+ * @tparam N The number of elements.
+ *
+ * @param values The array.
+ *
+ * @return T The product of the elements, T(1) for an empty array.
+ */
+template <typename T, std::size_t N>
+constexpr T product(const std::array<T, N> &values) {
+  return product(values, T(1));
+}
+
+/**
+ * @brief Computes the product of a range of elements using an execution
+ * policy.
+ *
+ * With execution::parallel_policy the range is split into leaves of a fixed
+ * size whose products are combined pairwise along a tree that only depends on
+ * the length of the range. Floating point results may differ from
+ * product(first, last, init) in the last bits, but are identical from run to
+ * run whatever the number of threads. Operands are never reordered, only
+ * regrouped, so the multiplication need not be commutative.
+ *
+ * @tparam ExecutionPolicy execution::sequenced_policy or
+ * execution::parallel_policy.
+ * @tparam RandomIt Type of the random access iterator.
+ * @tparam T The type of the initial value and the result.
+ *
+ * @param policy The execution policy to use.
+ * @param first The beginning of the range.
+ * @param last The end of the range.
+ * @param init The initial value to start the product.
+ *
+ * @return T The product of the elements in the range.
+ */
+template <typename ExecutionPolicy, typename RandomIt, typename T>
+std::enable_if_t<execution::is_execution_policy_v<remove_cvref_t<ExecutionPolicy>>, T>
+product(ExecutionPolicy &&policy, RandomIt first, const RandomIt last, T init) {
+  if constexpr (std::is_same_v<remove_cvref_t<ExecutionPolicy>, execution::sequenced_policy>) {
+    return product(first, last, init);
+  } else if constexpr (is_narrow_float_v<T>) {
+    return T(static_cast<float>(product(policy, first, last, static_cast<double>(init))));
+  } else {
+    const auto n{static_cast<std::size_t>(std::distance(first, last))};
+    if (!n) {
+      return init;
+    }
+    auto total{details::tree_reduce(
+        policy, details::reduce_leaf_count(n),
+        [first, n](const std::size_t b) {
+          const auto begin{std::next(first, b * details::reduce_leaf_size)};
+          const auto end{std::next(first, std::min(n, (b + 1) * details::reduce_leaf_size))};
+          return std::accumulate(std::next(begin), end, static_cast<T>(*begin), std::multiplies());
+        },
+        [](T a, T b) { return a * b; })};
+    return init * total;
+  }
 }
 
 /**
@@ -31,6 +315,14 @@ T product(InputIt first, const InputIt last, T init) {
  * This function calculates the mean (average) of the elements in the range
  * [first, last).
  *
+ * Arithmetic, float16 and bfloat16 elements are summed in a widened
+ * accumulator: 64-bit integers for integral types and double for float,
+ * float16 and bfloat16. Contiguous ranges of these floating point types are
+ * read directly, widened in SIMD registers and summed pairwise with a fixed
+ * summation order, so the result is accurate and bit-identical whatever the
+ * instruction set. Contiguous 8-bit integer ranges are summed with SAD
+ * instructions.
+ *
  * @tparam InputIt Input iterator type for the range.
  *
  * @param first The beginning of the range.
@@ -38,23 +330,22 @@ T product(InputIt first, const InputIt last, T init) {
  *
  * @return decltype(*first) The mean of the elements in the range.
  *
- * @note The return type is the same as the type of the elements in the range.
- * Overflow may occur.
+ * @note The return type is the same as the type of the elements in the range,
+ * integral means are truncated towards zero. Sums of 64-bit integers may
+ * overflow, see mean(numeric::exact_policy, first, last).
  */
 
 template <typename InputIt>
 auto mean(InputIt first, const InputIt last) -> remove_cvref_t<decltype(*first)> {
-  using return_type = remove_cvref_t<decltype(*first)>;
-  if (auto distance{std::distance(first, last)}; distance) {
-    return std::accumulate(first, last, return_type(0)) / distance;
-  }
-  return return_type(0);
+  return details::mean<remove_cvref_t<decltype(*first)>>(first, last);
 }
 
 /**
 * @brief Computes the mean of a range of elements.
 *
 * This function calculates the mean (average) of the elements in the range [first, last).
+* Arithmetic elements are summed as in mean(first, last) and the division is
+* carried out in floating point if T is a floating point type.
 *
 * @tparam T The type of the result.
 * @tparam InputIt Input iterator type for the range.
@@ -64,16 +355,1115 @@ auto mean(InputIt first, const InputIt last) -> remove_cvref_t<decltype(*first)>
 *
 * @return T The mean of the elements in the range.
 *
-* @note If type T is incorrectly specified, overflow may occur.
+* @note For non-arithmetic elements the sum is accumulated in T, so if type T
+* is incorrectly specified, overflow may occur.
 */
 template <typename T, typename InputIt>
 T mean(InputIt first, const InputIt last) {
-  if (auto distance{std::distance(first, last)}; distance) {
-    return std::accumulate(first, last, T(0)) / distance;
+  return details::mean<T>(first, last);
+}
+
+/**
+ * @brief Computes the mean of the elements of a fixed-size array as an R, at
+ * compile time if possible.
+ *
+ * Arithmetic elements are widened as in mean(first, last), then summed along
+ * a tree of depth ceil(log2(N)) unrolled at compile time.
+ *
+ * @tparam R The type of the result, the element type if void.
+ * @tparam T The type of the elements.
+ * @tparam N The number of elements.
+ *
+ * @param values The array.
+ *
+ * @return R The mean of the elements, R(0) for an empty array.
+ */
+template <typename R = void, typename T, std::size_t N>
+constexpr std::conditional_t<std::is_void_v<R>, T, R> mean(const std::array<T, N> &values) {
+  using result_type = std::conditional_t<std::is_void_v<R>, T, R>;
+  if constexpr (N == 0) {
+    return result_type(0);
+  } else if constexpr (details::has_widened_sum_v<T> && details::has_widened_sum_v<result_type>) {
+    using accumulator = details::sum_accumulator_t<T>;
+    std::array<accumulator, N> lanes{};
+    constexpr_for<std::size_t{0}, N, std::size_t{1}>(
+        [&](const auto i) { lanes[i] = static_cast<accumulator>(values[i]); });
+    auto plus{[](const accumulator a, const accumulator b) { return a + b; }};
+    return details::mean_from_sum<result_type>(details::fold_lanes<N>(lanes, plus), N);
+  } else {
+    std::array<result_type, N> lanes{};
+    constexpr_for<std::size_t{0}, N, std::size_t{1}>(
+        [&](const auto i) { lanes[i] = static_cast<result_type>(values[i]); });
+    auto plus{[](const result_type &a, const result_type &b) { return a + b; }};
+    return details::fold_lanes<N>(lanes, plus) / static_cast<std::ptrdiff_t>(N);
   }
-  return T(0);
 }
 
+/**
+ * @brief Computes the mean of a range of elements as a T using an execution
+ * policy.
+ *
+ * Same as mean(policy, first, last), the result being computed as in
+ * mean<T>(first, last).
+ *
+ * @tparam T The type of the result.
+ * @tparam ExecutionPolicy execution::sequenced_policy or
+ * execution::parallel_policy.
+ * @tparam RandomIt Type of the random access iterator.
+ *
+ * @param policy The execution policy to use.
+ * @param first The beginning of the range.
+ * @param last The end of the range.
+ *
+ * @return T The mean of the elements in the range.
+ */
+template <typename T, typename ExecutionPolicy, typename RandomIt>
+std::enable_if_t<execution::is_execution_policy_v<remove_cvref_t<ExecutionPolicy>>, T>
+mean(ExecutionPolicy &&policy, RandomIt first, const RandomIt last) {
+  if constexpr (std::is_same_v<remove_cvref_t<ExecutionPolicy>, execution::sequenced_policy>) {
+    return details::mean<T>(first, last);
+  } else {
+    return details::mean<T>(policy, first, last);
+  }
+}
+
+/**
+ * @brief Computes the mean of a range of elements using an execution policy.
+ *
+ * With execution::parallel_policy the range is split into leaves of a fixed
+ * size whose sums are combined pairwise along a tree that only depends on the
+ * length of the range, so the result is identical from run to run whatever
+ * the number of threads. For contiguous float and double ranges and for
+ * integral ranges it is also equal to mean(first, last).
+ *
+ * @tparam ExecutionPolicy execution::sequenced_policy or
+ * execution::parallel_policy.
+ * @tparam RandomIt Type of the random access iterator.
+ *
+ * @param policy The execution policy to use.
+ * @param first The beginning of the range.
+ * @param last The end of the range.
+ *
+ * @return decltype(*first) The mean of the elements in the range.
+ */
+template <typename ExecutionPolicy, typename RandomIt>
+auto mean(ExecutionPolicy &&policy, RandomIt first, const RandomIt last)
+    -> std::enable_if_t<execution::is_execution_policy_v<remove_cvref_t<ExecutionPolicy>>,
+                        remove_cvref_t<decltype(*first)>> {
+  return mean<remove_cvref_t<decltype(*first)>>(std::forward<ExecutionPolicy>(policy), first, last);
+}
+
+/**
+ * @brief Computes the mean of a range of integers as a T without overflow.
+ *
+ * The integers are summed exactly in 128 bits, on SIMD kernels for contiguous
+ * ranges of 64-bit integers, and the sum is divided once. Integral results
+ * are rounded to nearest, ties to even; float and double results are
+ * correctly rounded. Counters spanning the whole uint64_t range can be
+ * averaged over up to 2^64 - 1 elements.
+ *
+ * @tparam T The arithmetic type of the result.
+ * @tparam InputIt Input iterator type for the range, of integral elements.
+ *
+ * @param first The beginning of the range.
+ * @param last The end of the range.
+ *
+ * @return T The mean of the elements in the range, T(0) for an empty range.
+ */
+template <typename T, typename InputIt>
+T mean(numeric::exact_policy, InputIt first, const InputIt last) {
+  const auto n{static_cast<std::uint64_t>(std::distance(first, last))};
+  if (!n) {
+    return T(0);
+  }
+  return details::exact_mean<T>(details::exact_sum(first, last), n);
+}
+
+/**
+ * @brief Computes the mean of a range of integers without overflow.
+ *
+ * Same as mean<T>(numeric::exact, first, last) with T the type of the
+ * elements, so the mean is rounded to the nearest integer, ties to even.
+ *
+ * @tparam InputIt Input iterator type for the range, of integral elements.
+ *
+ * @param first The beginning of the range.
+ * @param last The end of the range.
+ *
+ * @return decltype(*first) The mean of the elements in the range.
+ */
+template <typename InputIt>
+auto mean(numeric::exact_policy policy, InputIt first, const InputIt last)
+    -> remove_cvref_t<decltype(*first)> {
+  return mean<remove_cvref_t<decltype(*first)>>(policy, first, last);
+}
+
+/**
+ * @brief Computes the sum of the products of two ranges of elements.
+ *
+ * This function calculates init plus the sum of first1[i] * first2[i] for the
+ * elements of [first1, last1), like std::inner_product.
+ *
+ * Arithmetic products are summed in a widened accumulator as in mean().
+ * Contiguous ranges of the same float or double type are summed pairwise on
+ * SIMD kernels with multiple FMA accumulators; float results are bit-identical
+ * whatever the instruction set.
+ *
+ * @tparam InputIt1 Input iterator type for the first range.
+ * @tparam InputIt2 Input iterator type for the second range.
+ * @tparam T The type of the initial value and the result.
+ *
+ * @param first1 The beginning of the first range.
+ * @param last1 The end of the first range.
+ * @param first2 The beginning of the second range.
+ * @param init The initial value to start the sum.
+ *
+ * @return T The sum of the products.
+ */
+template <typename InputIt1, typename InputIt2, typename T>
+T sum_of_products(InputIt1 first1, const InputIt1 last1, InputIt2 first2, T init) {
+  return details::sum_of_products(first1, last1, first2, init);
+}
+
+/**
+ * @brief Computes the sum of the products of the pairs of a MultiIterator
+ * range.
+ *
+ * Same as sum_of_products(first1, last1, first2, init) over the two underlying
+ * ranges, so contiguous ranges reach the SIMD kernels.
+ *
+ * @tparam InputIt1 Type of the first underlying iterator.
+ * @tparam InputIt2 Type of the second underlying iterator.
+ * @tparam T The type of the initial value and the result.
+ *
+ * @param first The beginning of the range.
+ * @param last The end of the range.
+ * @param init The initial value to start the sum.
+ *
+ * @return T The sum of the products.
+ */
+template <typename InputIt1, typename InputIt2, typename T>
+T sum_of_products(const MultiIterator<InputIt1, InputIt2> &first,
+                  const MultiIterator<InputIt1, InputIt2> &last, T init) {
+  return details::sum_of_products(std::get<0>(first.base()), std::get<0>(last.base()),
+                                  std::get<1>(first.base()), init);
+}
+
+/**
+ * @brief Computes the dot product of two ranges of elements as a T.
+ *
+ * Same as sum_of_products(first1, last1, first2, T(0)).
+ *
+ * @tparam T The type of the result.
+ * @tparam InputIt1 Input iterator type for the first range.
+ * @tparam InputIt2 Input iterator type for the second range.
+ *
+ * @param first1 The beginning of the first range.
+ * @param last1 The end of the first range.
+ * @param first2 The beginning of the second range.
+ *
+ * @return T The dot product.
+ */
+template <typename T, typename InputIt1, typename InputIt2>
+T dot(InputIt1 first1, const InputIt1 last1, InputIt2 first2) {
+  return details::sum_of_products(first1, last1, first2, T(0));
+}
+
+/**
+ * @brief Computes the dot product of two ranges of elements.
+ *
+ * @tparam InputIt1 Input iterator type for the first range.
+ * @tparam InputIt2 Input iterator type for the second range.
+ *
+ * @param first1 The beginning of the first range.
+ * @param last1 The end of the first range.
+ * @param first2 The beginning of the second range.
+ *
+ * @return The dot product, of the common type of the elements.
+ *
+ * @note The sum is widened as in mean(), but the result is converted back to
+ * the common type of the elements.
+ */
+template <typename InputIt1, typename InputIt2>
+auto dot(InputIt1 first1, const InputIt1 last1, InputIt2 first2)
+    -> std::common_type_t<remove_cvref_t<decltype(*first1)>, remove_cvref_t<decltype(*first2)>> {
+  using result_type =
+      std::common_type_t<remove_cvref_t<decltype(*first1)>, remove_cvref_t<decltype(*first2)>>;
+  return dot<result_type>(first1, last1, first2);
+}
+
+/**
+ * @brief Computes the dot product of the pairs of a MultiIterator range.
+ *
+ * @tparam InputIt1 Type of the first underlying iterator.
+ * @tparam InputIt2 Type of the second underlying iterator.
+ *
+ * @param first The beginning of the range.
+ * @param last The end of the range.
+ *
+ * @return The dot product, of the common type of the elements.
+ */
+template <typename InputIt1, typename InputIt2>
+auto dot(const MultiIterator<InputIt1, InputIt2> &first,
+         const MultiIterator<InputIt1, InputIt2> &last) {
+  return dot(std::get<0>(first.base()), std::get<0>(last.base()), std::get<1>(first.base()));
+}
+
+/**
+ * @brief Computes the weighted mean of a range of elements as a T.
+ *
+ * This function calculates the sum of first1[i] * first2[i] divided by the sum
+ * of the weights first2[i], in a single pass over both ranges. Sums are
+ * computed as in sum_of_products() and the division is carried out in
+ * floating point if T is a floating point type.
+ *
+ * @tparam T The type of the result.
+ * @tparam InputIt1 Input iterator type for the values.
+ * @tparam InputIt2 Input iterator type for the weights.
+ *
+ * @param first1 The beginning of the values.
+ * @param last1 The end of the values.
+ * @param first2 The beginning of the weights.
+ *
+ * @return T The weighted mean, 0 if the weights sum to 0.
+ */
+template <typename T, typename InputIt1, typename InputIt2>
+T weighted_mean(InputIt1 first1, const InputIt1 last1, InputIt2 first2) {
+  return details::weighted_mean<T>(first1, last1, first2);
+}
+
+/**
+ * @brief Computes the weighted mean of a range of elements.
+ *
+ * @tparam InputIt1 Input iterator type for the values.
+ * @tparam InputIt2 Input iterator type for the weights.
+ *
+ * @param first1 The beginning of the values.
+ * @param last1 The end of the values.
+ * @param first2 The beginning of the weights.
+ *
+ * @return The weighted mean, of the common type of the values and weights, 0
+ * if the weights sum to 0.
+ *
+ * @note As for mean(), integral means are truncated towards zero.
+ */
+template <typename InputIt1, typename InputIt2>
+auto weighted_mean(InputIt1 first1, const InputIt1 last1, InputIt2 first2)
+    -> std::common_type_t<remove_cvref_t<decltype(*first1)>, remove_cvref_t<decltype(*first2)>> {
+  using result_type =
+      std::common_type_t<remove_cvref_t<decltype(*first1)>, remove_cvref_t<decltype(*first2)>>;
+  return weighted_mean<result_type>(first1, last1, first2);
+}
+
+/**
+ * @brief Computes the weighted mean of the (value, weight) pairs of a
+ * MultiIterator range.
+ *
+ * @tparam InputIt1 Type of the iterator over the values.
+ * @tparam InputIt2 Type of the iterator over the weights.
+ *
+ * @param first The beginning of the range.
+ * @param last The end of the range.
+ *
+ * @return The weighted mean, of the common type of the values and weights, 0
+ * if the weights sum to 0.
+ */
+template <typename InputIt1, typename InputIt2>
+auto weighted_mean(const MultiIterator<InputIt1, InputIt2> &first,
+                   const MultiIterator<InputIt1, InputIt2> &last) {
+  return weighted_mean(std::get<0>(first.base()), std::get<0>(last.base()),
+                       std::get<1>(first.base()));
+}
+
+/**
+ * @brief Computes the inclusive prefix sums of a range of elements.
+ *
+ * This function writes to d_first + i the sum of the elements of [first,
+ * first + i]. d_first may be equal to first.
+ *
+ * The running sum follows the widening rules of mean(): 64-bit integers for
+ * integral elements and at least double for floating point ones, each sum
+ * being converted to the destination type. Contiguous ranges of float or
+ * double into the same type, and of 32/64-bit signed integers into 64-bit
+ * ones, are scanned in SIMD registers; floating point results are
+ * bit-identical whatever the instruction set.
+ *
+ * @tparam InputIt Input iterator type for the range.
+ * @tparam OutputIt Output iterator type for the destination.
+ *
+ * @param first The beginning of the range.
+ * @param last The end of the range.
+ * @param d_first The beginning of the destination range.
+ *
+ * @return OutputIt Iterator past the last element written.
+ */
+template <typename InputIt, typename OutputIt>
+OutputIt inclusive_scan(InputIt first, const InputIt last, OutputIt d_first) {
+  using accumulator = details::sum_accumulator_t<remove_cvref_t<decltype(*first)>>;
+  return details::scan<false>(first, last, d_first, accumulator(0));
+}
+
+/**
+ * @brief Computes the exclusive prefix sums of a range of elements.
+ *
+ * This function writes to d_first + i init plus the sum of the elements of
+ * [first, first + i). d_first may be equal to first. The running sum is
+ * widened as in inclusive_scan(), to the common type of the widened element
+ * and init types.
+ *
+ * @tparam InputIt Input iterator type for the range.
+ * @tparam OutputIt Output iterator type for the destination.
+ * @tparam T The type of the initial value.
+ *
+ * @param first The beginning of the range.
+ * @param last The end of the range.
+ * @param d_first The beginning of the destination range.
+ * @param init The initial value of the running sum.
+ *
+ * @return OutputIt Iterator past the last element written.
+ */
+template <typename InputIt, typename OutputIt, typename T>
+OutputIt exclusive_scan(InputIt first, const InputIt last, OutputIt d_first, const T init) {
+  using accumulator = std::common_type_t<details::sum_accumulator_t<remove_cvref_t<decltype(*first)>>,
+                                         details::sum_accumulator_t<T>>;
+  return details::scan<true>(first, last, d_first, static_cast<accumulator>(init));
+}
+
+/**
+ * @brief Computes the inclusive prefix sums of a range of elements using an
+ * execution policy.
+ *
+ * With execution::parallel_policy the range is cut into chunks of a fixed
+ * size, the grain size of the policy if set: the chunks are summed in
+ * parallel, their offsets accumulated, then the chunks are scanned in
+ * parallel from their offsets. Results are identical from run to run whatever
+ * the number of threads, but depend on the grain size. They are equal to
+ * inclusive_scan(first, last, d_first) for integral elements only: the
+ * offsets of the chunks come from the pairwise sums of the chunks rather than
+ * from the sequential running sum, so floating point results differ from the
+ * sequential scan in the last bits.
+ *
+ * @tparam ExecutionPolicy execution::sequenced_policy or
+ * execution::parallel_policy.
+ * @tparam RandomIt1 Type of the random access iterator of the range.
+ * @tparam RandomIt2 Type of the random access iterator of the destination.
+ *
+ * @param policy The execution policy to use.
+ * @param first The beginning of the range.
+ * @param last The end of the range.
+ * @param d_first The beginning of the destination range.
+ *
+ * @return RandomIt2 Iterator past the last element written.
+ */
+template <typename ExecutionPolicy, typename RandomIt1, typename RandomIt2>
+std::enable_if_t<execution::is_execution_policy_v<remove_cvref_t<ExecutionPolicy>>, RandomIt2>
+inclusive_scan(ExecutionPolicy &&policy, RandomIt1 first, const RandomIt1 last, RandomIt2 d_first) {
+  if constexpr (std::is_same_v<remove_cvref_t<ExecutionPolicy>, execution::sequenced_policy>) {
+    return utils::inclusive_scan(first, last, d_first);
+  } else {
+    using accumulator = details::sum_accumulator_t<remove_cvref_t<decltype(*first)>>;
+    return details::scan<false>(policy, first, last, d_first, accumulator(0));
+  }
+}
+
+/**
+ * @brief Computes the exclusive prefix sums of a range of elements using an
+ * execution policy.
+ *
+ * Same as exclusive_scan(first, last, d_first, init), split as in
+ * inclusive_scan(policy, first, last, d_first): floating point results
+ * differ from the sequential scan in the last bits.
+ *
+ * @tparam ExecutionPolicy execution::sequenced_policy or
+ * execution::parallel_policy.
+ * @tparam RandomIt1 Type of the random access iterator of the range.
+ * @tparam RandomIt2 Type of the random access iterator of the destination.
+ * @tparam T The type of the initial value.
+ *
+ * @param policy The execution policy to use.
+ * @param first The beginning of the range.
+ * @param last The end of the range.
+ * @param d_first The beginning of the destination range.
+ * @param init The initial value of the running sum.
+ *
+ * @return RandomIt2 Iterator past the last element written.
+ */
+template <typename ExecutionPolicy, typename RandomIt1, typename RandomIt2, typename T>
+std::enable_if_t<execution::is_execution_policy_v<remove_cvref_t<ExecutionPolicy>>, RandomIt2>
+exclusive_scan(ExecutionPolicy &&policy, RandomIt1 first, const RandomIt1 last, RandomIt2 d_first,
+               const T init) {
+  if constexpr (std::is_same_v<remove_cvref_t<ExecutionPolicy>, execution::sequenced_policy>) {
+    return utils::exclusive_scan(first, last, d_first, init);
+  } else {
+    using accumulator = std::common_type_t<details::sum_accumulator_t<remove_cvref_t<decltype(*first)>>,
+                                           details::sum_accumulator_t<T>>;
+    return details::scan<true>(policy, first, last, d_first, static_cast<accumulator>(init));
+  }
+}
+
+/**
+ * @brief One-pass accumulator of count, mean, variance, minimum, maximum and
+ * argmax.
+ *
+ * Moments are computed in double (long double for long double elements) and
+ * combined with the pairwise update of Chan et al., the streaming counterpart
+ * of Welford's algorithm, so chunks and accumulators fed with disjoint parts
+ * of a sequence can be merged in any grouping. Contiguous ranges are consumed
+ * in cache sized blocks whose sum, maximum and minimum go through the SIMD
+ * kernels of mean() and argmax().
+ *
+ * NaN elements count towards the moments, which become NaN, but are skipped
+ * by the minimum, the maximum and argmax. Like argmax_accumulator, each
+ * accumulator tracks the global index of the next element so that argmax()
+ * refers to the whole sequence; ties go to the lowest index.
+ *
+ * @tparam T The arithmetic element type.
+ */
+template <typename T>
+class running_stats {
+  static_assert(std::is_arithmetic_v<T>, "running_stats requires an arithmetic type");
+
+public:
+  /**
+   * @brief Type of the mean and the variance.
+   */
+  using result_type = details::stats_accumulator_t<T>;
+
+  running_stats() = default;
+
+  /**
+   * @brief Constructs an accumulator whose first element has the given
+   * global index.
+   *
+   * @param offset Global index of the first element.
+   */
+  explicit running_stats(const std::size_t offset) noexcept : offset_{offset} {}
+
+  /**
+   * @brief Consumes one element.
+   *
+   * @param value The element.
+   */
+  void push(const T value) noexcept {
+    ++count_;
+    const auto delta{static_cast<result_type>(value) - mean_};
+    mean_ += delta / static_cast<result_type>(count_);
+    m2_ += delta * (static_cast<result_type>(value) - mean_);
+    if (!details::is_unordered(value)) {
+      observe_extrema(value, value, offset_);
+    }
+    ++offset_;
+  }
+
+  /**
+   * @brief Consumes the next chunk of elements.
+   *
+   * @tparam InputIt Type of the input iterator, whose elements are converted
+   * to T.
+   * @param first Iterator to the beginning of the chunk.
+   * @param last Iterator to the end of the chunk.
+   */
+  template <typename InputIt>
+  void update(InputIt first, const InputIt last) {
+    using value_type = typename std::iterator_traits<InputIt>::value_type;
+    if constexpr (is_contiguous_iterator_v<InputIt> &&
+                  std::is_same_v<std::remove_cv_t<value_type>, T>) {
+      const auto n{static_cast<std::size_t>(std::distance(first, last))};
+      if (!n) {
+        return;
+      }
+      const auto data{std::addressof(*first)};
+      for (std::size_t begin{0}; begin < n; begin += details::reduce_leaf_size) {
+        const auto size{std::min(details::reduce_leaf_size, n - begin)};
+        const auto block{details::block_stats(data + begin, size)};
+        merge_moments(size, block.mean, block.m2);
+        if (block.argmax != size) {
+          observe_extrema(block.min, data[begin + block.argmax], offset_ + block.argmax);
+        }
+        offset_ += size;
+      }
+    } else {
+      for (; first != last; ++first) {
+        push(static_cast<T>(*first));
+      }
+    }
+  }
+
+  /**
+   * @brief Combines the statistics of an accumulator fed with another part of
+   * the same sequence, which may come before or after this one.
+   *
+   * @param other The accumulator to merge into this one.
+   */
+  void merge(const running_stats &other) noexcept {
+    if (other.count_) {
+      merge_moments(other.count_, other.mean_, other.m2_);
+    }
+    if (other.has_extrema_) {
+      observe_extrema(other.min_, other.max_, other.argmax_);
+    }
+    offset_ = std::max(offset_, other.offset_);
+  }
+
+  /**
+   * @brief Returns the number of elements consumed.
+   */
+  std::size_t count() const noexcept { return count_; }
+
+  /**
+   * @brief Returns the mean of the elements, 0 if there is none.
+   */
+  result_type mean() const noexcept { return mean_; }
+
+  /**
+   * @brief Returns the population variance of the elements, 0 if there is
+   * none.
+   */
+  result_type variance() const noexcept {
+    return count_ ? m2_ / static_cast<result_type>(count_) : result_type(0);
+  }
+
+  /**
+   * @brief Returns the sample variance of the elements, 0 if there are fewer
+   * than two.
+   */
+  result_type sample_variance() const noexcept {
+    return count_ > 1 ? m2_ / static_cast<result_type>(count_ - 1) : result_type(0);
+  }
+
+  /**
+   * @brief Returns true if an element that is not NaN was consumed, that is
+   * if min(), max() and argmax() are meaningful.
+   */
+  bool has_extrema() const noexcept { return has_extrema_; }
+
+  /**
+   * @brief Returns the smallest element, T() if has_extrema() is false.
+   */
+  T min() const noexcept { return min_; }
+
+  /**
+   * @brief Returns the largest element, T() if has_extrema() is false.
+   */
+  T max() const noexcept { return max_; }
+
+  /**
+   * @brief Returns the global index of the first largest element, 0 if
+   * has_extrema() is false.
+   */
+  std::size_t argmax() const noexcept { return argmax_; }
+
+  /**
+   * @brief Returns the global index of the next element to be consumed.
+   */
+  std::size_t offset() const noexcept { return offset_; }
+
+private:
+  void merge_moments(const std::size_t count, const result_type mean,
+                     const result_type m2) noexcept {
+    if (!count_) {
+      count_ = count;
+      mean_ = mean;
+      m2_ = m2;
+      return;
+    }
+    const auto n_a{static_cast<result_type>(count_)};
+    const auto n_b{static_cast<result_type>(count)};
+    const auto n{n_a + n_b};
+    const auto delta{mean - mean_};
+    mean_ += delta * (n_b / n);
+    m2_ += m2 + delta * delta * (n_a * n_b / n);
+    count_ += count;
+  }
+
+  void observe_extrema(const T min, const T max, const std::size_t argmax) noexcept {
+    if (!has_extrema_) {
+      has_extrema_ = true;
+      min_ = min;
+      max_ = max;
+      argmax_ = argmax;
+      return;
+    }
+    if (min < min_) {
+      min_ = min;
+    }
+    if (max_ < max || (!(max < max_) && argmax < argmax_)) {
+      max_ = max;
+      argmax_ = argmax;
+    }
+  }
+
+  std::size_t offset_{0};
+  std::size_t count_{0};
+  result_type mean_{0};
+  result_type m2_{0};
+  bool has_extrema_{false};
+  T min_{};
+  T max_{};
+  std::size_t argmax_{0};
+};
+
+/**
+ * @brief Computes the statistics of a range of elements as T in one pass.
+ *
+ * Random access ranges are split into leaves of a fixed size whose statistics
+ * are merged pairwise along a tree that only depends on the length of the
+ * range, the same as stats(execution::par, first, last), which therefore
+ * returns the same result. Other ranges are consumed in order by
+ * running_stats::update().
+ *
+ * @tparam T The element type of the statistics.
+ * @tparam InputIt Input iterator type for the range.
+ *
+ * @param first The beginning of the range.
+ * @param last The end of the range.
+ *
+ * @return running_stats<T> The statistics of the elements in the range.
+ */
+template <typename T, typename InputIt>
+running_stats<T> stats(InputIt first, const InputIt last) {
+  if constexpr (std::is_base_of_v<std::random_access_iterator_tag,
+                                  typename std::iterator_traits<InputIt>::iterator_category>) {
+    const auto n{static_cast<std::size_t>(std::distance(first, last))};
+    if (!n) {
+      return running_stats<T>{};
+    }
+    auto leaf{details::stats_leaves<running_stats<T>>(first, n)};
+    details::merge_stats merge;
+    return details::tree_reduce(std::size_t{0}, details::reduce_leaf_count(n), leaf, merge);
+  } else {
+    running_stats<T> result;
+    result.update(first, last);
+    return result;
+  }
+}
+
+/**
+ * @brief Computes the statistics of a range of elements in one pass.
+ *
+ * @tparam InputIt Input iterator type for the range.
+ *
+ * @param first The beginning of the range.
+ * @param last The end of the range.
+ *
+ * @return running_stats<decltype(*first)> The statistics of the elements in
+ * the range.
+ */
+template <typename InputIt>
+auto stats(InputIt first, const InputIt last)
+    -> running_stats<remove_cvref_t<decltype(*first)>> {
+  return stats<remove_cvref_t<decltype(*first)>>(first, last);
+}
+
+/**
+ * @brief Computes the statistics of a range of elements as T using an
+ * execution policy.
+ *
+ * With execution::parallel_policy the range is split into leaves of a fixed
+ * size whose statistics are merged pairwise along a tree that only depends on
+ * the length of the range, so the result is identical from run to run
+ * whatever the number of threads, and equal to stats<T>(first, last).
+ *
+ * @tparam T The element type of the statistics.
+ * @tparam ExecutionPolicy execution::sequenced_policy or
+ * execution::parallel_policy.
+ * @tparam RandomIt Type of the random access iterator.
+ *
+ * @param policy The execution policy to use.
+ * @param first The beginning of the range.
+ * @param last The end of the range.
+ *
+ * @return running_stats<T> The statistics of the elements in the range.
+ */
+template <typename T, typename ExecutionPolicy, typename RandomIt>
+std::enable_if_t<execution::is_execution_policy_v<remove_cvref_t<ExecutionPolicy>>, running_stats<T>>
+stats(ExecutionPolicy &&policy, RandomIt first, const RandomIt last) {
+  if constexpr (std::is_same_v<remove_cvref_t<ExecutionPolicy>, execution::sequenced_policy>) {
+    return stats<T>(first, last);
+  } else {
+    const auto n{static_cast<std::size_t>(std::distance(first, last))};
+    if (!n) {
+      return running_stats<T>{};
+    }
+    return details::tree_reduce(policy, details::reduce_leaf_count(n),
+                                details::stats_leaves<running_stats<T>>(first, n),
+                                details::merge_stats{});
+  }
+}
+
+/**
+ * @brief Computes the statistics of a range of elements using an execution
+ * policy.
+ *
+ * Same as stats<T>(policy, first, last) with T the element type of the range.
+ *
+ * @tparam ExecutionPolicy execution::sequenced_policy or
+ * execution::parallel_policy.
+ * @tparam RandomIt Type of the random access iterator.
+ *
+ * @param policy The execution policy to use.
+ * @param first The beginning of the range.
+ * @param last The end of the range.
+ *
+ * @return running_stats<decltype(*first)> The statistics of the elements in
+ * the range.
+ */
+template <typename ExecutionPolicy, typename RandomIt>
+auto stats(ExecutionPolicy &&policy, RandomIt first, const RandomIt last)
+    -> std::enable_if_t<execution::is_execution_policy_v<remove_cvref_t<ExecutionPolicy>>,
+                        running_stats<remove_cvref_t<decltype(*first)>>> {
+  return stats<remove_cvref_t<decltype(*first)>>(std::forward<ExecutionPolicy>(policy), first,
+                                                  last);
+}
+
+/**
+ * @brief Mergeable streaming quantile sketch of bounded size (KLL).
+ *
+ * Elements are kept in a hierarchy of compactors: when the sketch is full,
+ * the lowest full level is sorted and every other element is promoted to the
+ * next level with twice the weight. With parameter k the sketch holds about
+ * 3k elements and the rank of a returned quantile is within about 1.7 / k of
+ * the requested one; k = 200 keeps a few KB per sketch.
+ *
+ * Compaction offsets come from a generator with a fixed seed, so a sketch fed
+ * with the same elements in the same order always gives the same answers.
+ * NaN elements are ignored. The minimum and the maximum are exact.
+ *
+ * @tparam T The arithmetic element type.
+ */
+template <typename T>
+class quantile_sketch {
+  static_assert(std::is_arithmetic_v<T>, "quantile_sketch requires an arithmetic type");
+
+public:
+  /**
+   * @brief Default accuracy parameter.
+   */
+  static constexpr std::size_t default_k{details::kll_default_k};
+
+  /**
+   * @brief Constructs an empty sketch.
+   *
+   * @param k Accuracy parameter, at least 8.
+   */
+  explicit quantile_sketch(const std::size_t k = default_k)
+      : k_{std::max(k, details::kll_min_capacity)}, levels_(1),
+        capacity_{details::kll_total_capacity(k_, 1)} {}
+
+  /**
+   * @brief Inserts one element.
+   *
+   * @param value The element.
+   */
+  void insert(const T value) {
+    if (details::is_unordered(value)) {
+      return;
+    }
+    if (!count_ || value < min_) {
+      min_ = value;
+    }
+    if (!count_ || max_ < value) {
+      max_ = value;
+    }
+    ++count_;
+    levels_[0].push_back(value);
+    if (++size_ > capacity_) {
+      compress();
+    }
+  }
+
+  /**
+   * @brief Inserts the elements of a range.
+   *
+   * @tparam InputIt Type of the input iterator, whose elements are converted
+   * to T.
+   * @param first Iterator to the beginning of the range.
+   * @param last Iterator to the end of the range.
+   */
+  template <typename InputIt>
+  void insert(InputIt first, const InputIt last) {
+    for (; first != last; ++first) {
+      insert(static_cast<T>(*first));
+    }
+  }
+
+  /**
+   * @brief Adds the elements summarized by another sketch to this one.
+   *
+   * @param other The sketch to merge into this one.
+   */
+  void merge(const quantile_sketch &other) {
+    if (!other.count_) {
+      return;
+    }
+    if (!count_ || other.min_ < min_) {
+      min_ = other.min_;
+    }
+    if (!count_ || max_ < other.max_) {
+      max_ = other.max_;
+    }
+    count_ += other.count_;
+    if (levels_.size() < other.levels_.size()) {
+      levels_.resize(other.levels_.size());
+      capacity_ = details::kll_total_capacity(k_, levels_.size());
+    }
+    for (std::size_t level{0}; level < other.levels_.size(); ++level) {
+      levels_[level].insert(levels_[level].end(), other.levels_[level].begin(),
+                            other.levels_[level].end());
+      size_ += other.levels_[level].size();
+    }
+    while (size_ > capacity_) {
+      compress();
+    }
+  }
+
+  /**
+   * @brief Returns the number of elements inserted.
+   */
+  std::size_t count() const noexcept { return count_; }
+
+  /**
+   * @brief Returns true if no element was inserted.
+   */
+  bool empty() const noexcept { return !count_; }
+
+  /**
+   * @brief Returns the smallest element, T() if the sketch is empty.
+   */
+  T min() const noexcept { return min_; }
+
+  /**
+   * @brief Returns the largest element, T() if the sketch is empty.
+   */
+  T max() const noexcept { return max_; }
+
+  /**
+   * @brief Returns an element whose rank is approximately q * count().
+   *
+   * @param q The quantile, in [0, 1]: 0 gives min(), 1 gives max().
+   * @return The quantile, T() if the sketch is empty.
+   */
+  T quantile(const double q) const {
+    T result{};
+    quantiles(&q, &q + 1, &result);
+    return result;
+  }
+
+  /**
+   * @brief Writes the quantiles for a range of ranks, sorting the sketch only
+   * once.
+   *
+   * @tparam InputIt Type of the input iterator over the quantiles in [0, 1].
+   * @tparam OutputIt Type of the output iterator, accepting T.
+   * @param first Iterator to the beginning of the quantiles.
+   * @param last Iterator to the end of the quantiles.
+   * @param d_first Iterator to the beginning of the destination range.
+   * @return Iterator past the last quantile written.
+   */
+  template <typename InputIt, typename OutputIt>
+  OutputIt quantiles(InputIt first, const InputIt last, OutputIt d_first) const {
+    const auto items{weighted_items()};
+    for (; first != last; ++first, ++d_first) {
+      const double q{*first};
+      if (!count_) {
+        *d_first = T{};
+      } else if (q <= 0.0) {
+        *d_first = min_;
+      } else if (q >= 1.0) {
+        *d_first = max_;
+      } else {
+        const auto target{q * static_cast<double>(count_)};
+        std::size_t cumulative{0};
+        auto it{items.begin()};
+        for (; it != items.end() - 1; ++it) {
+          cumulative += it->second;
+          if (static_cast<double>(cumulative) >= target) {
+            break;
+          }
+        }
+        *d_first = it->first;
+      }
+    }
+    return d_first;
+  }
+
+  /**
+   * @brief Returns the approximate fraction of the elements that are less
+   * than or equal to value.
+   */
+  double rank(const T value) const {
+    if (!count_) {
+      return 0.0;
+    }
+    std::size_t weight{0};
+    for (std::size_t level{0}; level < levels_.size(); ++level) {
+      for (const auto &item : levels_[level]) {
+        if (!(value < item)) {
+          weight += std::size_t{1} << level;
+        }
+      }
+    }
+    return static_cast<double>(weight) / static_cast<double>(count_);
+  }
+
+private:
+  // Returns the retained elements with their weights, sorted by value.
+  std::vector<std::pair<T, std::size_t>> weighted_items() const {
+    std::vector<std::pair<T, std::size_t>> items;
+    items.reserve(size_);
+    for (std::size_t level{0}; level < levels_.size(); ++level) {
+      for (const auto &item : levels_[level]) {
+        items.emplace_back(item, std::size_t{1} << level);
+      }
+    }
+    std::sort(items.begin(), items.end(),
+              [](const auto &a, const auto &b) { return a.first < b.first; });
+    return items;
+  }
+
+  // Compacts the lowest level that reached its capacity.
+  void compress() {
+    for (std::size_t level{0}; level < levels_.size(); ++level) {
+      if (levels_[level].size() < details::kll_capacity(k_, levels_.size(), level)) {
+        continue;
+      }
+      if (level + 1 == levels_.size()) {
+        levels_.emplace_back();
+        capacity_ = details::kll_total_capacity(k_, levels_.size());
+      }
+      size_ -= details::kll_compact(levels_[level], levels_[level + 1],
+                                    details::kll_coin(random_state_));
+      return;
+    }
+  }
+
+  std::size_t k_;
+  std::vector<std::vector<T>> levels_;
+  std::size_t capacity_;
+  std::size_t size_{0};
+  std::size_t count_{0};
+  T min_{};
+  T max_{};
+  std::uint64_t random_state_{0x9e3779b97f4a7c15};
+};
+
+/**
+ * @brief Builds a quantile sketch of a range of elements as T.
+ *
+ * @tparam T The element type of the sketch.
+ * @tparam InputIt Input iterator type for the range.
+ *
+ * @param first The beginning of the range.
+ * @param last The end of the range.
+ * @param k Accuracy parameter of the sketch.
+ *
+ * @return quantile_sketch<T> The sketch of the elements in the range.
+ */
+template <typename T, typename InputIt>
+quantile_sketch<T> make_quantile_sketch(InputIt first, const InputIt last,
+                                        const std::size_t k = quantile_sketch<T>::default_k) {
+  quantile_sketch<T> sketch{k};
+  sketch.insert(first, last);
+  return sketch;
+}
+
+/**
+ * @brief Builds a quantile sketch of a range of elements.
+ *
+ * @tparam InputIt Input iterator type for the range.
+ *
+ * @param first The beginning of the range.
+ * @param last The end of the range.
+ * @param k Accuracy parameter of the sketch.
+ *
+ * @return quantile_sketch<decltype(*first)> The sketch of the elements in the
+ * range.
+ */
+template <typename InputIt>
+auto make_quantile_sketch(InputIt first, const InputIt last,
+                          const std::size_t k = details::kll_default_k)
+    -> quantile_sketch<remove_cvref_t<decltype(*first)>> {
+  return make_quantile_sketch<remove_cvref_t<decltype(*first)>>(first, last, k);
+}
+
+/**
+ * @brief Quantile sketch that many threads insert into, merged on read.
+ *
+ * Each thread inserts into one of several shards, each with its own lock and
+ * cache line, so that threads rarely contend; snapshot() merges the shards
+ * into a single quantile_sketch. Inserting ranges rather than single elements
+ * amortizes the lock.
+ *
+ * @tparam T The arithmetic element type.
+ */
+template <typename T>
+class sharded_quantile_sketch {
+public:
+  /**
+   * @brief Constructs an empty sketch.
+   *
+   * @param k Accuracy parameter of every shard.
+   * @param shards Number of shards, 0 means std::thread::hardware_concurrency().
+   */
+  explicit sharded_quantile_sketch(const std::size_t k = quantile_sketch<T>::default_k,
+                                   const std::size_t shards = 0)
+      : shard_count_{shards ? shards : execution::parallel_policy{}.threads()},
+        shards_{std::make_unique<shard[]>(shard_count_)} {
+    for (std::size_t i{0}; i < shard_count_; ++i) {
+      shards_[i].sketch = quantile_sketch<T>{k};
+    }
+  }
+
+  /**
+   * @brief Inserts one element into the shard of the calling thread.
+   */
+  void insert(const T value) {
+    auto &target{local_shard()};
+    std::lock_guard lock{target.mutex};
+    target.sketch.insert(value);
+  }
+
+  /**
+   * @brief Inserts the elements of a range into the shard of the calling
+   * thread.
+   */
+  template <typename InputIt>
+  void insert(InputIt first, const InputIt last) {
+    auto &target{local_shard()};
+    std::lock_guard lock{target.mutex};
+    target.sketch.insert(first, last);
+  }
+
+  /**
+   * @brief Returns the merge of all the shards.
+   */
+  quantile_sketch<T> snapshot() const {
+    quantile_sketch<T> result;
+    {
+      std::lock_guard lock{shards_[0].mutex};
+      result = shards_[0].sketch;
+    }
+    for (std::size_t i{1}; i < shard_count_; ++i) {
+      std::lock_guard lock{shards_[i].mutex};
+      result.merge(shards_[i].sketch);
+    }
+    return result;
+  }
+
+private:
+  struct alignas(64) shard {
+    mutable std::mutex mutex;
+    quantile_sketch<T> sketch;
+  };
+
+  shard &local_shard() const noexcept {
+    return shards_[details::thread_shard_index() % shard_count_];
+  }
+
+  std::size_t shard_count_;
+  std::unique_ptr<shard[]> shards_;
+};
+
 } // namespace utils
 
 #endif // NUMERICS_HPP
@@ -2,7 +2,10 @@
 #define TYPE_TRAITS_HPP
 
 #include <functional>
+#include <iterator>
+#include <string>
 #include <type_traits>
+#include <vector>
 
 namespace utils {
 /** @defgroup has_push_back_struct HasPushBack
@@ -112,6 +115,81 @@ using remove_cvref = std::remove_cv<std::remove_reference_t<T>>;
 template <typename T> using remove_cvref_t = typename remove_cvref<T>::type;
 /** @} */ // end of remove_cvref_alias
 
+/** @defgroup is_contiguous_iterator_struct IsContiguousIterator
+ * @{
+ */
+namespace details {
+template <typename It, typename V, typename = void>
+struct is_vector_iterator : std::false_type {};
+
+template <typename It, typename V>
+struct is_vector_iterator<
+    It, V, std::enable_if_t<std::is_object_v<V> && !std::is_same_v<V, bool>>>
+    : std::bool_constant<
+          std::is_same_v<It, typename std::vector<V>::iterator> ||
+          std::is_same_v<It, typename std::vector<V>::const_iterator>> {};
+
+template <typename It, typename V, typename = void>
+struct is_string_iterator : std::false_type {};
+
+template <typename It, typename V>
+struct is_string_iterator<
+    It, V,
+    std::enable_if_t<std::is_same_v<V, char> || std::is_same_v<V, wchar_t> ||
+                     std::is_same_v<V, char16_t> ||
+                     std::is_same_v<V, char32_t>>>
+    : std::bool_constant<
+          std::is_same_v<It, typename std::basic_string<V>::iterator> ||
+          std::is_same_v<It, typename std::basic_string<V>::const_iterator>> {};
+} // namespace details
+
+/**
+ * @brief Trait to check if an iterator refers to contiguous storage.
+ *
+ * C++17 has no contiguous iterator category, so this primary template only
+ * recognises raw pointers. The iterator is treated as contiguous when
+ * `std::addressof(*it) + n == std::addressof(*(it + n))` holds for every valid
+ * `n`.
+ *
+ * @tparam It The iterator type to check.
+ * @tparam Ignored A parameter to enable SFINAE, defaults to void.
+ */
+template <typename It, typename = void>
+struct is_contiguous_iterator : std::is_pointer<It> {};
+
+/**
+ * @brief Specialization of is_contiguous_iterator for iterators with a value
+ * type.
+ *
+ * Recognises raw pointers and the iterators of std::vector (except
+ * std::vector<bool>) and std::basic_string with the default allocator.
+ *
+ * @tparam It The iterator type to check.
+ */
+template <typename It>
+struct is_contiguous_iterator<
+    It, std::void_t<typename std::iterator_traits<It>::value_type>>
+    : std::bool_constant<
+          std::is_pointer_v<It> ||
+          details::is_vector_iterator<
+              It, typename std::iterator_traits<It>::value_type>::value ||
+          details::is_string_iterator<
+              It, typename std::iterator_traits<It>::value_type>::value> {};
+
+/**
+ * @brief Helper variable template to check if an iterator refers to
+ * contiguous storage.
+ *
+ * It is equivalent to is_contiguous_iterator<It>::value.
+ *
+ * @tparam It The iterator type to check.
+ */
+template <typename It>
+inline constexpr bool is_contiguous_iterator_v =
+    is_contiguous_iterator<It>::value;
+
+/** @} */ // end of is_contiguous_iterator_struct
+
 /** @defgroup invoke_or_return InvokeOrReturn
  * @{
  */
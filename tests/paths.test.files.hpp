@@ -3,5 +3,6 @@
 
 const char* const kDirPath{"/Users/pawel/Documents/Programowanie/CLionProjects/libutils/tests/test_files/dir"};
 const char* const kDirEmptyPath{"/Users/pawel/Documents/Programowanie/CLionProjects/libutils/tests/test_files/dir_empty"};
+const char* const kTreePath{"/Users/pawel/Documents/Programowanie/CLionProjects/libutils/tests/test_files/tree"};
 
 #endif
@@ -1,4 +1,11 @@
 #include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <list>
+#include <numeric>
+#include <random>
+#include <string>
 #include <vector>
 
 #include <libutils/algorithm.hpp>
@@ -39,6 +46,137 @@ TEST(Argmax, NegativeNumbers) {
     EXPECT_EQ(result, 0);
 }
 
+TEST(Argmax, NonContiguousRange) {
+    const std::list l{3, 9, 1, 9};
+    const auto result{utils::argmax(l.begin(), l.end())};
+    EXPECT_EQ(result, 1);
+}
+
+/**
+ * Runs a test body once for every SIMD level up to the one the CPU supports.
+ */
+template<typename F>
+void for_each_simd_level(F f) {
+    using utils::details::simd_level;
+    for (const auto level: {simd_level::scalar, simd_level::sse42, simd_level::avx2, simd_level::avx512}) {
+        utils::details::limit_simd_level(level);
+        f();
+    }
+    utils::details::limit_simd_level(simd_level::avx512);
+}
+
+template<typename T>
+std::vector<T> random_vector(const std::size_t n, const unsigned seed) {
+    std::mt19937 gen{seed};
+    std::vector<T> v(n);
+    if constexpr (std::is_floating_point_v<T>) {
+        std::uniform_real_distribution<T> dist{-1000, 1000};
+        for (auto &e: v) { e = dist(gen); }
+    } else {
+        std::uniform_int_distribution<T> dist{-1000, 1000};
+        for (auto &e: v) { e = dist(gen); }
+    }
+    return v;
+}
+
+template<typename T>
+void expect_argmax_matches_max_element() {
+    for (const std::size_t n: {1, 3, 17, 64, 255, 1000, 4099}) {
+        const auto v{random_vector<T>(n, static_cast<unsigned>(n))};
+        const auto expected{static_cast<std::size_t>(std::distance(v.begin(), std::max_element(v.begin(), v.end())))};
+        EXPECT_EQ(utils::argmax(v.begin(), v.end()), expected);
+        EXPECT_EQ(utils::argmax(v.data(), v.data() + v.size()), expected);
+    }
+}
+
+TEST(Argmax, MatchesMaxElementOnEverySimdLevel) {
+    for_each_simd_level([] {
+        expect_argmax_matches_max_element<float>();
+        expect_argmax_matches_max_element<double>();
+        expect_argmax_matches_max_element<std::int32_t>();
+        expect_argmax_matches_max_element<std::int64_t>();
+    });
+}
+
+TEST(Argmax, FirstMaximumWinsAcrossLanes) {
+    for_each_simd_level([] {
+        std::vector<float> v(1000, 1.0f);
+        v[700] = 5.0f;
+        v[37] = 5.0f;
+        v[999] = 5.0f;
+        EXPECT_EQ(utils::argmax(v.begin(), v.end()), 37);
+    });
+}
+
+TEST(Argmax, NaNIsSkipped) {
+    for_each_simd_level([] {
+        std::vector<double> v(100, 0.0);
+        v[10] = std::numeric_limits<double>::quiet_NaN();
+        v[50] = 2.0;
+        v[60] = std::numeric_limits<double>::quiet_NaN();
+        EXPECT_EQ(utils::argmax(v.begin(), v.end()), 50);
+    });
+}
+
+TEST(Argmax, LeadingNaNReturnsZero) {
+    for_each_simd_level([] {
+        std::vector<float> v(100, 1.0f);
+        v[0] = std::numeric_limits<float>::quiet_NaN();
+        v[42] = 3.0f;
+        EXPECT_EQ(utils::argmax(v.begin(), v.end()), 0);
+    });
+}
+
+TEST(Argmax, ExtremeIntegers) {
+    for_each_simd_level([] {
+        std::vector<std::int64_t> v(77, std::numeric_limits<std::int64_t>::min());
+        EXPECT_EQ(utils::argmax(v.begin(), v.end()), 0);
+        v[76] = std::numeric_limits<std::int64_t>::max();
+        EXPECT_EQ(utils::argmax(v.begin(), v.end()), 76);
+    });
+}
+
+/**
+ * ParallelArgmax tests.
+ */
+
+TEST(ParallelArgmax, MatchesSequential) {
+    //! [argmax_parallel_start]
+    const auto v{random_vector<float>(1'000'003, 7)};
+    const auto result{utils::argmax(utils::execution::parallel_policy{8, 4096}, v.begin(), v.end())};
+    //! [argmax_parallel_end]
+    EXPECT_EQ(result, utils::argmax(v.begin(), v.end()));
+}
+
+TEST(ParallelArgmax, TiesGoToLowestIndex) {
+    std::vector<std::int32_t> v(100'000, 1);
+    v[99'999] = 9;
+    v[50'000] = 9;
+    v[20'001] = 9;
+    EXPECT_EQ(utils::argmax(utils::execution::parallel_policy{8, 1000}, v.begin(), v.end()), 20'001);
+}
+
+TEST(ParallelArgmax, NaNRules) {
+    std::vector<double> v(10'000, 1.0);
+    v[5'000] = std::numeric_limits<double>::quiet_NaN();
+    v[5'001] = 4.0;
+    const utils::execution::parallel_policy policy{4, 5'000};
+    EXPECT_EQ(utils::argmax(policy, v.begin(), v.end()), 5'001);
+    v[0] = std::numeric_limits<double>::quiet_NaN();
+    EXPECT_EQ(utils::argmax(policy, v.begin(), v.end()), 0);
+}
+
+TEST(ParallelArgmax, NonContiguousAndSequenced) {
+    const std::vector v{3, 1, 4, 1, 5, 9, 2, 6};
+    EXPECT_EQ(utils::argmax(utils::execution::parallel_policy{3, 2}, v.begin(), v.end()), 5);
+    EXPECT_EQ(utils::argmax(utils::execution::seq, v.begin(), v.end()), 5);
+}
+
+TEST(ParallelArgmax, EmptyRange) {
+    const std::vector<float> v{};
+    EXPECT_EQ(utils::argmax(utils::execution::par, v.begin(), v.end()), 0);
+}
+
 /**
  * ArgmaxConditional tests.
  */
@@ -80,6 +218,45 @@ TEST(ArgmaxConditional, MultipleElementsSatisfyPredicate) {
     EXPECT_EQ(result, std::make_pair(true, static_cast<std::size_t>(4)));
 }
 
+/**
+ * ParallelArgmaxConditional tests.
+ */
+
+TEST(ParallelArgmaxConditional, MatchesSequential) {
+    const auto v1{random_vector<std::int64_t>(100'000, 3)};
+    const auto v2{random_vector<std::int32_t>(100'000, 4)};
+    const auto p{[](const std::int32_t x) { return x % 3 == 0; }};
+    const utils::execution::parallel_policy policy{8, 999};
+    EXPECT_EQ(utils::argmax_conditional(policy, v1.begin(), v1.end(), v2.begin(), p),
+              utils::argmax_conditional(v1.begin(), v1.end(), v2.begin(), p));
+}
+
+TEST(ParallelArgmaxConditional, NoElementSatisfiesPredicate) {
+    const std::vector v1{1, 3, 5, 7, 9};
+    const std::vector v2{0, 0, 0, 0, 0};
+    const auto result{utils::argmax_conditional(utils::execution::parallel_policy{2, 1}, v1.begin(), v1.end(),
+                                                v2.begin(), [](const int x) { return x == 1; })};
+    EXPECT_EQ(result, std::make_pair(false, static_cast<std::size_t>(5)));
+}
+
+TEST(ParallelArgmaxConditional, LeadingEligibleNaNIsKept) {
+    std::vector<float> v1(1'000, 1.0f);
+    std::vector<int> v2(1'000, 0);
+    v1[300] = std::numeric_limits<float>::quiet_NaN();
+    v2[300] = 1;
+    v1[800] = 5.0f;
+    v2[800] = 1;
+    const auto p{[](const int x) { return x == 1; }};
+    const utils::execution::parallel_policy policy{4, 100};
+    EXPECT_EQ(utils::argmax_conditional(policy, v1.begin(), v1.end(), v2.begin(), p),
+              utils::argmax_conditional(v1.begin(), v1.end(), v2.begin(), p));
+    v2[100] = 1;
+    v1[700] = std::numeric_limits<float>::quiet_NaN();
+    v2[700] = 1;
+    EXPECT_EQ(utils::argmax_conditional(policy, v1.begin(), v1.end(), v2.begin(), p),
+              std::make_pair(true, static_cast<std::size_t>(800)));
+}
+
 /**
  * CopyRangeNTimes tests.
  */
@@ -113,6 +290,94 @@ TEST(CopyRangeNTimes, HandlesEmptySourceRange) {
     EXPECT_EQ(result, destination.end());
 }
 
+template<typename T>
+std::vector<T> naive_repeat(const std::vector<T> &source, const std::size_t n) {
+    std::vector<T> expected;
+    for (std::size_t i{0}; i < n; ++i) {
+        expected.insert(expected.end(), source.begin(), source.end());
+    }
+    return expected;
+}
+
+TEST(CopyRangeNTimes, DoublingMatchesNaiveCopies) {
+    const auto source{random_vector<short>(7, 1)};
+    for (const std::size_t n: {2, 3, 5, 64, 1000, 12345}) {
+        std::vector<short> destination(source.size() * n);
+        const auto result{utils::copy_range_n_times(source.begin(), source.end(), destination.begin(), n)};
+        EXPECT_EQ(destination, naive_repeat(source, n)) << "n = " << n;
+        EXPECT_EQ(result, destination.end());
+    }
+}
+
+TEST(CopyRangeNTimes, NonTemporalPathMatchesNaiveCopies) {
+    auto &threshold{utils::details::nontemporal_threshold()};
+    const auto saved{threshold.load()};
+    threshold = 0;
+    for (const std::size_t size: {1, 13, 4099, 20000}) {
+        const auto source{random_vector<double>(size, 2)};
+        const std::size_t n{300000 / size + 3};
+        for_each_simd_level([&] {
+            std::vector<double> destination(size * n + 1, -1.0);
+            utils::copy_range_n_times(source.data(), source.data() + size, destination.data() + 1, n);
+            EXPECT_EQ(destination.front(), -1.0);
+            EXPECT_TRUE(std::equal(destination.begin() + 1, destination.end(),
+                                   naive_repeat(source, n).begin())) << "size = " << size;
+        });
+    }
+    threshold = saved;
+}
+
+TEST(CopyRangeNTimes, NonTrivialAndNonContiguousRanges) {
+    const std::vector<std::string> source{"a", "bc"};
+    std::vector<std::string> destination(6);
+    utils::copy_range_n_times(source.begin(), source.end(), destination.begin(), 3);
+    EXPECT_EQ(destination, naive_repeat(source, 3));
+    const std::list l{1, 2};
+    std::vector<int> out;
+    utils::copy_range_n_times(l.begin(), l.end(), std::back_inserter(out), 2);
+    EXPECT_EQ(out, (std::vector{1, 2, 1, 2}));
+}
+
+TEST(ParallelCopyRangeNTimes, MatchesSequential) {
+    //! [copy_range_n_times_parallel_start]
+    const std::vector source{1, 2, 3};
+    std::vector<int> destination(3 * 100000);
+    const auto result{utils::copy_range_n_times(utils::execution::par, source.begin(), source.end(),
+                                                destination.begin(), 100000)};
+    //! [copy_range_n_times_parallel_end]
+    EXPECT_EQ(destination, naive_repeat(source, 100000));
+    EXPECT_EQ(result, destination.end());
+}
+
+TEST(ParallelCopyRangeNTimes, SlicesSplitInsideCopies) {
+    auto &threshold{utils::details::nontemporal_threshold()};
+    const auto saved{threshold.load()};
+    const auto source{random_vector<std::int32_t>(1001, 3)};
+    const std::size_t n{777};
+    for (const std::size_t nt_threshold: {saved, std::size_t{0}}) {
+        threshold = nt_threshold;
+        std::vector<std::int32_t> destination(source.size() * n);
+        utils::copy_range_n_times(utils::execution::parallel_policy{4, 12345}, source.begin(), source.end(),
+                                  destination.begin(), n);
+        EXPECT_EQ(destination, naive_repeat(source, n));
+    }
+    threshold = saved;
+}
+
+TEST(ParallelCopyRangeNTimes, NonTrivialAndSequenced) {
+    const std::vector<std::string> source{"x", "yz", "w"};
+    std::vector<std::string> destination(3 * 50);
+    utils::copy_range_n_times(utils::execution::parallel_policy{3, 4}, source.begin(), source.end(),
+                              destination.begin(), 50);
+    EXPECT_EQ(destination, naive_repeat(source, 50));
+    std::vector<std::string> sequenced(3 * 50);
+    utils::copy_range_n_times(utils::execution::seq, source.begin(), source.end(), sequenced.begin(), 50);
+    EXPECT_EQ(sequenced, destination);
+    std::vector<std::string> empty;
+    EXPECT_EQ(utils::copy_range_n_times(utils::execution::par, source.begin(), source.end(), empty.begin(), 0),
+              empty.begin());
+}
+
 /**
  * MaxElementConditional tests.
  */
@@ -151,6 +416,477 @@ TEST(MaxElementConditional, SingleElementSatisfiesPredicate) {
     EXPECT_EQ(*result, 1);
 }
 
+TEST(MaxElementConditional, TakesFirstOfEqualMaxima) {
+    const std::vector v1{4, 9, 2, 9, 9};
+    const std::vector v2{1, 0, 1, 1, 1};
+    const auto result{
+            utils::max_element_conditional(v1.begin(), v1.end(), v2.begin(), [](const int x) { return x == 1; })};
+    EXPECT_EQ(result, v1.begin() + 3);
+}
+
+TEST(MaxElementConditional, NonArithmeticElements) {
+    const std::vector<std::string> v1{"b", "d", "c", "a"};
+    const std::vector v2{true, false, true, true};
+    const auto result{utils::max_element_conditional(v1.begin(), v1.end(), v2.begin(), [](const bool x) { return x; })};
+    EXPECT_EQ(result, v1.begin() + 2);
+}
+
+/**
+ * Builds a packed bitmask from a vector of flags.
+ */
+std::vector<std::uint64_t> pack_mask(const std::vector<int> &flags) {
+    std::vector<std::uint64_t> mask((flags.size() + 63) / 64);
+    for (std::size_t i{0}; i < flags.size(); ++i) {
+        if (flags[i]) { mask[i / 64] |= std::uint64_t{1} << (i % 64); }
+    }
+    return mask;
+}
+
+/**
+ * MaxElementConditionalBitmask tests.
+ */
+
+TEST(MaxElementConditionalBitmask, FindsMaxElementWithMask) {
+    //! [max_element_conditional_bitmask_start]
+    const std::vector v{1, 3, 5, 7, 9};
+    const std::uint64_t mask[]{0b01010};
+    const auto result{utils::max_element_conditional(v.begin(), v.end(), mask)};
+    //! [max_element_conditional_bitmask_end]
+    EXPECT_EQ(*result, 7);
+}
+
+template<typename T>
+void expect_bitmask_matches_predicate() {
+    for (const std::size_t n: {1, 5, 63, 64, 65, 200, 1000, 4097}) {
+        const auto v{random_vector<T>(n, static_cast<unsigned>(n))};
+        auto flags{random_vector<int>(n, static_cast<unsigned>(n + 1))};
+        for (auto &f: flags) { f = f % 3 == 0; }
+        const auto mask{pack_mask(flags)};
+        const auto expected{utils::argmax_conditional(v.begin(), v.end(), flags.begin(),
+                                                      [](const int x) { return x == 1; })};
+        EXPECT_EQ(utils::argmax_conditional(v.begin(), v.end(), mask.data()), expected);
+        EXPECT_EQ(utils::argmax_conditional(v.data(), v.data() + v.size(), mask.data()), expected);
+    }
+}
+
+TEST(MaxElementConditionalBitmask, MatchesPredicateOnEverySimdLevel) {
+    for_each_simd_level([] {
+        expect_bitmask_matches_predicate<float>();
+        expect_bitmask_matches_predicate<double>();
+        expect_bitmask_matches_predicate<std::int32_t>();
+        expect_bitmask_matches_predicate<std::int64_t>();
+    });
+}
+
+TEST(MaxElementConditionalBitmask, NoBitSet) {
+    const std::vector v(300, 1.0f);
+    const std::vector<std::uint64_t> mask(5, 0);
+    EXPECT_EQ(utils::max_element_conditional(v.begin(), v.end(), mask.data()), v.end());
+    EXPECT_EQ(utils::argmax_conditional(v.begin(), v.end(), mask.data()),
+              std::make_pair(false, static_cast<std::size_t>(300)));
+}
+
+TEST(MaxElementConditionalBitmask, SparseMaskAndTies) {
+    for_each_simd_level([] {
+        std::vector<std::int32_t> v(1000, 5);
+        v[10] = 100;
+        std::vector<int> flags(1000, 0);
+        flags[700] = flags[130] = flags[999] = 1;
+        const auto mask{pack_mask(flags)};
+        EXPECT_EQ(utils::argmax_conditional(v.begin(), v.end(), mask.data()),
+                  std::make_pair(true, static_cast<std::size_t>(130)));
+    });
+}
+
+TEST(MaxElementConditionalBitmask, NaNRules) {
+    for_each_simd_level([] {
+        std::vector<float> v(500, 1.0f);
+        std::vector<int> flags(500, 1);
+        v[0] = std::numeric_limits<float>::quiet_NaN();
+        v[400] = 2.0f;
+        EXPECT_EQ(utils::argmax_conditional(v.begin(), v.end(), pack_mask(flags).data()).second, 0);
+        flags[0] = 0;
+        v[3] = std::numeric_limits<float>::quiet_NaN();
+        EXPECT_EQ(utils::argmax_conditional(v.begin(), v.end(), pack_mask(flags).data()).second, 400);
+    });
+}
+
+TEST(MaxElementConditionalBitmask, NonContiguousRange) {
+    const std::list l{4, 8, 6, 2};
+    const std::uint64_t mask[]{0b1101};
+    EXPECT_EQ(*utils::max_element_conditional(l.begin(), l.end(), mask), 6);
+}
+
+/**
+ * SegmentedArgmax tests.
+ */
+
+TEST(SegmentedArgmax, FindsArgmaxOfEverySegment) {
+    //! [segmented_argmax_start]
+    const std::vector values{3, 7, 5, 2, 9, 9, 4};
+    const std::vector<std::size_t> offsets{0, 3, 3, 7};
+    std::vector<std::size_t> indices;
+    utils::segmented_argmax(values.begin(), offsets.begin(), offsets.end(), std::back_inserter(indices));
+    //! [segmented_argmax_end]
+    EXPECT_EQ(indices, (std::vector<std::size_t>{1, 0, 1}));
+}
+
+/**
+ * Returns CSR offsets of segments with random lengths, including empty and
+ * long ones.
+ */
+std::vector<std::size_t> random_offsets(const std::size_t segments, const unsigned seed) {
+    std::mt19937 gen{seed};
+    std::vector<std::size_t> offsets{0};
+    for (std::size_t s{0}; s < segments; ++s) {
+        const auto kind{std::uniform_int_distribution<int>{0, 9}(gen)};
+        const std::size_t max_length{kind == 0 ? 0u : kind == 1 ? 300u : 40u};
+        offsets.push_back(offsets.back() + std::uniform_int_distribution<std::size_t>{0, max_length}(gen));
+    }
+    return offsets;
+}
+
+template<typename T>
+void expect_segmented_argmax_matches_argmax(std::vector<T> values, const std::vector<std::size_t> &offsets) {
+    if (values.size() > 10) {
+        values[offsets[5]] = static_cast<T>(std::numeric_limits<T>::quiet_NaN());
+        values[offsets[7] + 1] = static_cast<T>(std::numeric_limits<T>::quiet_NaN());
+    }
+    std::vector<std::size_t> expected;
+    for (std::size_t s{0}; s + 1 < offsets.size(); ++s) {
+        expected.push_back(utils::argmax(values.begin() + offsets[s], values.begin() + offsets[s + 1]));
+    }
+    for_each_simd_level([&] {
+        std::vector<std::size_t> indices(expected.size());
+        EXPECT_EQ(utils::segmented_argmax(values.begin(), offsets.begin(), offsets.end(), indices.begin()),
+                  indices.end());
+        EXPECT_EQ(indices, expected);
+        std::fill(indices.begin(), indices.end(), 0);
+        utils::segmented_argmax(utils::execution::parallel_policy{4, 37}, values.begin(), offsets.begin(),
+                                offsets.end(), indices.begin());
+        EXPECT_EQ(indices, expected);
+    });
+}
+
+TEST(SegmentedArgmax, MatchesArgmaxPerSegment) {
+    const auto offsets{random_offsets(500, 33)};
+    expect_segmented_argmax_matches_argmax(random_vector<float>(offsets.back(), 34), offsets);
+    expect_segmented_argmax_matches_argmax(random_vector<double>(offsets.back(), 35), offsets);
+    expect_segmented_argmax_matches_argmax(random_vector<std::int32_t>(offsets.back(), 36), offsets);
+    expect_segmented_argmax_matches_argmax(random_vector<std::int64_t>(offsets.back(), 37), offsets);
+    expect_segmented_argmax_matches_argmax(random_vector<short>(offsets.back(), 38), offsets);
+}
+
+TEST(SegmentedArgmax, EmptySegmentsAndRanges) {
+    const std::vector<float> values;
+    const std::vector<std::size_t> offsets{0, 0, 0};
+    std::vector<std::size_t> indices;
+    utils::segmented_argmax(values.begin(), offsets.begin(), offsets.end(), std::back_inserter(indices));
+    EXPECT_EQ(indices, (std::vector<std::size_t>{0, 0}));
+    const std::vector<std::size_t> no_segments{0};
+    EXPECT_EQ(utils::segmented_argmax(values.begin(), no_segments.begin(), no_segments.end(), indices.begin()),
+              indices.begin());
+}
+
+TEST(RowwiseArgmax, FindsArgmaxOfEveryRow) {
+    //! [rowwise_argmax_start]
+    const std::vector matrix{1.0f, 4.0f, 2.0f, -1.0f,
+                             8.0f, 3.0f, 8.0f, -1.0f};
+    std::vector<std::size_t> indices(2);
+    utils::rowwise_argmax(matrix.begin(), 2, 3, 4, indices.begin());
+    //! [rowwise_argmax_end]
+    EXPECT_EQ(indices, (std::vector<std::size_t>{1, 0}));
+}
+
+TEST(RowwiseArgmax, MatchesArgmaxPerRow) {
+    for (const std::size_t cols: {1, 3, 16, 64, 65, 200}) {
+        const std::size_t rows{123};
+        const auto stride{cols + 5};
+        auto matrix{random_vector<float>(rows * stride, 39)};
+        matrix[7 * stride] = std::numeric_limits<float>::quiet_NaN();
+        std::vector<std::size_t> expected;
+        for (std::size_t r{0}; r < rows; ++r) {
+            expected.push_back(utils::argmax(matrix.begin() + r * stride, matrix.begin() + r * stride + cols));
+        }
+        for_each_simd_level([&] {
+            std::vector<std::size_t> indices(rows);
+            utils::rowwise_argmax(matrix.data(), rows, cols, stride, indices.begin());
+            EXPECT_EQ(indices, expected) << "cols = " << cols;
+            std::vector<std::size_t> parallel(rows);
+            utils::rowwise_argmax(utils::execution::parallel_policy{3, 10}, matrix.data(), rows, cols, stride,
+                                  parallel.begin());
+            EXPECT_EQ(parallel, expected) << "cols = " << cols;
+        });
+    }
+}
+
+TEST(RowwiseArgmax, NonContiguousMatrix) {
+    const std::list l{1, 5, 3, 9, 2, 2};
+    std::vector<std::size_t> indices;
+    utils::rowwise_argmax(l.begin(), 3, 2, 2, std::back_inserter(indices));
+    EXPECT_EQ(indices, (std::vector<std::size_t>{1, 1, 0}));
+}
+
+/**
+ * ArgmaxAccumulator tests.
+ */
+
+TEST(ArgmaxAccumulator, ConsumesChunks) {
+    //! [argmax_accumulator_start]
+    const std::vector chunk1{3.0, 8.0, 1.0};
+    const std::vector chunk2{9.0, 2.0};
+    utils::argmax_accumulator<double> accumulator;
+    accumulator.update(chunk1.begin(), chunk1.end());
+    accumulator.update(chunk2.begin(), chunk2.end());
+    const auto [found, index]{accumulator.result()};
+    //! [argmax_accumulator_end]
+    EXPECT_TRUE(found);
+    EXPECT_EQ(index, 3);
+    EXPECT_EQ(accumulator.value(), 9.0);
+    EXPECT_EQ(accumulator.offset(), 5);
+}
+
+/**
+ * Splits [0, n) at random positions, returning the chunk boundaries.
+ */
+std::vector<std::size_t> random_boundaries(const std::size_t n, const unsigned seed) {
+    std::mt19937 gen{seed};
+    std::vector<std::size_t> boundaries{0, n};
+    for (int i{0}; i < 8; ++i) {
+        boundaries.push_back(std::uniform_int_distribution<std::size_t>{0, n}(gen));
+    }
+    std::sort(boundaries.begin(), boundaries.end());
+    return boundaries;
+}
+
+template<typename T>
+void expect_chunked_argmax_matches_batch(const std::vector<T> &v) {
+    const auto boundaries{random_boundaries(v.size(), 23)};
+    for_each_simd_level([&] {
+        utils::argmax_accumulator<T> accumulator;
+        for (std::size_t c{0}; c + 1 < boundaries.size(); ++c) {
+            accumulator.update(v.begin() + boundaries[c], v.begin() + boundaries[c + 1]);
+        }
+        EXPECT_EQ(accumulator.result(), std::make_pair(true, utils::argmax(v.begin(), v.end())));
+    });
+}
+
+TEST(ArgmaxAccumulator, ChunkedMatchesBatch) {
+    expect_chunked_argmax_matches_batch(random_vector<float>(3000, 24));
+    expect_chunked_argmax_matches_batch(random_vector<std::int64_t>(3000, 25));
+    expect_chunked_argmax_matches_batch(random_vector<short>(3000, 26));
+    auto v{random_vector<double>(3000, 27)};
+    v[1500] = std::numeric_limits<double>::quiet_NaN();
+    expect_chunked_argmax_matches_batch(v);
+    v[0] = std::numeric_limits<double>::quiet_NaN();
+    expect_chunked_argmax_matches_batch(v);
+}
+
+TEST(ArgmaxAccumulator, ConditionalMatchesBatch) {
+    auto v{random_vector<float>(2000, 28)};
+    const auto flags{random_vector<int>(v.size(), 29)};
+    const auto p{[](const int f) { return f > 500; }};
+    std::vector<int> mask_flags(flags.size());
+    std::transform(flags.begin(), flags.end(), mask_flags.begin(), p);
+    const auto boundaries{random_boundaries(v.size(), 30)};
+    for (const bool leading_nan: {false, true}) {
+        if (leading_nan) {
+            v[std::find_if(flags.begin(), flags.end(), p) - flags.begin()] = std::numeric_limits<float>::quiet_NaN();
+        }
+        const auto expected{utils::argmax_conditional(v.begin(), v.end(), flags.begin(), p)};
+        for_each_simd_level([&] {
+            utils::argmax_accumulator<float> by_predicate;
+            utils::argmax_accumulator<float> by_mask;
+            for (std::size_t c{0}; c + 1 < boundaries.size(); ++c) {
+                const auto begin{boundaries[c]};
+                const auto end{boundaries[c + 1]};
+                by_predicate.update_conditional(v.begin() + begin, v.begin() + end, flags.begin() + begin, p);
+                const auto chunk_mask{pack_mask(std::vector<int>(mask_flags.begin() + begin,
+                                                                 mask_flags.begin() + end))};
+                by_mask.update_conditional(v.begin() + begin, v.begin() + end, chunk_mask.data());
+            }
+            EXPECT_EQ(by_predicate.result(), expected);
+            EXPECT_EQ(by_mask.result(), expected);
+        });
+    }
+}
+
+TEST(ArgmaxAccumulator, MergeInAnyOrder) {
+    auto v{random_vector<double>(4000, 31)};
+    v[2000] = std::numeric_limits<double>::quiet_NaN();
+    v[3999] = v[2500] = v[100] = 5000.0;
+    const auto boundaries{random_boundaries(v.size(), 32)};
+    std::vector<utils::argmax_accumulator<double>> parts;
+    for (std::size_t c{0}; c + 1 < boundaries.size(); ++c) {
+        parts.emplace_back(boundaries[c]);
+        parts.back().update(v.begin() + boundaries[c], v.begin() + boundaries[c + 1]);
+    }
+    std::reverse(parts.begin(), parts.end());
+    utils::argmax_accumulator<double> total;
+    for (const auto &part: parts) {
+        total.merge(part);
+    }
+    EXPECT_EQ(total.result(), std::make_pair(true, std::size_t{100}));
+    EXPECT_EQ(total.offset(), v.size());
+
+    v[boundaries[1]] = std::numeric_limits<double>::quiet_NaN();
+    utils::argmax_accumulator<double> first_part;
+    first_part.update(v.begin(), v.begin() + boundaries[1]);
+    utils::argmax_accumulator<double> nan_part{boundaries[1]};
+    nan_part.update(v.begin() + boundaries[1], v.end());
+    nan_part.merge(first_part);
+    EXPECT_EQ(nan_part.result(), std::make_pair(true, utils::argmax(v.begin(), v.end())));
+}
+
+TEST(ArgmaxAccumulator, EmptyAndNonContiguous) {
+    utils::argmax_accumulator<int> accumulator;
+    EXPECT_EQ(accumulator.result(), std::make_pair(false, std::size_t{0}));
+    const std::list l{4, 9, 9};
+    accumulator.update(l.begin(), l.end());
+    accumulator.update(l.begin(), l.begin());
+    EXPECT_EQ(accumulator.result(), std::make_pair(true, std::size_t{1}));
+}
+
+/**
+ * Argtopk tests.
+ */
+
+TEST(Argtopk, FindsIndicesOfLargestElements) {
+    //! [argtopk_start]
+    const std::vector v{4, 9, 1, 7, 9, 3};
+    std::vector<std::size_t> indices;
+    utils::argtopk(v.begin(), v.end(), 3, std::back_inserter(indices));
+    //! [argtopk_end]
+    EXPECT_EQ(indices, (std::vector<std::size_t>{1, 4, 3}));
+}
+
+/**
+ * Reference top-k: indices stably sorted by decreasing value, NaNs dropped.
+ */
+template<typename T>
+std::vector<std::size_t> reference_topk(const std::vector<T> &v, const std::size_t k) {
+    std::vector<std::size_t> indices;
+    for (std::size_t i{0}; i < v.size(); ++i) {
+        if (v[i] == v[i]) { indices.push_back(i); }
+    }
+    std::stable_sort(indices.begin(), indices.end(),
+                     [&v](const std::size_t a, const std::size_t b) { return v[b] < v[a]; });
+    indices.resize(std::min(k, indices.size()));
+    return indices;
+}
+
+template<typename T>
+void expect_argtopk_matches_reference() {
+    auto v{random_vector<T>(5003, 11)};
+    for (const std::size_t k: {1, 5, 64, 300, 2000, 5003}) {
+        for_each_simd_level([&] {
+            std::vector<std::size_t> result(k);
+            result.erase(utils::argtopk(v.begin(), v.end(), k, result.begin()), result.end());
+            EXPECT_EQ(result, reference_topk(v, k)) << "k = " << k;
+        });
+    }
+}
+
+TEST(Argtopk, MatchesReferenceOnEverySimdLevel) {
+    expect_argtopk_matches_reference<float>();
+    expect_argtopk_matches_reference<double>();
+    expect_argtopk_matches_reference<std::int32_t>();
+    expect_argtopk_matches_reference<std::int64_t>();
+    expect_argtopk_matches_reference<short>();
+}
+
+TEST(Argtopk, UnsortedOutputHoldsSameIndices) {
+    const auto v{random_vector<int>(4000, 5)};
+    for (const std::size_t k: {10, 1000}) {
+        std::vector<std::size_t> result;
+        utils::argtopk(v.begin(), v.end(), k, std::back_inserter(result), false);
+        std::sort(result.begin(), result.end());
+        auto expected{reference_topk(v, k)};
+        std::sort(expected.begin(), expected.end());
+        EXPECT_EQ(result, expected);
+    }
+}
+
+TEST(Argtopk, KLargerThanRangeAndZero) {
+    const std::vector v{2.0, 8.0, 5.0};
+    std::vector<std::size_t> result;
+    utils::argtopk(v.begin(), v.end(), 10, std::back_inserter(result));
+    EXPECT_EQ(result, (std::vector<std::size_t>{1, 2, 0}));
+    result.clear();
+    utils::argtopk(v.begin(), v.end(), 0, std::back_inserter(result));
+    EXPECT_TRUE(result.empty());
+}
+
+TEST(Argtopk, NaNsAreSkipped) {
+    auto v{random_vector<double>(1000, 3)};
+    v[0] = std::numeric_limits<double>::quiet_NaN();
+    v[500] = std::numeric_limits<double>::quiet_NaN();
+    for (const std::size_t k: {3, 999, 1000}) {
+        std::vector<std::size_t> result;
+        utils::argtopk(v.begin(), v.end(), k, std::back_inserter(result));
+        EXPECT_EQ(result, reference_topk(v, k));
+    }
+}
+
+TEST(Argtopk, LeadingNaNIsSkippedUnlikeArgmax) {
+    const double nan{std::numeric_limits<double>::quiet_NaN()};
+    const std::vector v{nan, 3.0, 1.0, 5.0};
+    EXPECT_EQ(utils::argmax(v.begin(), v.end()), 0);
+    for (const std::size_t k: {1, 2, 4}) {
+        std::vector<std::size_t> result;
+        utils::argtopk(v.begin(), v.end(), k, std::back_inserter(result));
+        ASSERT_FALSE(result.empty());
+        EXPECT_EQ(result[0], 3);
+        EXPECT_EQ(result.size(), std::min<std::size_t>(k, 3));
+    }
+}
+
+TEST(Argtopk, NonContiguousRange) {
+    const std::vector<std::string> v{"pear", "apple", "plum", "fig"};
+    std::vector<std::size_t> result;
+    utils::argtopk(v.begin(), v.end(), 2, std::back_inserter(result));
+    EXPECT_EQ(result, (std::vector<std::size_t>{2, 0}));
+}
+
+TEST(ArgtopkConditional, FindsIndicesOfLargestEligibleElements) {
+    //! [argtopk_conditional_start]
+    const std::vector v{4, 9, 1, 7, 9, 3};
+    const std::vector<bool> keep{true, false, true, true, true, true};
+    std::vector<std::size_t> indices;
+    utils::argtopk_conditional(v.begin(), v.end(), keep.begin(), 2,
+                               std::back_inserter(indices), [](bool b) { return b; });
+    //! [argtopk_conditional_end]
+    EXPECT_EQ(indices, (std::vector<std::size_t>{4, 3}));
+}
+
+TEST(ArgtopkConditional, LeadingNaNIsSkippedUnlikeArgmaxConditional) {
+    const float nan{std::numeric_limits<float>::quiet_NaN()};
+    const std::vector v{2.0f, nan, 3.0f, 1.0f, 5.0f};
+    const std::vector<bool> keep{false, true, true, true, true};
+    const auto is_kept{[](bool b) { return b; }};
+    EXPECT_EQ(utils::argmax_conditional(v.begin(), v.end(), keep.begin(), is_kept),
+              std::make_pair(true, std::size_t{1}));
+    std::vector<std::size_t> result;
+    utils::argtopk_conditional(v.begin(), v.end(), keep.begin(), 2, std::back_inserter(result), is_kept);
+    EXPECT_EQ(result, (std::vector<std::size_t>{4, 2}));
+}
+
+TEST(ArgtopkConditional, MatchesFilteredReference) {
+    const auto v{random_vector<float>(3000, 21)};
+    const auto flags{random_vector<int>(3000, 22)};
+    const auto p{[](const int f) { return f > 0; }};
+    for (const std::size_t k: {7, 1500, 3000}) {
+        auto filtered{v};
+        for (std::size_t i{0}; i < v.size(); ++i) {
+            if (!p(flags[i])) { filtered[i] = std::numeric_limits<float>::quiet_NaN(); }
+        }
+        std::vector<std::size_t> result;
+        utils::argtopk_conditional(v.begin(), v.end(), flags.begin(), k,
+                                   std::back_inserter(result), p);
+        EXPECT_EQ(result, reference_topk(filtered, k)) << "k = " << k;
+    }
+}
+
 /**
  * MismatchFromEnd tests.
  */
@@ -205,6 +941,49 @@ TEST(MismatchFromEnd, BothRangesEmpty) {
     EXPECT_EQ(mis_second, vec2.end());
 }
 
+template<typename T>
+void expect_mismatch_from_end_matches_reverse_mismatch() {
+    std::mt19937 gen{7};
+    for (const std::size_t n: {1, 15, 16, 17, 63, 64, 65, 200, 1000}) {
+        const auto values{random_vector<int>(n, 14)};
+        const std::vector<T> a(values.begin(), values.end());
+        for (std::size_t trial{0}; trial < 20; ++trial) {
+            auto b{a};
+            const auto position{std::uniform_int_distribution<std::size_t>{0, n}(gen)};
+            if (position < n) { b[position] = static_cast<T>(b[position] + 1); }
+            const auto expected{std::mismatch(a.rbegin(), a.rend(), b.rbegin())};
+            for_each_simd_level([&] {
+                const auto [it1, it2]{utils::mismatch_from_end(a.begin(), a.end(), b.end())};
+                EXPECT_EQ(it1, expected.first.base()) << "n = " << n << ", position = " << position;
+                EXPECT_EQ(it2, expected.second.base());
+            });
+        }
+    }
+}
+
+TEST(MismatchFromEnd, MatchesReverseMismatchOnEverySimdLevel) {
+    expect_mismatch_from_end_matches_reverse_mismatch<char>();
+    expect_mismatch_from_end_matches_reverse_mismatch<std::int16_t>();
+    expect_mismatch_from_end_matches_reverse_mismatch<std::int32_t>();
+    expect_mismatch_from_end_matches_reverse_mismatch<std::int64_t>();
+}
+
+TEST(MismatchFromEnd, CommonSuffixOfStrings) {
+    const std::string path1{"/home/user/projects/libutils/include/libutils/algorithm.hpp"};
+    const std::string path2{"/opt/libutils/include/libutils/algorithm.hpp"};
+    const auto [it1, it2]{utils::mismatch_from_end(path2.begin(), path2.end(), path1.end())};
+    EXPECT_EQ(std::string(it1, path2.end()), "/libutils/include/libutils/algorithm.hpp");
+    EXPECT_EQ(std::string(it2, path1.end()), "/libutils/include/libutils/algorithm.hpp");
+}
+
+TEST(MismatchFromEnd, FloatingPointComparesByValue) {
+    const std::vector a{1.0, -0.0, 2.0};
+    const std::vector b{1.0, 0.0, 2.0};
+    const auto [it1, it2]{utils::mismatch_from_end(a.begin(), a.end(), b.end())};
+    EXPECT_EQ(it1, a.begin());
+    EXPECT_EQ(it2, b.begin());
+}
+
 /*
  * ReorderElementsByIndices tests.
  */
@@ -238,3 +1017,180 @@ TEST(ReorderElementsByIndices, EmptyRange) {
     utils::reorder_elements_by_indices(elements.begin(), elements.end(), indices.begin());
     EXPECT_EQ(elements, (std::vector<int>{}));
 }
+
+/**
+ * Returns a random permutation of [0, n).
+ */
+template<typename Index = std::size_t>
+std::vector<Index> random_permutation(const std::size_t n, const unsigned seed) {
+    std::vector<Index> indices(n);
+    std::iota(indices.begin(), indices.end(), Index{0});
+    std::shuffle(indices.begin(), indices.end(), std::mt19937{seed});
+    return indices;
+}
+
+template<typename T, typename Index>
+std::vector<T> naive_gather(const std::vector<T> &elements, const std::vector<Index> &indices) {
+    std::vector<T> expected;
+    for (const auto index: indices) {
+        expected.push_back(elements[static_cast<std::size_t>(index)]);
+    }
+    return expected;
+}
+
+constexpr utils::reorder_strategy all_reorder_strategies[]{
+    utils::reorder_strategy::automatic, utils::reorder_strategy::cycles,
+    utils::reorder_strategy::gather, utils::reorder_strategy::blocked};
+
+TEST(ReorderElementsByIndices, NonInvolutionIsAGather) {
+    std::vector elements{'a', 'b', 'c'};
+    const std::vector indices{1, 2, 0};
+    utils::reorder_elements_by_indices(elements.begin(), elements.end(), indices.begin());
+    EXPECT_EQ(elements, (std::vector{'b', 'c', 'a'}));
+}
+
+TEST(ReorderElementsByIndices, EveryStrategyMatchesGatherAndKeepsIndices) {
+    for (const std::size_t n: {1, 2, 100, 70000, 300000}) {
+        const auto source{random_vector<std::int32_t>(n, 8)};
+        const auto indices{random_permutation<std::uint32_t>(n, 9)};
+        const auto expected{naive_gather(source, indices)};
+        for (const auto strategy: all_reorder_strategies) {
+            auto elements{source};
+            auto copy{indices};
+            utils::reorder_elements_by_indices(elements.begin(), elements.end(), copy.begin(), strategy);
+            EXPECT_EQ(elements, expected) << "n = " << n << ", strategy = " << static_cast<int>(strategy);
+            EXPECT_EQ(copy, indices);
+        }
+    }
+}
+
+TEST(ReorderElementsByIndices, NonTrivialElements) {
+    std::vector<std::string> source;
+    for (int i{0}; i < 500; ++i) {
+        source.push_back(std::to_string(i) + std::string(20, 'x'));
+    }
+    const auto indices{random_permutation<int>(source.size(), 10)};
+    for (const auto strategy: all_reorder_strategies) {
+        auto elements{source};
+        utils::reorder_elements_by_indices(elements.begin(), elements.end(), indices.begin(), strategy);
+        EXPECT_EQ(elements, naive_gather(source, indices));
+    }
+}
+
+struct NoDefault {
+    explicit NoDefault(const int v) : value{v} {}
+    int value;
+    bool operator==(const NoDefault &other) const { return value == other.value; }
+};
+
+TEST(ReorderElementsByIndices, NonDefaultConstructibleElements) {
+    std::vector<NoDefault> source;
+    for (int i{0}; i < 100; ++i) {
+        source.emplace_back(i);
+    }
+    const auto indices{random_permutation(source.size(), 11)};
+    for (const auto strategy: all_reorder_strategies) {
+        auto elements{source};
+        utils::reorder_elements_by_indices(elements.begin(), elements.end(), indices.begin(), strategy);
+        EXPECT_EQ(elements, naive_gather(source, indices));
+        elements = source;
+        utils::reorder_elements_by_indices(utils::execution::parallel_policy{4}, elements.begin(), elements.end(),
+                                           indices.begin(), strategy);
+        EXPECT_EQ(elements, naive_gather(source, indices));
+    }
+}
+
+TEST(ParallelReorderElementsByIndices, EveryStrategyMatchesSequential) {
+    const std::size_t n{200000};
+    const auto source{random_vector<double>(n, 12)};
+    const auto indices{random_permutation(n, 13)};
+    const auto expected{naive_gather(source, indices)};
+    for (const auto strategy: all_reorder_strategies) {
+        auto elements{source};
+        utils::reorder_elements_by_indices(utils::execution::parallel_policy{4}, elements.begin(), elements.end(),
+                                           indices.begin(), strategy);
+        EXPECT_EQ(elements, expected) << "strategy = " << static_cast<int>(strategy);
+    }
+}
+
+TEST(ParallelReorderElementsByIndices, ManySmallCycles) {
+    //! [reorder_elements_by_indices_parallel_start]
+    std::vector<int> elements(1000);
+    std::iota(elements.begin(), elements.end(), 0);
+    std::vector<std::size_t> indices(elements.size());
+    for (std::size_t i{0}; i < indices.size(); ++i) {
+        indices[i] = i ^ 1;
+    }
+    utils::reorder_elements_by_indices(utils::execution::par, elements.begin(), elements.end(),
+                                       indices.begin(), utils::reorder_strategy::cycles);
+    //! [reorder_elements_by_indices_parallel_end]
+    EXPECT_EQ(elements[0], 1);
+    EXPECT_EQ(elements[1], 0);
+    EXPECT_EQ(elements[999], 998);
+}
+
+/**
+ * Argsort tests.
+ */
+
+TEST(Argsort, SortsWithReorderElementsByIndices) {
+    //! [argsort_start]
+    std::vector keys{30, -10, 20, -10};
+    std::vector<std::size_t> indices(keys.size());
+    utils::argsort(keys.begin(), keys.end(), indices.begin());
+    utils::reorder_elements_by_indices(keys.begin(), keys.end(), indices.begin());
+    //! [argsort_end]
+    EXPECT_EQ(indices, (std::vector<std::size_t>{1, 3, 2, 0}));
+    EXPECT_EQ(keys, (std::vector{-10, -10, 20, 30}));
+}
+
+template<typename T>
+void expect_argsort_matches_stable_sort(const std::vector<T> &keys) {
+    std::vector<std::size_t> expected(keys.size());
+    std::iota(expected.begin(), expected.end(), std::size_t{0});
+    std::stable_sort(expected.begin(), expected.end(),
+                     [&keys](const std::size_t a, const std::size_t b) { return keys[a] < keys[b]; });
+    std::vector<std::size_t> indices;
+    utils::argsort(keys.begin(), keys.end(), std::back_inserter(indices));
+    EXPECT_EQ(indices, expected) << "n = " << keys.size();
+}
+
+TEST(Argsort, RadixMatchesStableSort) {
+    for (const std::size_t n: {0, 1, 100, 255, 256, 5000}) {
+        expect_argsort_matches_stable_sort(random_vector<std::int32_t>(n, 15));
+        const auto unsigned_values{random_vector<int>(n, 16)};
+        expect_argsort_matches_stable_sort(std::vector<std::uint16_t>(unsigned_values.begin(), unsigned_values.end()));
+        expect_argsort_matches_stable_sort(random_vector<std::int64_t>(n, 17));
+        expect_argsort_matches_stable_sort(random_vector<float>(n, 18));
+        expect_argsort_matches_stable_sort(random_vector<double>(n, 19));
+        const auto values{random_vector<int>(n, 20)};
+        expect_argsort_matches_stable_sort(std::vector<signed char>(values.begin(), values.end()));
+    }
+}
+
+TEST(Argsort, ExtremeKeys) {
+    expect_argsort_matches_stable_sort(std::vector<std::int64_t>{
+        std::numeric_limits<std::int64_t>::max(), 0, std::numeric_limits<std::int64_t>::min(), -1, 1});
+    expect_argsort_matches_stable_sort(std::vector<double>{
+        std::numeric_limits<double>::infinity(), 0.5, -std::numeric_limits<double>::infinity(),
+        std::numeric_limits<double>::denorm_min(), -std::numeric_limits<double>::max(), -0.5});
+}
+
+TEST(Argsort, FloatTotalOrder) {
+    const auto nan{std::numeric_limits<float>::quiet_NaN()};
+    const std::vector keys{nan, 0.0f, -0.0f, -nan, 1.0f, -1.0f};
+    std::vector<std::size_t> indices;
+    utils::argsort(keys.begin(), keys.end(), std::back_inserter(indices));
+    EXPECT_EQ(indices, (std::vector<std::size_t>{3, 5, 2, 1, 4, 0}));
+}
+
+TEST(Argsort, ComparisonFallbackIsStable) {
+    const std::vector<std::string> keys{"pear", "fig", "apple", "fig", "kiwi"};
+    std::vector<std::size_t> indices;
+    utils::argsort(keys.begin(), keys.end(), std::back_inserter(indices));
+    EXPECT_EQ(indices, (std::vector<std::size_t>{2, 1, 3, 4, 0}));
+    indices.clear();
+    utils::argsort(keys.begin(), keys.end(), std::back_inserter(indices),
+                   [](const std::string &a, const std::string &b) { return a.size() < b.size(); });
+    EXPECT_EQ(indices, (std::vector<std::size_t>{1, 3, 0, 4, 2}));
+}
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include <libutils/execution.hpp>
+
+/**
+ * ParallelPolicy tests.
+ */
+
+TEST(ParallelPolicy, DefaultUsesAtLeastOneThread) {
+  EXPECT_GE(utils::execution::par.threads(), 1);
+  EXPECT_EQ(utils::execution::par.grain_size(), 0);
+}
+
+TEST(ParallelPolicy, ExplicitThreadsAndGrain) {
+  //! [parallel_policy_start]
+  const utils::execution::parallel_policy policy{4, 1024};
+  //! [parallel_policy_end]
+  EXPECT_EQ(policy.threads(), 4);
+  EXPECT_EQ(policy.grain_size(), 1024);
+}
+
+TEST(ParallelPolicy, IsExecutionPolicy) {
+  EXPECT_TRUE(utils::execution::is_execution_policy_v<
+              utils::execution::parallel_policy>);
+  EXPECT_TRUE(utils::execution::is_execution_policy_v<
+              utils::execution::sequenced_policy>);
+  EXPECT_FALSE(utils::execution::is_execution_policy_v<int>);
+}
+
+/**
+ * ParallelFor tests.
+ */
+
+TEST(ParallelFor, RunsEveryTaskOnce) {
+  std::vector<std::atomic<int>> counts(1000);
+  utils::details::parallel_for(utils::execution::parallel_policy{8}, counts.size(),
+                               [&](const std::size_t task) { ++counts[task]; });
+  for (const auto &count : counts) {
+    EXPECT_EQ(count, 1);
+  }
+}
+
+TEST(ParallelFor, ZeroTasks) {
+  std::atomic<int> calls{0};
+  utils::details::parallel_for(utils::execution::par, 0,
+                               [&](std::size_t) { ++calls; });
+  EXPECT_EQ(calls, 0);
+}
+
+TEST(ParallelFor, RethrowsTaskException) {
+  EXPECT_THROW(utils::details::parallel_for(
+                   utils::execution::parallel_policy{4}, 100,
+                   [](const std::size_t task) {
+                     if (task == 42) {
+                       throw std::runtime_error("task failed");
+                     }
+                   }),
+               std::runtime_error);
+}
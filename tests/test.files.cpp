@@ -1,5 +1,14 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
+#include <fstream>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
 
 #include <libutils/files.hpp>
 #include "paths.test.files.hpp"
@@ -163,3 +172,461 @@ TEST(ReadDirectoryIfContainer, InvalidDirectoryPath) {
   EXPECT_THROW(utils::read_directory_if(path, predicate),
                std::filesystem::filesystem_error);
 }
+
+/****
+ * ReadDirectoryRecursive tests.
+ ****/
+
+/**
+ * Returns the paths of entries relative to root, sorted.
+ */
+template <typename Range>
+std::vector<std::string> relative_paths(const Range &entries, const fs::path &root) {
+  std::vector<std::string> result;
+  for (const auto &entry : entries) {
+    result.push_back(fs::path(entry).lexically_relative(root).generic_string());
+  }
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+/**
+ * Creates a temporary tree of directories with files, removed on destruction.
+ */
+class TemporaryTree {
+public:
+  TemporaryTree(const std::size_t fanout, const std::size_t levels, const std::size_t files)
+      : root_{fs::temp_directory_path() / ("libutils_tree_" + std::to_string(std::random_device{}()))} {
+    fs::create_directories(root_);
+    populate(root_, fanout, levels, files);
+  }
+  ~TemporaryTree() { fs::remove_all(root_); }
+
+  const fs::path &root() const { return root_; }
+
+private:
+  static void populate(const fs::path &dir, const std::size_t fanout, const std::size_t levels,
+                       const std::size_t files) {
+    for (std::size_t f{0}; f < files; ++f) {
+      std::ofstream{dir / ("file" + std::to_string(f) + ".txt")};
+    }
+    if (levels) {
+      for (std::size_t d{0}; d < fanout; ++d) {
+        const auto sub{dir / ("dir" + std::to_string(d))};
+        fs::create_directory(sub);
+        populate(sub, fanout, levels - 1, files);
+      }
+    }
+  }
+
+  fs::path root_;
+};
+
+TEST(ReadDirectoryRecursive, ReadsEveryLevel) {
+  //! [read_directory_recursive_start]
+  std::vector<fs::path> result;
+  utils::read_directory_recursive(kTreePath, std::back_inserter(result));
+  //! [read_directory_recursive_end]
+  const std::vector<std::string> expected{"a.txt", "sub1", "sub1/b.txt", "sub1/deep",
+                                          "sub1/deep/c.txt", "sub2", "sub2/d.jpg"};
+  EXPECT_EQ(relative_paths(result, kTreePath), expected);
+}
+
+TEST(ReadDirectoryRecursive, LimitsDepth) {
+  std::vector<fs::path> top;
+  utils::read_directory_recursive(kTreePath, std::back_inserter(top), 0);
+  EXPECT_EQ(relative_paths(top, kTreePath), (std::vector<std::string>{"a.txt", "sub1", "sub2"}));
+
+  std::vector<fs::path> two_levels;
+  utils::read_directory_recursive(utils::execution::par, kTreePath, std::back_inserter(two_levels), 1);
+  EXPECT_EQ(relative_paths(two_levels, kTreePath),
+            (std::vector<std::string>{"a.txt", "sub1", "sub1/b.txt", "sub1/deep", "sub2", "sub2/d.jpg"}));
+}
+
+TEST(ReadDirectoryRecursive, PrunesSubtreesAndFilters) {
+  //! [read_directory_recursive_if_start]
+  std::vector<fs::path> result;
+  auto is_text = [](const fs::directory_entry &e) { return e.path().extension() == ".txt"; };
+  auto skip_deep = [](const fs::directory_entry &e) { return e.path().filename() == "deep"; };
+  utils::read_directory_recursive_if(utils::execution::par, kTreePath, std::back_inserter(result), is_text,
+                                     skip_deep);
+  //! [read_directory_recursive_if_end]
+  EXPECT_EQ(relative_paths(result, kTreePath), (std::vector<std::string>{"a.txt", "sub1/b.txt"}));
+
+  const auto all_text{utils::read_directory_recursive_if(utils::execution::seq, kTreePath, is_text)};
+  EXPECT_EQ(relative_paths(all_text, kTreePath),
+            (std::vector<std::string>{"a.txt", "sub1/b.txt", "sub1/deep/c.txt"}));
+}
+
+TEST(ReadDirectoryRecursive, ContainersForwardDepthAndPruning) {
+  const auto all{utils::read_directory_recursive(kTreePath)};
+  EXPECT_EQ(relative_paths(all, kTreePath), (std::vector<std::string>{"a.txt", "sub1", "sub1/b.txt", "sub1/deep",
+                                                                      "sub1/deep/c.txt", "sub2", "sub2/d.jpg"}));
+
+  const auto top{utils::read_directory_recursive<std::set<fs::path>>(kTreePath, 0)};
+  EXPECT_EQ(relative_paths(top, kTreePath), (std::vector<std::string>{"a.txt", "sub1", "sub2"}));
+  const auto two_levels{utils::read_directory_recursive(utils::execution::par, kTreePath, 1)};
+  EXPECT_EQ(relative_paths(two_levels, kTreePath),
+            (std::vector<std::string>{"a.txt", "sub1", "sub1/b.txt", "sub1/deep", "sub2", "sub2/d.jpg"}));
+
+  auto is_text = [](const fs::directory_entry &e) { return e.path().extension() == ".txt"; };
+  auto skip_deep = [](const fs::directory_entry &e) { return e.path().filename() == "deep"; };
+  const auto pruned{utils::read_directory_recursive_if(kTreePath, is_text, skip_deep)};
+  EXPECT_EQ(relative_paths(pruned, kTreePath), (std::vector<std::string>{"a.txt", "sub1/b.txt"}));
+  auto prune_none = [](const fs::directory_entry &) { return false; };
+  const auto shallow{
+      utils::read_directory_recursive_if<std::set<fs::path>>(utils::execution::par, kTreePath, is_text, prune_none, 0)};
+  EXPECT_EQ(relative_paths(shallow, kTreePath), (std::vector<std::string>{"a.txt"}));
+}
+
+TEST(ReadDirectoryRecursive, ParallelMatchesSequential) {
+  const TemporaryTree tree(4, 4, 5);
+  const auto root{tree.root().string()};
+  const auto sequential{utils::read_directory_recursive(utils::execution::seq, root)};
+  EXPECT_EQ(sequential.size(), std::size_t{4 + 16 + 64 + 256 + 5 * (1 + 4 + 16 + 64 + 256)});
+  for (const std::size_t threads : {2, 3, 8}) {
+    const auto parallel{utils::read_directory_recursive(utils::execution::parallel_policy{threads}, root)};
+    EXPECT_EQ(relative_paths(parallel, root), relative_paths(sequential, root));
+  }
+  const auto unique{utils::read_directory_recursive<std::set<fs::path>>(utils::execution::par, root)};
+  EXPECT_EQ(unique.size(), sequential.size());
+}
+
+TEST(ReadDirectoryRecursive, SkipsUnreadableSubtrees) {
+  const TemporaryTree tree(2, 2, 1);
+  const auto root{tree.root().string()};
+  const auto locked{tree.root() / "dir0"};
+  fs::permissions(locked, fs::perms::none);
+  std::error_code ec;
+  fs::directory_iterator probe{locked, ec};
+  if (!ec) {
+    fs::permissions(locked, fs::perms::owner_all);
+    GTEST_SKIP() << "permissions are not enforced for this user";
+  }
+  std::vector<fs::path> result;
+  EXPECT_THROW(utils::read_directory_recursive(utils::execution::parallel_policy{3}, root,
+                                               std::back_inserter(result)),
+               fs::filesystem_error);
+  result.clear();
+  utils::read_directory_recursive(utils::execution::parallel_policy{3}, root, std::back_inserter(result),
+                                  utils::unlimited_depth, fs::directory_options::skip_permission_denied);
+  fs::permissions(locked, fs::perms::owner_all);
+  EXPECT_EQ(relative_paths(result, root),
+            (std::vector<std::string>{"dir0", "dir1", "dir1/dir0", "dir1/dir0/file0.txt", "dir1/dir1",
+                                      "dir1/dir1/file0.txt", "dir1/file0.txt", "file0.txt"}));
+}
+
+TEST(ReadDirectoryRecursive, InvalidDirectoryPath) {
+  std::vector<fs::path> result;
+  EXPECT_THROW(utils::read_directory_recursive("/invalid/path", std::back_inserter(result)), fs::filesystem_error);
+  EXPECT_THROW(utils::read_directory_recursive(utils::execution::parallel_policy{4}, "/invalid/path",
+                                               std::back_inserter(result)),
+               fs::filesystem_error);
+}
+
+/****
+ * ReadDirectoryRecords tests.
+ ****/
+
+TEST(ReadDirectoryRecords, ReadsNamesTypesAndInodes) {
+  //! [read_directory_records_start]
+  const auto listing{utils::read_directory(kDirPath, utils::directory_records)};
+  std::vector<std::string_view> names;
+  for (const auto &record : listing) {
+    names.push_back(record.name);
+  }
+  std::sort(names.begin(), names.end());
+  //! [read_directory_records_end]
+  EXPECT_EQ(names, (std::vector<std::string_view>{"a.txt", "b.jpg", "c.html"}));
+  for (const auto &record : listing) {
+    EXPECT_EQ(record.type, fs::file_type::regular);
+    EXPECT_EQ(listing.path(record), fs::path(kDirPath) / record.name);
+#ifdef __linux__
+    struct stat info{};
+    ASSERT_EQ(::lstat(listing.path(record).c_str(), &info), 0);
+    EXPECT_EQ(record.inode, static_cast<std::uint64_t>(info.st_ino));
+#endif
+  }
+}
+
+TEST(ReadDirectoryRecords, FiltersOnRecords) {
+  //! [read_directory_if_records_start]
+  const auto directories{utils::read_directory_if(kTreePath, utils::directory_records,
+                                                  [](const utils::directory_record &record) {
+                                                    return record.type == fs::file_type::directory;
+                                                  })};
+  //! [read_directory_if_records_end]
+  ASSERT_EQ(directories.size(), 2);
+  EXPECT_TRUE((directories[0].name == "sub1" && directories[1].name == "sub2") ||
+              (directories[0].name == "sub2" && directories[1].name == "sub1"));
+  const auto none{utils::read_directory_if(kTreePath, utils::directory_records,
+                                           [](const utils::directory_record &) { return false; })};
+  EXPECT_TRUE(none.empty());
+}
+
+TEST(ReadDirectoryRecords, LargeDirectoryAndMoves) {
+  const TemporaryTree tree(0, 0, 10'000);
+  auto listing{utils::read_directory(tree.root().string(), utils::directory_records)};
+  const auto moved{std::move(listing)};
+  ASSERT_EQ(moved.size(), 10'000);
+  std::set<std::string_view> names;
+  for (const auto &record : moved) {
+    names.insert(record.name);
+  }
+  EXPECT_EQ(names.size(), 10'000);
+  EXPECT_EQ(names.count("file9999.txt"), 1);
+  const auto some{utils::read_directory_if(tree.root().string(), utils::directory_records,
+                                           [](const utils::directory_record &record) {
+                                             return record.name.size() == 9;
+                                           })};
+  EXPECT_EQ(some.size(), 10);
+}
+
+TEST(ReadDirectoryRecords, InvalidDirectoryPath) {
+  EXPECT_THROW(utils::read_directory("/invalid/path", utils::directory_records), fs::filesystem_error);
+  EXPECT_THROW(utils::read_directory(std::string(kDirPath) + "/a.txt", utils::directory_records),
+               fs::filesystem_error);
+}
+
+/****
+ * EntryFilters tests.
+ ****/
+
+TEST(EntryFilters, RecordsAnswerTypeAndExtension) {
+  const auto listing{utils::read_directory(kTreePath, utils::directory_records)};
+  for (const auto &record : listing) {
+    EXPECT_EQ(record.is_directory(), fs::is_directory(listing.path(record)));
+    EXPECT_EQ(record.is_regular_file(), fs::is_regular_file(listing.path(record)));
+    EXPECT_FALSE(record.is_symlink());
+    EXPECT_EQ(record.extension(), listing.path(record).extension().string());
+  }
+  for (const std::string_view name : {"a.tar.gz", ".profile", "noext", "dot.", ".", "..", "..a"}) {
+    const utils::directory_record record{name, fs::file_type::regular, 0};
+    EXPECT_EQ(record.extension(), fs::path(name).extension().string()) << name;
+  }
+}
+
+TEST(EntryFilters, FiltersPathsWithoutStat) {
+  //! [read_directory_if_filters_start]
+  namespace filters = utils::filters;
+  std::vector<fs::path> result;
+  utils::read_directory_if(kTreePath, std::back_inserter(result),
+                           filters::directories() || filters::extension(".txt"));
+  //! [read_directory_if_filters_end]
+  EXPECT_EQ(relative_paths(result, kTreePath), (std::vector<std::string>{"a.txt", "sub1", "sub2"}));
+
+  const auto files{utils::read_directory_if(kDirPath, filters::regular_files() && !filters::extension(".jpg"))};
+  EXPECT_EQ(relative_paths(files, kDirPath), (std::vector<std::string>{"a.txt", "c.html"}));
+  const auto prefixed{utils::read_directory_if<std::set<fs::path>>(
+      kTreePath, filters::name_prefix("sub") && filters::type(fs::file_type::directory))};
+  EXPECT_EQ(relative_paths(prefixed, kTreePath), (std::vector<std::string>{"sub1", "sub2"}));
+  const auto records{utils::read_directory_if(kTreePath, utils::directory_records, filters::name_prefix("a"))};
+  ASSERT_EQ(records.size(), 1);
+  EXPECT_EQ(records[0].name, "a.txt");
+  EXPECT_TRUE(utils::read_directory_if(kDirPath, filters::name_prefix("a.txt.")).empty());
+}
+
+TEST(EntryFilters, MatchesPathPredicates) {
+  const TemporaryTree tree(3, 1, 20);
+  const auto root{tree.root().string()};
+  static_assert(utils::is_entry_filter_v<decltype(utils::filters::regular_files())>);
+  static_assert(!utils::is_entry_filter_v<bool (*)(const fs::path &)>);
+  const auto by_filter{utils::read_directory_if(root, utils::filters::regular_files() &&
+                                                          utils::filters::name_prefix("file1"))};
+  const auto by_stat{utils::read_directory_if(root, [](const fs::directory_entry &e) {
+    return e.is_regular_file() && e.path().filename().string().rfind("file1", 0) == 0;
+  })};
+  EXPECT_EQ(by_filter.size(), 11);
+  EXPECT_EQ(relative_paths(by_filter, root), relative_paths(by_stat, root));
+}
+
+TEST(EntryFilters, WritesDirectoryEntries) {
+  const auto entries{utils::read_directory_if<std::vector<fs::directory_entry>>(
+      kDirPath, utils::filters::regular_files() && !utils::filters::extension(".jpg"))};
+  EXPECT_EQ(relative_paths(entries, kDirPath), (std::vector<std::string>{"a.txt", "c.html"}));
+  for (const auto &entry : entries) {
+    EXPECT_TRUE(entry.is_regular_file());
+  }
+  std::vector<fs::directory_entry> directories;
+  utils::read_directory_if(kTreePath, std::back_inserter(directories), utils::filters::directories());
+  EXPECT_EQ(relative_paths(directories, kTreePath), (std::vector<std::string>{"sub1", "sub2"}));
+}
+
+TEST(EntryFilters, SymbolicLinksAreNotFollowed) {
+  const TemporaryTree tree(1, 1, 1);
+  const auto root{tree.root().string()};
+  fs::create_symlink(tree.root() / "file0.txt", tree.root() / "link.txt");
+  fs::create_directory_symlink(tree.root() / "dir0", tree.root() / "link_dir");
+  namespace filters = utils::filters;
+  EXPECT_EQ(relative_paths(utils::read_directory_if(root, filters::regular_files()), root),
+            std::vector<std::string>{"file0.txt"});
+  EXPECT_EQ(relative_paths(utils::read_directory_if(root, filters::directories()), root),
+            std::vector<std::string>{"dir0"});
+  EXPECT_EQ(relative_paths(utils::read_directory_if(root, filters::type(fs::file_type::symlink)), root),
+            (std::vector<std::string>{"link.txt", "link_dir"}));
+  const auto followed{utils::read_directory_if(root, [](const fs::directory_entry &e) { return e.is_regular_file(); })};
+  EXPECT_EQ(relative_paths(followed, root), (std::vector<std::string>{"file0.txt", "link.txt"}));
+  for (const auto &record : utils::read_directory(root, utils::directory_records)) {
+    EXPECT_EQ(record.is_symlink(), record.name.substr(0, 4) == "link");
+  }
+}
+
+TEST(EntryFilters, InvalidDirectoryPath) {
+  std::vector<fs::path> result;
+  EXPECT_THROW(utils::read_directory_if("/invalid/path", std::back_inserter(result), utils::filters::regular_files()),
+               fs::filesystem_error);
+}
+
+/****
+ * ReadDirectoryBatched tests.
+ ****/
+
+TEST(ReadDirectoryBatched, PullsBoundedBatches) {
+  const TemporaryTree tree(0, 0, 2'500);
+  const auto root{tree.root().string()};
+  //! [directory_batch_reader_start]
+  utils::directory_batch_reader reader{root, 1'000};
+  std::vector<fs::path> batch;
+  std::vector<std::size_t> sizes;
+  std::set<fs::path> seen;
+  while (reader.next(batch)) {
+    sizes.push_back(batch.size());
+    seen.insert(batch.begin(), batch.end());
+  }
+  //! [directory_batch_reader_end]
+  EXPECT_EQ(sizes, (std::vector<std::size_t>{1'000, 1'000, 500}));
+  EXPECT_EQ(seen.size(), 2'500);
+  EXPECT_EQ(seen.count(tree.root() / "file2499.txt"), 1);
+  EXPECT_TRUE(batch.empty());
+  EXPECT_FALSE(reader.next(batch));
+  EXPECT_EQ(reader.directory(), tree.root());
+}
+
+TEST(ReadDirectoryBatched, SinkReceivesFilteredBatches) {
+  //! [read_directory_batched_if_start]
+  std::vector<std::vector<fs::path>> batches;
+  utils::read_directory_batched_if(kTreePath, 1, utils::filters::directories(),
+                                   [&](std::vector<fs::path> &batch) { batches.push_back(std::move(batch)); });
+  //! [read_directory_batched_if_end]
+  ASSERT_EQ(batches.size(), 2);
+  EXPECT_EQ(batches[0].size(), 1);
+  EXPECT_EQ(relative_paths(std::vector<fs::path>{batches[0][0], batches[1][0]}, kTreePath),
+            (std::vector<std::string>{"sub1", "sub2"}));
+
+  std::vector<fs::path> all;
+  utils::read_directory_batched(kDirPath, 0, [&](std::vector<fs::path> &batch) {
+    EXPECT_EQ(batch.size(), 1);
+    all.insert(all.end(), batch.begin(), batch.end());
+  });
+  EXPECT_EQ(relative_paths(all, kDirPath), (std::vector<std::string>{"a.txt", "b.jpg", "c.html"}));
+}
+
+TEST(ReadDirectoryBatched, SinkStopsReading) {
+  const TemporaryTree tree(0, 0, 100);
+  std::size_t calls{0};
+  utils::read_directory_batched(tree.root().string(), 10, [&](const std::vector<fs::path> &batch) {
+    EXPECT_EQ(batch.size(), 10);
+    return ++calls < 3;
+  });
+  EXPECT_EQ(calls, 3);
+}
+
+TEST(ReadDirectoryBatched, InvalidDirectoryPath) {
+  EXPECT_THROW(utils::directory_batch_reader{"/invalid/path"}, fs::filesystem_error);
+  EXPECT_THROW(utils::read_directory_batched("/invalid/path", 10, [](std::vector<fs::path> &) {}),
+               fs::filesystem_error);
+}
+
+#ifdef __linux__
+/****
+ * DirectoryCache tests.
+ ****/
+
+/**
+ * Polls a condition until it holds or a few seconds have passed, the cache
+ * applying events on its own thread.
+ */
+template <typename Condition>
+bool eventually(Condition condition) {
+  const auto deadline{std::chrono::steady_clock::now() + std::chrono::seconds(5)};
+  while (!condition()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+TEST(DirectoryCache, ServesWatchedDirectory) {
+  //! [directory_cache_start]
+  utils::directory_cache cache;
+  const auto texts{cache.read_directory_if(kDirPath, [](const fs::path &p) { return p.extension() == ".txt"; })};
+  const auto all{cache.read_directory(kDirPath)};
+  //! [directory_cache_end]
+  EXPECT_TRUE(cache.watched(kDirPath));
+  EXPECT_EQ(texts, std::vector<fs::path>{fs::path(kDirPath) / "a.txt"});
+  EXPECT_EQ(relative_paths(all, kDirPath), (std::vector<std::string>{"a.txt", "b.jpg", "c.html"}));
+  std::set<fs::path> unique;
+  cache.read_directory(kDirPath, std::inserter(unique, unique.end()));
+  EXPECT_EQ(unique.size(), 3);
+}
+
+TEST(DirectoryCache, AppliesCreateDeleteAndMove) {
+  const TemporaryTree tree(1, 1, 2);
+  const auto root{tree.root().string()};
+  utils::directory_cache cache;
+  cache.watch(root);
+  const auto listed{[&] { return relative_paths(cache.read_directory(root), root); }};
+  EXPECT_EQ(listed(), (std::vector<std::string>{"dir0", "file0.txt", "file1.txt"}));
+
+  std::ofstream{tree.root() / "new.txt"};
+  EXPECT_TRUE(eventually([&] {
+    return listed() == std::vector<std::string>{"dir0", "file0.txt", "file1.txt", "new.txt"};
+  }));
+  fs::remove(tree.root() / "file0.txt");
+  fs::rename(tree.root() / "file1.txt", tree.root() / "renamed.txt");
+  fs::rename(tree.root() / "dir0" / "file0.txt", tree.root() / "moved_in.txt");
+  EXPECT_TRUE(eventually([&] {
+    return listed() == std::vector<std::string>{"dir0", "moved_in.txt", "new.txt", "renamed.txt"};
+  }));
+  fs::rename(tree.root() / "new.txt", tree.root() / "dir0" / "new.txt");
+  EXPECT_TRUE(eventually([&] {
+    return listed() == std::vector<std::string>{"dir0", "moved_in.txt", "renamed.txt"};
+  }));
+}
+
+TEST(DirectoryCache, RewatchesReplacedDirectory) {
+  const TemporaryTree tree(1, 1, 0);
+  const auto dir{(tree.root() / "dir0").string()};
+  utils::directory_cache cache;
+  EXPECT_TRUE(cache.read_directory(dir).empty());
+  fs::remove(dir);
+  EXPECT_TRUE(eventually([&] { return !cache.watched(dir); }));
+  EXPECT_THROW(cache.read_directory(dir), fs::filesystem_error);
+  fs::create_directory(dir);
+  std::ofstream{fs::path(dir) / "a.txt"};
+  EXPECT_EQ(relative_paths(cache.read_directory(dir), dir), std::vector<std::string>{"a.txt"});
+  EXPECT_TRUE(cache.watched(dir));
+  cache.unwatch(dir);
+  EXPECT_FALSE(cache.watched(dir));
+}
+
+TEST(DirectoryCache, RefreshRereadsDirectories) {
+  const TemporaryTree tree(0, 0, 3);
+  const auto root{tree.root().string()};
+  utils::directory_cache cache;
+  cache.watch(root);
+  std::ofstream{tree.root() / "late.txt"};
+  cache.refresh();
+  EXPECT_EQ(cache.read_directory(root).size(), 4);
+}
+
+TEST(DirectoryCache, InvalidDirectoryPath) {
+  utils::directory_cache cache;
+  EXPECT_THROW(cache.watch("/invalid/path"), fs::filesystem_error);
+  EXPECT_THROW(cache.read_directory("/invalid/path"), fs::filesystem_error);
+  EXPECT_THROW(cache.watch(std::string(kDirPath) + "/a.txt"), fs::filesystem_error);
+  EXPECT_FALSE(cache.watched("/invalid/path"));
+}
+#endif
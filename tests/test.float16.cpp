@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include <libutils/float16.hpp>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+/**
+ * float16 tests.
+ */
+
+TEST(Float16, RoundTripsEveryBitPattern) {
+  for (std::uint32_t bits{0}; bits <= 0xffff; ++bits) {
+    const auto value{utils::float16::from_bits(static_cast<std::uint16_t>(bits))};
+    const float widened{value};
+    if (std::isnan(widened)) {
+      EXPECT_TRUE(std::isnan(static_cast<float>(utils::float16(widened))));
+    } else {
+      EXPECT_EQ(utils::float16(widened).bits(), bits);
+    }
+  }
+}
+
+TEST(Float16, RoundsToNearestEven) {
+  //! [float16_start]
+  const utils::float16 value{0.1f};
+  const float widened{value};
+  //! [float16_end]
+  EXPECT_EQ(widened, 0.0999755859375f);
+  EXPECT_EQ(utils::float16(65504.0f).bits(), 0x7bff);
+  EXPECT_EQ(utils::float16(65519.0f).bits(), 0x7bff);
+  EXPECT_EQ(utils::float16(65520.0f).bits(), 0x7c00);
+  EXPECT_EQ(utils::float16(-1e10f).bits(), 0xfc00);
+  EXPECT_EQ(utils::float16(1.0f + 0x1p-11f).bits(), 0x3c00);
+  EXPECT_EQ(utils::float16(1.0f + 0x3p-11f).bits(), 0x3c02);
+  EXPECT_EQ(utils::float16(0x1p-25f).bits(), 0x0000);
+  EXPECT_EQ(utils::float16(0x3p-26f).bits(), 0x0001);
+  EXPECT_EQ(utils::float16(-0x1.8p-24f).bits(), 0x8002);
+  EXPECT_EQ(utils::float16(0x1.ffcp-15f).bits(), 0x0400);
+  EXPECT_EQ(utils::float16(-0.0f).bits(), 0x8000);
+  EXPECT_TRUE(std::isnan(static_cast<float>(utils::float16(std::numeric_limits<float>::quiet_NaN()))));
+}
+
+/**
+ * bfloat16 tests.
+ */
+
+TEST(Bfloat16, RoundsToNearestEven) {
+  //! [bfloat16_start]
+  const utils::bfloat16 value{3.14159265f};
+  const float widened{value};
+  //! [bfloat16_end]
+  EXPECT_EQ(widened, 3.140625f);
+  EXPECT_EQ(static_cast<float>(utils::bfloat16(1.0f + 0x1p-8f)), 1.0f);
+  EXPECT_EQ(static_cast<float>(utils::bfloat16(1.0f + 0x3p-8f)), 1.015625f);
+  EXPECT_EQ(static_cast<float>(utils::bfloat16(std::numeric_limits<float>::max())),
+            std::numeric_limits<float>::infinity());
+  const auto nan{utils::bfloat16(std::numeric_limits<float>::quiet_NaN())};
+  EXPECT_TRUE(std::isnan(static_cast<float>(nan)));
+  EXPECT_EQ(utils::bfloat16::from_bits(0x3f80).bits(), 0x3f80);
+}
+
+/**
+ * IsNarrowFloat tests.
+ */
+
+TEST(IsNarrowFloat, DetectsNarrowTypes) {
+  EXPECT_TRUE(utils::is_narrow_float_v<utils::float16>);
+  EXPECT_TRUE(utils::is_narrow_float_v<utils::bfloat16>);
+  EXPECT_FALSE(utils::is_narrow_float_v<float>);
+  EXPECT_FALSE(utils::is_narrow_float_v<std::uint16_t>);
+}
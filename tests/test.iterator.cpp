@@ -195,6 +195,15 @@ TEST(MultiIterator, ConstructsFromMultipleIterators) {
   EXPECT_EQ(b, 4);
 }
 
+TEST(MultiIterator, ExposesUnderlyingIterators) {
+  std::vector vec1{1, 2, 3};
+  std::vector vec2{4, 5, 6};
+  utils::MultiIterator it(vec1.begin(), vec2.begin());
+  ++it;
+  EXPECT_EQ(std::get<0>(it.base()), vec1.begin() + 1);
+  EXPECT_EQ(std::get<1>(it.base()), vec2.begin() + 1);
+}
+
 TEST(MultiIterator, AdvancesIterators) {
   std::vector vec1{1, 2, 3};
   std::vector vec2{4, 5, 6};
@@ -1,8 +1,30 @@
 #include <gtest/gtest.h>
+#include <libutils/iterator.hpp>
 #include <libutils/numeric.hpp>
+#include <cmath>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <deque>
 #include <limits>
+#include <list>
+#include <random>
+#include <thread>
 #include <vector>
 
+/**
+ * Runs a test body once for every SIMD level up to the one the CPU supports.
+ */
+template <typename F> void for_each_simd_level(F f) {
+  using utils::details::simd_level;
+  for (const auto level : {simd_level::scalar, simd_level::sse42,
+                           simd_level::avx2, simd_level::avx512}) {
+    utils::details::limit_simd_level(level);
+    f();
+  }
+  utils::details::limit_simd_level(simd_level::avx512);
+}
+
 /**
  * product function tests.
  */
@@ -39,6 +61,158 @@ TEST(Product, ComputesProductOfRangeWithZero) {
   EXPECT_EQ(result, 0);
 }
 
+TEST(Product, ParallelEqualsSequentialForIntegers) {
+  std::vector<std::uint64_t> vec(100'003);
+  std::iota(vec.begin(), vec.end(), 1);
+  for (auto &v : vec) {
+    v |= 1; // Keeps the wrapped product away from zero.
+  }
+  const auto expected{utils::product(vec.begin(), vec.end(), std::uint64_t{3})};
+  for (const std::size_t threads : {1, 2, 3, 8}) {
+    const utils::execution::parallel_policy policy{threads};
+    EXPECT_EQ(utils::product(policy, vec.begin(), vec.end(), std::uint64_t{3}), expected);
+  }
+  EXPECT_EQ(utils::product(utils::execution::seq, vec.begin(), vec.end(), std::uint64_t{3}),
+            expected);
+}
+
+TEST(Product, ParallelIsIndependentOfThreadCount) {
+  std::mt19937 gen{2};
+  std::uniform_real_distribution<double> dist{0.999, 1.001};
+  std::vector<double> vec(250'000);
+  for (auto &v : vec) {
+    v = dist(gen);
+  }
+  //! [product_parallel_start]
+  const auto result{utils::product(utils::execution::par, vec.begin(), vec.end(), 1.0)};
+  //! [product_parallel_end]
+  for (const std::size_t threads : {1, 2, 3, 8}) {
+    for (const std::size_t grain : {0, 1, 5'000, 1'000'000}) {
+      const utils::execution::parallel_policy policy{threads, grain};
+      EXPECT_EQ(utils::product(policy, vec.begin(), vec.end(), 1.0), result);
+    }
+  }
+  EXPECT_NEAR(result, utils::product(vec.begin(), vec.end(), 1.0), 1e-9 * std::abs(result));
+}
+
+TEST(Product, ParallelEmptyRange) {
+  const std::vector<int> vec{};
+  EXPECT_EQ(utils::product(utils::execution::par, vec.begin(), vec.end(), 7), 7);
+}
+
+TEST(Product, CheckedDetectsOverflow) {
+  //! [product_checked_start]
+  const std::vector<std::int64_t> vec{1'000'000, 1'000'000, 1'000'000, 10'000};
+  const auto result{utils::product(utils::numeric::checked, vec.begin(), vec.end(), std::int64_t{1})};
+  //! [product_checked_end]
+  EXPECT_FALSE(result.first);
+  EXPECT_EQ(result.second, 0);
+
+  const auto fits{utils::product(utils::numeric::checked, vec.begin(), vec.end() - 1, std::int64_t{9})};
+  EXPECT_TRUE(fits.first);
+  EXPECT_EQ(fits.second, 9'000'000'000'000'000'000);
+
+  const std::vector<std::int32_t> negative{-2, 1 << 30};
+  EXPECT_EQ(utils::product(utils::numeric::checked, negative.begin(), negative.end(), 1),
+            std::make_pair(true, std::numeric_limits<std::int32_t>::min()));
+  EXPECT_FALSE(utils::product(utils::numeric::checked, negative.begin(), negative.end(), -1).first);
+}
+
+TEST(Product, CheckedStopsAtZero) {
+  std::vector<std::uint32_t> vec(1000, 0xffff'ffffu);
+  vec[10] = 0;
+  EXPECT_EQ(utils::product(utils::numeric::checked, vec.begin(), vec.begin() + 10, 1u).first, false);
+  vec[0] = 0;
+  EXPECT_EQ(utils::product(utils::numeric::checked, vec.begin(), vec.end(), 1u), std::make_pair(true, 0u));
+  const std::vector<std::uint32_t> empty{};
+  EXPECT_EQ(utils::product(utils::numeric::checked, empty.begin(), empty.end(), 5u), std::make_pair(true, 5u));
+}
+
+TEST(Product, ScaledDoesNotUnderflow) {
+  std::mt19937 gen{8};
+  std::uniform_real_distribution<double> dist{1e-3, 1.0};
+  std::vector<double> vec(100'000);
+  long double log_sum{0};
+  for (auto &v : vec) {
+    v = dist(gen);
+    log_sum += std::log(static_cast<long double>(v));
+  }
+  EXPECT_EQ(utils::product(vec.begin(), vec.end(), 1.0), 0.0);
+  //! [product_log_start]
+  const auto result{utils::product(utils::numeric::log_domain, vec.begin(), vec.end(), 1.0)};
+  //! [product_log_end]
+  EXPECT_NEAR(result, static_cast<double>(log_sum), 1e-9 * std::abs(result));
+
+  const auto scaled{utils::product(utils::numeric::scaled, vec.begin(), vec.end(), 1.0)};
+  EXPECT_GE(std::abs(scaled.mantissa), 0.5);
+  EXPECT_LT(std::abs(scaled.mantissa), 1.0);
+  EXPECT_EQ(scaled.value(), 0.0);
+  EXPECT_DOUBLE_EQ(scaled.log(), result);
+}
+
+TEST(Product, ScaledMatchesPlainProductInRange) {
+  const std::vector<float> vec{1.5f, -2.0f, 0.25f, 3.0f, 0x1p-100f, 0x1p-100f, 0x1p100f, 0x1p100f};
+  const auto scaled{utils::product(utils::numeric::scaled, vec.begin(), vec.end(), 2.0f)};
+  EXPECT_DOUBLE_EQ(scaled.value(), 2.0 * 1.5 * -2.0 * 0.25 * 3.0);
+  EXPECT_TRUE(std::isnan(utils::product(utils::numeric::log_domain, vec.begin(), vec.end(), 1.0f)));
+
+  const std::vector subnormal{std::numeric_limits<double>::denorm_min(), 0x1p1000, 0x1p74};
+  EXPECT_EQ(utils::product(utils::numeric::scaled, subnormal.begin(), subnormal.end(), 1.0).value(), 1.0);
+  const std::vector zero{5.0, 0.0, 1e300, 1e300};
+  EXPECT_EQ(utils::product(utils::numeric::scaled, zero.begin(), zero.end(), 1.0).value(), 0.0);
+  EXPECT_EQ(utils::product(utils::numeric::log_domain, zero.begin(), zero.end(), 1.0),
+            -std::numeric_limits<double>::infinity());
+  const std::vector<int> ints{1 << 20, 1 << 20, 1 << 20, 1 << 20};
+  EXPECT_EQ(utils::product(utils::numeric::scaled, ints.begin(), ints.end(), 1).exponent, 81);
+}
+
+TEST(Product, FixedSizeArrayAtCompileTime) {
+  //! [product_array_start]
+  constexpr std::array<std::size_t, 4> shape{2, 3, 4, 5};
+  constexpr auto elements{utils::product(shape)};
+  static_assert(elements == 120);
+  //! [product_array_end]
+  static_assert(utils::product(shape, std::size_t{2}) == 240);
+  static_assert(utils::product(std::array<int, 0>{}, 7) == 7);
+  static_assert(utils::product(std::array<int, 1>{-3}) == -3);
+  static_assert(utils::product(std::array<int, 7>{1, 2, 3, 4, 5, 6, 7}) == 5040);
+  constexpr std::array<double, 3> powers{0.5, 4.0, 0.25};
+  static_assert(utils::product(powers, 2.0) == 1.0);
+
+  std::array<long long, 16> runtime{};
+  for (std::size_t i{0}; i < runtime.size(); ++i) {
+    runtime[i] = static_cast<long long>(i % 3) + 1;
+  }
+  EXPECT_EQ(utils::product(runtime), utils::product(runtime.begin(), runtime.end(), 1LL));
+}
+
+/**
+ * 2x2 integer matrix, whose multiplication is not commutative.
+ */
+struct Matrix2 {
+  int a, b, c, d;
+  constexpr Matrix2 operator*(const Matrix2 &m) const {
+    return {a * m.a + b * m.c, a * m.b + b * m.d, c * m.a + d * m.c, c * m.b + d * m.d};
+  }
+  constexpr bool operator==(const Matrix2 &m) const { return a == m.a && b == m.b && c == m.c && d == m.d; }
+};
+
+TEST(Product, FixedSizeArrayKeepsOperandOrder) {
+  constexpr Matrix2 identity{1, 0, 0, 1};
+  constexpr Matrix2 upper{1, 1, 0, 1};
+  constexpr Matrix2 lower{1, 0, 1, 1};
+  constexpr std::array<Matrix2, 3> three{upper, upper, lower};
+  static_assert(utils::product(three, identity) == upper * upper * lower);
+  EXPECT_EQ(utils::product(three, identity), (Matrix2{3, 2, 1, 1}));
+
+  std::array<Matrix2, 7> seven{};
+  for (std::size_t i{0}; i < seven.size(); ++i) {
+    seven[i] = i % 3 ? upper : lower;
+  }
+  EXPECT_EQ(utils::product(seven, identity), utils::product(seven.begin(), seven.end(), identity));
+  EXPECT_EQ(utils::product(seven, upper), utils::product(seven.begin(), seven.end(), upper));
+}
+
 /**
  * mean function tests.
  */
@@ -82,10 +256,126 @@ TEST(MeanFunction, NegativeNumbers) {
   EXPECT_EQ(utils::mean(vec.begin(), vec.end()), -3);
 }
 
+TEST(MeanFunction, Int32SumDoesNotOverflow) {
+  constexpr auto int32_max{std::numeric_limits<std::int32_t>::max()};
+  const std::vector<std::int32_t> vec(1000, int32_max);
+  EXPECT_EQ(utils::mean(vec.begin(), vec.end()), int32_max);
+  const std::vector<std::uint32_t> uvec(1000, 4000000000u);
+  EXPECT_EQ(utils::mean(uvec.begin(), uvec.end()), 4000000000u);
+}
+
+TEST(MeanFunction, FloatSumIsAccurate) {
+  // 0.1f repeated: a float accumulator drifts by several percent.
+  const std::vector<float> vec(10000000, 0.1f);
+  EXPECT_FLOAT_EQ(utils::mean(vec.begin(), vec.end()), 0.1f);
+  const std::list<float> list(1000, 0.1f);
+  EXPECT_FLOAT_EQ(utils::mean(list.begin(), list.end()), 0.1f);
+}
+
+TEST(MeanFunction, BitIdenticalOnEverySimdLevel) {
+  std::mt19937 gen{1};
+  std::normal_distribution<double> dist{0.0, 1e6};
+  std::vector<double> doubles(100003);
+  for (auto &v : doubles) {
+    v = dist(gen);
+  }
+  const std::vector<float> floats(doubles.begin(), doubles.end());
+  for (const std::size_t n : {1, 15, 17, 2048, 2049, 100003}) {
+    std::vector<double> double_means;
+    std::vector<float> float_means;
+    for_each_simd_level([&] {
+      double_means.push_back(utils::mean(doubles.begin(), doubles.begin() + n));
+      float_means.push_back(utils::mean(floats.begin(), floats.begin() + n));
+    });
+    for (std::size_t i{1}; i < double_means.size(); ++i) {
+      EXPECT_EQ(double_means[i], double_means[0]) << "n = " << n;
+      EXPECT_EQ(float_means[i], float_means[0]) << "n = " << n;
+    }
+    long double exact{0};
+    for (std::size_t i{0}; i < n; ++i) {
+      exact += doubles[i];
+    }
+    EXPECT_NEAR(double_means[0], static_cast<double>(exact / n),
+                1e-12 * std::abs(static_cast<double>(exact)) + 1e-9);
+  }
+}
+
+TEST(MeanFunction, ParallelEqualsSequential) {
+  std::mt19937 gen{3};
+  std::normal_distribution<double> dist{0.0, 1e6};
+  std::vector<double> doubles(300'007);
+  for (auto &v : doubles) {
+    v = dist(gen);
+  }
+  const std::vector<float> floats(doubles.begin(), doubles.end());
+  std::vector<std::int32_t> ints(doubles.size());
+  std::iota(ints.begin(), ints.end(), -150'000);
+  for (const std::size_t threads : {1, 2, 3, 8}) {
+    for (const std::size_t grain : {0, 1, 10'000}) {
+      const utils::execution::parallel_policy policy{threads, grain};
+      EXPECT_EQ(utils::mean(policy, doubles.begin(), doubles.end()),
+                utils::mean(doubles.begin(), doubles.end()));
+      EXPECT_EQ(utils::mean(policy, floats.begin(), floats.end()),
+                utils::mean(floats.begin(), floats.end()));
+      EXPECT_EQ(utils::mean(policy, ints.begin(), ints.end()),
+                utils::mean(ints.begin(), ints.end()));
+    }
+  }
+}
+
+TEST(MeanFunction, ParallelIsIndependentOfThreadCount) {
+  std::mt19937 gen{4};
+  std::normal_distribution<double> dist{0.0, 1e6};
+  std::deque<double> deque(100'003);
+  for (auto &v : deque) {
+    v = dist(gen);
+  }
+  //! [mean_parallel_start]
+  const auto result{utils::mean(utils::execution::par, deque.begin(), deque.end())};
+  //! [mean_parallel_end]
+  for (const std::size_t threads : {1, 2, 3, 8}) {
+    const utils::execution::parallel_policy policy{threads, 4'096};
+    EXPECT_EQ(utils::mean(policy, deque.begin(), deque.end()), result);
+  }
+  EXPECT_NEAR(result, utils::mean(deque.begin(), deque.end()), 1e-6);
+}
+
+TEST(MeanFunction, ParallelEmptyRange) {
+  const std::vector<double> vec{};
+  EXPECT_EQ(utils::mean(utils::execution::par, vec.begin(), vec.end()), 0.0);
+  EXPECT_EQ(utils::mean(utils::execution::seq, vec.begin(), vec.end()), 0.0);
+}
+
 /**
  * mean function tests with type.
  */
 
+TEST(MeanFunction, FixedSizeArrayAtCompileTime) {
+  //! [mean_array_start]
+  constexpr std::array<int, 5> values{1, 2, 3, 4, 6};
+  constexpr auto result{utils::mean<double>(values)};
+  static_assert(result == 3.2);
+  //! [mean_array_end]
+  static_assert(utils::mean(values) == 3);
+  static_assert(utils::mean(std::array<double, 0>{}) == 0.0);
+  constexpr std::array<std::int32_t, 3> large{std::numeric_limits<std::int32_t>::max(),
+                                              std::numeric_limits<std::int32_t>::max(), 1};
+  static_assert(utils::mean<double>(large) == (2.0 * std::numeric_limits<std::int32_t>::max() + 1) / 3);
+
+  const std::array<float, 9> floats{0.1f, 0.2f, 0.3f, 0.4f, 0.5f, 0.6f, 0.7f, 0.8f, 0.9f};
+  EXPECT_FLOAT_EQ(utils::mean(floats), utils::mean(floats.begin(), floats.end()));
+}
+
+TEST(MeanFunction, FixedSizeArrayWithElementType) {
+  constexpr std::array<double, 3> doubles{1.0, 2.0, 4.5};
+  static_assert(utils::mean<double>(doubles) == 2.5);
+  constexpr std::array<float, 4> floats{1.0f, 2.0f, 3.0f, 6.0f};
+  static_assert(std::is_same_v<decltype(utils::mean<float>(floats)), float>);
+  static_assert(utils::mean<float>(floats) == 3.0f);
+  static_assert(utils::mean<double>(floats) == 3.0);
+  static_assert(utils::mean<int>(std::array<int, 2>{3, 5}) == 4);
+}
+
 TEST(MeanFunctionWithType, NonEmptyRange) {
   const std::vector vec{1, 2, 3, 4, 5};
   EXPECT_EQ(utils::mean<int>(vec.begin(), vec.end()), 3);
@@ -115,7 +405,602 @@ TEST(MeanFunctionWithType, LargeNumbers) {
   EXPECT_EQ(result, int32_max);
 }
 
+TEST(MeanFunctionWithType, FloatingPointMeanOfIntegers) {
+  const std::vector vec{1, 2};
+  EXPECT_DOUBLE_EQ(utils::mean<double>(vec.begin(), vec.end()), 1.5);
+  const std::vector<std::int32_t> big(4, std::numeric_limits<std::int32_t>::min());
+  EXPECT_EQ(utils::mean<std::int32_t>(big.begin(), big.end()),
+            std::numeric_limits<std::int32_t>::min());
+}
+
 TEST(MeanFunctionWithType, NegativeNumbers) {
   std::vector vec{-1, -2, -3, -4, -5};
   EXPECT_EQ(utils::mean<int>(vec.begin(), vec.end()), -3);
-}
\ No newline at end of file
+}
+
+TEST(MeanFunctionWithType, Parallel) {
+  std::vector<std::int32_t> vec(10'000);
+  std::iota(vec.begin(), vec.end(), 0);
+  const utils::execution::parallel_policy policy{4, 1};
+  EXPECT_DOUBLE_EQ(utils::mean<double>(policy, vec.begin(), vec.end()), 4999.5);
+  EXPECT_EQ(utils::mean<std::int64_t>(utils::execution::seq, vec.begin(), vec.end()), 4999);
+}
+
+TEST(MeanFunction, NarrowFloatsAccumulateInDouble) {
+  //! [mean_float16_start]
+  const std::vector<utils::float16> vec(100'000, utils::float16(0.1f));
+  const auto result{utils::mean<double>(vec.begin(), vec.end())};
+  //! [mean_float16_end]
+  EXPECT_EQ(result, static_cast<double>(static_cast<float>(vec.front())));
+  EXPECT_EQ(static_cast<float>(utils::mean(vec.begin(), vec.end())), static_cast<float>(vec.front()));
+
+  std::mt19937 gen(20);
+  std::uniform_real_distribution<float> dist(-2.0f, 2.0f);
+  std::vector<utils::float16> halves(12'345);
+  std::vector<utils::bfloat16> brains(12'345);
+  double half_sum{0.0};
+  double brain_sum{0.0};
+  for (std::size_t i{0}; i < halves.size(); ++i) {
+    halves[i] = utils::float16(dist(gen));
+    brains[i] = utils::bfloat16(dist(gen));
+    half_sum += halves[i];
+    brain_sum += brains[i];
+  }
+  const auto half_mean{utils::mean<double>(halves.begin(), halves.end())};
+  const auto brain_mean{utils::mean<double>(brains.begin(), brains.end())};
+  EXPECT_NEAR(half_mean, half_sum / 12'345, 1e-15);
+  EXPECT_NEAR(brain_mean, brain_sum / 12'345, 1e-15);
+  for_each_simd_level([&] {
+    EXPECT_EQ(utils::mean<double>(halves.begin(), halves.end()), half_mean);
+    EXPECT_EQ(utils::mean<double>(brains.begin(), brains.end()), brain_mean);
+    EXPECT_EQ(utils::mean<double>(utils::execution::parallel_policy{3, 1}, halves.begin(), halves.end()),
+              half_mean);
+  });
+  const std::array<utils::bfloat16, 3> array{utils::bfloat16(1.0f), utils::bfloat16(2.0f), utils::bfloat16(6.0f)};
+  EXPECT_EQ(utils::mean<double>(array), 3.0);
+}
+
+TEST(MeanFunction, Int8RangesAreSummedExactly) {
+  std::vector<std::int8_t> signed_bytes(100'003);
+  std::vector<std::uint8_t> unsigned_bytes(100'003);
+  std::int64_t signed_sum{0};
+  std::uint64_t unsigned_sum{0};
+  for (std::size_t i{0}; i < signed_bytes.size(); ++i) {
+    signed_bytes[i] = static_cast<std::int8_t>(i * 37);
+    unsigned_bytes[i] = static_cast<std::uint8_t>(i * 101);
+    signed_sum += signed_bytes[i];
+    unsigned_sum += unsigned_bytes[i];
+  }
+  for_each_simd_level([&] {
+    EXPECT_EQ(utils::mean<double>(signed_bytes.begin(), signed_bytes.end()),
+              static_cast<double>(signed_sum) / 100'003);
+    EXPECT_EQ(utils::mean<double>(unsigned_bytes.begin(), unsigned_bytes.end()),
+              static_cast<double>(unsigned_sum) / 100'003);
+  });
+  const std::vector<std::int8_t> small{-128, -128, 127};
+  EXPECT_EQ(utils::mean(small.begin(), small.end()), -43);
+}
+
+TEST(Product, NarrowFloatsAccumulateInDouble) {
+  const std::vector<utils::float16> vec(40, utils::float16(2.0f));
+  EXPECT_TRUE(std::isinf(static_cast<float>(utils::product(vec.begin(), vec.end(), utils::float16(1.0f)))));
+  const std::vector<utils::float16> wide_range{utils::float16(1024.0f), utils::float16(1024.0f),
+                                               utils::float16(0x1p-10f), utils::float16(0x1p-10f)};
+  EXPECT_EQ(utils::product(wide_range.begin(), wide_range.end(), utils::float16(3.0f)), utils::float16(3.0f));
+  EXPECT_EQ(utils::product(vec.begin(), vec.end(), 1.0), 0x1p40);
+  EXPECT_EQ(utils::product(utils::execution::parallel_policy{2, 1}, vec.begin(), vec.end(), utils::bfloat16(0x1p-40f)),
+            utils::bfloat16(1.0f));
+}
+
+TEST(ExactMean, Uint64CountersDoNotOverflow) {
+  //! [mean_exact_start]
+  const std::vector<std::uint64_t> counters(1000, std::numeric_limits<std::uint64_t>::max() - 1);
+  const auto result{utils::mean(utils::numeric::exact, counters.begin(), counters.end())};
+  //! [mean_exact_end]
+  EXPECT_EQ(result, std::numeric_limits<std::uint64_t>::max() - 1);
+  EXPECT_EQ(utils::mean<double>(utils::numeric::exact, counters.begin(), counters.end()), 0x1p64);
+  const std::vector<std::uint64_t> empty;
+  EXPECT_EQ(utils::mean(utils::numeric::exact, empty.begin(), empty.end()), 0u);
+}
+
+TEST(ExactMean, RoundsToNearestEven) {
+  const std::vector<int> half_up{1, 2};
+  const std::vector<int> half_down{2, 3};
+  const std::vector<int> negative{-1, -2, -2};
+  EXPECT_EQ(utils::mean(utils::numeric::exact, half_up.begin(), half_up.end()), 2);
+  EXPECT_EQ(utils::mean(utils::numeric::exact, half_down.begin(), half_down.end()), 2);
+  EXPECT_EQ(utils::mean(utils::numeric::exact, negative.begin(), negative.end()), -2);
+  EXPECT_EQ(utils::mean<double>(utils::numeric::exact, negative.begin(), negative.end()), -5.0 / 3.0);
+
+  const std::vector<std::int64_t> extremes{std::numeric_limits<std::int64_t>::min(),
+                                           std::numeric_limits<std::int64_t>::min(),
+                                           std::numeric_limits<std::int64_t>::max()};
+  // The sum is -2^63 - 1, a multiple of 3.
+  EXPECT_EQ(utils::mean(utils::numeric::exact, extremes.begin(), extremes.end()), -3'074'457'345'618'258'603);
+  const std::vector<std::int64_t> large{std::numeric_limits<std::int64_t>::max(), std::numeric_limits<std::int64_t>::max() - 2};
+  EXPECT_EQ(utils::mean(utils::numeric::exact, large.begin(), large.end()), std::numeric_limits<std::int64_t>::max() - 1);
+  EXPECT_EQ(utils::mean<double>(utils::numeric::exact, extremes.begin(), extremes.end()), -0x1p63 / 3);
+  EXPECT_EQ(utils::mean<float>(utils::numeric::exact, extremes.begin(), extremes.end()),
+            static_cast<float>(-0x1p63 / 3));
+}
+
+TEST(ExactMean, SameOnEverySimdLevelAndIteratorKind) {
+  std::mt19937_64 gen(19);
+  std::vector<std::int64_t> signed_values(1001);
+  std::vector<std::uint64_t> unsigned_values(1001);
+  for (std::size_t i{0}; i < signed_values.size(); ++i) {
+    unsigned_values[i] = gen();
+    signed_values[i] = static_cast<std::int64_t>(gen());
+  }
+  const std::list<std::int64_t> signed_list(signed_values.begin(), signed_values.end());
+  const std::list<std::uint64_t> unsigned_list(unsigned_values.begin(), unsigned_values.end());
+  const auto signed_mean{utils::mean<double>(utils::numeric::exact, signed_list.begin(), signed_list.end())};
+  const auto unsigned_mean{utils::mean(utils::numeric::exact, unsigned_list.begin(), unsigned_list.end())};
+  EXPECT_NEAR(unsigned_mean, 0x1p63, 0x1p59);
+  for_each_simd_level([&] {
+    EXPECT_EQ(utils::mean<double>(utils::numeric::exact, signed_values.begin(), signed_values.end()),
+              signed_mean);
+    EXPECT_EQ(utils::mean(utils::numeric::exact, unsigned_values.begin(), unsigned_values.end()),
+              unsigned_mean);
+  });
+}
+
+/**
+ * sum_of_products, dot and weighted_mean function tests.
+ */
+
+TEST(SumOfProducts, MatchesInnerProduct) {
+  const std::vector vec1{1, 2, 3, 4};
+  const std::list vec2{5, 6, 7, 8};
+  EXPECT_EQ(utils::sum_of_products(vec1.begin(), vec1.end(), vec2.begin(), 10), 80);
+  EXPECT_EQ(utils::sum_of_products(vec1.begin(), vec1.begin(), vec2.begin(), 10), 10);
+  utils::MultiIterator first(vec1.begin(), vec2.begin());
+  utils::MultiIterator last(vec1.end(), vec2.end());
+  EXPECT_EQ(utils::sum_of_products(first, last, 0), 70);
+}
+
+TEST(Dot, IntegersDoNotOverflow) {
+  const std::vector<std::int32_t> vec1(4, 1 << 20);
+  const std::vector<std::int32_t> vec2(4, 1 << 20);
+  EXPECT_EQ(utils::dot<std::int64_t>(vec1.begin(), vec1.end(), vec2.begin()),
+            std::int64_t{1} << 42);
+}
+
+TEST(Dot, BitIdenticalOnEverySimdLevel) {
+  std::mt19937 gen{9};
+  std::normal_distribution<double> dist{0.0, 100.0};
+  std::vector<double> doubles1(50'003);
+  std::vector<double> doubles2(doubles1.size());
+  for (std::size_t i{0}; i < doubles1.size(); ++i) {
+    doubles1[i] = dist(gen);
+    doubles2[i] = dist(gen);
+  }
+  const std::vector<float> floats1(doubles1.begin(), doubles1.end());
+  const std::vector<float> floats2(doubles2.begin(), doubles2.end());
+  for (const std::size_t n : {1, 15, 17, 2049, 50'003}) {
+    std::vector<double> float_dots;
+    std::vector<double> double_dots;
+    for_each_simd_level([&] {
+      float_dots.push_back(utils::dot<double>(floats1.begin(), floats1.begin() + n, floats2.begin()));
+      double_dots.push_back(utils::dot(doubles1.begin(), doubles1.begin() + n, doubles2.begin()));
+    });
+    long double exact{0};
+    for (std::size_t i{0}; i < n; ++i) {
+      exact += static_cast<long double>(doubles1[i]) * doubles2[i];
+    }
+    for (std::size_t i{1}; i < float_dots.size(); ++i) {
+      EXPECT_EQ(float_dots[i], float_dots[0]) << "n = " << n;
+    }
+    for (const auto result : double_dots) {
+      EXPECT_NEAR(result, static_cast<double>(exact), 1e-9 * std::sqrt(static_cast<double>(n)) * 1e4);
+    }
+  }
+}
+
+TEST(WeightedMean, ContiguousAndGenericPathsAgree) {
+  //! [weighted_mean_start]
+  const std::vector values{1.0, 2.0, 3.0, 4.0};
+  const std::vector weights{4.0, 3.0, 2.0, 1.0};
+  const auto result{utils::weighted_mean(values.begin(), values.end(), weights.begin())};
+  //! [weighted_mean_end]
+  EXPECT_DOUBLE_EQ(result, 2.0);
+  const std::list list(weights.begin(), weights.end());
+  EXPECT_DOUBLE_EQ(utils::weighted_mean(values.begin(), values.end(), list.begin()), 2.0);
+  utils::MultiIterator first(values.begin(), weights.begin());
+  utils::MultiIterator last(values.end(), weights.end());
+  EXPECT_DOUBLE_EQ(utils::weighted_mean(first, last), 2.0);
+  EXPECT_DOUBLE_EQ(utils::dot(first, last), 20.0);
+}
+
+TEST(WeightedMean, LargeFloatRange) {
+  std::vector<float> values(100'001);
+  std::vector<float> weights(values.size());
+  for (std::size_t i{0}; i < values.size(); ++i) {
+    values[i] = static_cast<float>(i % 7);
+    weights[i] = static_cast<float>(i % 3 + 1);
+  }
+  long double products{0};
+  long double sum{0};
+  for (std::size_t i{0}; i < values.size(); ++i) {
+    products += values[i] * weights[i];
+    sum += weights[i];
+  }
+  for_each_simd_level([&] {
+    EXPECT_FLOAT_EQ(utils::weighted_mean(values.begin(), values.end(), weights.begin()),
+                    static_cast<float>(products / sum));
+  });
+}
+
+TEST(WeightedMean, ZeroWeightsAndIntegers) {
+  const std::vector values{1, 2, 3};
+  const std::vector weights{0, 0, 0};
+  EXPECT_EQ(utils::weighted_mean(values.begin(), values.end(), weights.begin()), 0);
+  const std::vector int_weights{1, 1, 2};
+  EXPECT_EQ(utils::weighted_mean(values.begin(), values.end(), int_weights.begin()), 2);
+  EXPECT_DOUBLE_EQ(utils::weighted_mean<double>(values.begin(), values.end(), int_weights.begin()),
+                   2.25);
+}
+
+/**
+ * inclusive_scan and exclusive_scan function tests.
+ */
+
+TEST(InclusiveScan, SmallRange) {
+  //! [inclusive_scan_start]
+  const std::vector vec{1, 2, 3, 4, 5};
+  std::vector<int> result(vec.size());
+  utils::inclusive_scan(vec.begin(), vec.end(), result.begin());
+  //! [inclusive_scan_end]
+  EXPECT_EQ(result, (std::vector{1, 3, 6, 10, 15}));
+  std::list<int> list;
+  utils::inclusive_scan(vec.begin(), vec.end(), std::back_inserter(list));
+  EXPECT_EQ(list, (std::list{1, 3, 6, 10, 15}));
+}
+
+TEST(InclusiveScan, WidensInt32IntoInt64) {
+  const std::vector<std::int32_t> vec(1001, std::numeric_limits<std::int32_t>::max());
+  std::vector<std::int64_t> result(vec.size());
+  for_each_simd_level([&] {
+    EXPECT_EQ(utils::inclusive_scan(vec.begin(), vec.end(), result.begin()), result.end());
+    for (std::size_t i{0}; i < vec.size(); ++i) {
+      ASSERT_EQ(result[i], static_cast<std::int64_t>(i + 1) * vec[0]);
+    }
+  });
+}
+
+TEST(InclusiveScan, InPlaceAndBitIdenticalOnEverySimdLevel) {
+  std::mt19937 gen{10};
+  std::normal_distribution<double> dist{0.0, 1e3};
+  std::vector<double> doubles(10'003);
+  for (auto &v : doubles) {
+    v = dist(gen);
+  }
+  const std::vector<float> floats(doubles.begin(), doubles.end());
+  std::vector<std::vector<double>> double_results;
+  std::vector<std::vector<float>> float_results;
+  for_each_simd_level([&] {
+    auto d{doubles};
+    utils::inclusive_scan(d.begin(), d.end(), d.begin());
+    double_results.push_back(d);
+    std::vector<float> f(floats.size());
+    utils::inclusive_scan(floats.begin(), floats.end(), f.begin());
+    float_results.push_back(f);
+  });
+  for (std::size_t i{1}; i < double_results.size(); ++i) {
+    EXPECT_EQ(double_results[i], double_results[0]);
+    EXPECT_EQ(float_results[i], float_results[0]);
+  }
+  long double exact{0};
+  for (std::size_t i{0}; i < doubles.size(); ++i) {
+    exact += doubles[i];
+    ASSERT_NEAR(double_results[0][i], static_cast<double>(exact), 1e-8);
+  }
+}
+
+TEST(ExclusiveScan, MatchesStandardLibrary) {
+  std::vector<std::int64_t> vec(1000);
+  std::iota(vec.begin(), vec.end(), -300);
+  std::vector<std::int64_t> expected(vec.size());
+  std::exclusive_scan(vec.begin(), vec.end(), expected.begin(), std::int64_t{7});
+  for_each_simd_level([&] {
+    std::vector<std::int64_t> result(vec.size());
+    utils::exclusive_scan(vec.begin(), vec.end(), result.begin(), std::int64_t{7});
+    EXPECT_EQ(result, expected);
+    auto in_place{vec};
+    utils::exclusive_scan(in_place.begin(), in_place.end(), in_place.begin(), 7);
+    EXPECT_EQ(in_place, expected);
+  });
+}
+
+TEST(ExclusiveScan, CsrOffsets) {
+  //! [exclusive_scan_start]
+  const std::vector<std::int32_t> counts{3, 0, 2, 5};
+  std::vector<std::int64_t> offsets(counts.size() + 1);
+  utils::exclusive_scan(counts.begin(), counts.end(), offsets.begin(), 0);
+  offsets.back() = offsets[counts.size() - 1] + counts.back();
+  //! [exclusive_scan_end]
+  EXPECT_EQ(offsets, (std::vector<std::int64_t>{0, 3, 3, 5, 10}));
+  const std::vector<float> floats{0.5f, 0.25f, 0.25f, 1.0f, 2.0f};
+  std::vector<float> result(floats.size());
+  for_each_simd_level([&] {
+    utils::exclusive_scan(floats.begin(), floats.end(), result.begin(), 1.0f);
+    EXPECT_EQ(result, (std::vector{1.0f, 1.5f, 1.75f, 2.0f, 3.0f}));
+  });
+}
+
+TEST(Scan, ParallelIsIndependentOfThreadCount) {
+  std::mt19937 gen{11};
+  std::normal_distribution<double> dist{0.0, 1e3};
+  std::vector<double> doubles(300'007);
+  for (auto &v : doubles) {
+    v = dist(gen);
+  }
+  std::vector<std::int32_t> ints(doubles.size());
+  std::iota(ints.begin(), ints.end(), -150'000);
+  std::vector<std::int64_t> expected_ints(ints.size());
+  utils::inclusive_scan(ints.begin(), ints.end(), expected_ints.begin());
+  std::vector<double> expected(doubles.size());
+  utils::exclusive_scan(utils::execution::par, doubles.begin(), doubles.end(), expected.begin(), 0.0);
+  for (const std::size_t threads : {1, 2, 3, 8}) {
+    const utils::execution::parallel_policy policy{threads};
+    std::vector<double> result(doubles.size());
+    EXPECT_EQ(utils::exclusive_scan(policy, doubles.begin(), doubles.end(), result.begin(), 0.0),
+              result.end());
+    EXPECT_EQ(result, expected);
+    std::vector<std::int64_t> int_result(ints.size());
+    utils::inclusive_scan(utils::execution::parallel_policy{threads, 1000}, ints.begin(), ints.end(),
+                          int_result.begin());
+    EXPECT_EQ(int_result, expected_ints);
+  }
+  std::vector<double> sequential(doubles.size());
+  utils::exclusive_scan(utils::execution::seq, doubles.begin(), doubles.end(), sequential.begin(), 0.0);
+  for (std::size_t i{0}; i < doubles.size(); ++i) {
+    ASSERT_NEAR(expected[i], sequential[i], 1e-7);
+  }
+}
+
+/**
+ * running_stats tests.
+ */
+
+/**
+ * Two-pass reference statistics.
+ */
+template <typename It> std::pair<double, double> mean_and_variance(It first, It last) {
+  const auto n{static_cast<double>(std::distance(first, last))};
+  long double sum{0};
+  for (auto it{first}; it != last; ++it) {
+    sum += *it;
+  }
+  const auto mean{static_cast<double>(sum / n)};
+  long double m2{0};
+  for (auto it{first}; it != last; ++it) {
+    m2 += (*it - mean) * (*it - mean);
+  }
+  return {mean, static_cast<double>(m2 / n)};
+}
+
+TEST(RunningStats, EmptyRange) {
+  const std::vector<double> vec{};
+  const auto result{utils::stats(vec.begin(), vec.end())};
+  EXPECT_EQ(result.count(), 0);
+  EXPECT_EQ(result.mean(), 0.0);
+  EXPECT_EQ(result.variance(), 0.0);
+  EXPECT_EQ(result.sample_variance(), 0.0);
+  EXPECT_FALSE(result.has_extrema());
+}
+
+TEST(RunningStats, SmallRange) {
+  //! [stats_start]
+  const std::vector vec{2, 4, 4, 4, 5, 5, 7, 9};
+  const auto result{utils::stats(vec.begin(), vec.end())};
+  //! [stats_end]
+  EXPECT_EQ(result.count(), 8);
+  EXPECT_DOUBLE_EQ(result.mean(), 5.0);
+  EXPECT_DOUBLE_EQ(result.variance(), 4.0);
+  EXPECT_DOUBLE_EQ(result.sample_variance(), 32.0 / 7.0);
+  EXPECT_EQ(result.min(), 2);
+  EXPECT_EQ(result.max(), 9);
+  EXPECT_EQ(result.argmax(), 7);
+}
+
+TEST(RunningStats, MatchesTwoPassReference) {
+  std::mt19937 gen{5};
+  std::normal_distribution<double> dist{1e6, 3.0};
+  std::vector<double> vec(100'003);
+  for (auto &v : vec) {
+    v = dist(gen);
+  }
+  vec[54'321] = 2e6;
+  vec[77'777] = 2e6;
+  vec[12'345] = -5.0;
+  const auto [mean, variance] = mean_and_variance(vec.begin(), vec.end());
+  const std::list<double> list(vec.begin(), vec.end());
+  for (const auto &result : {utils::stats(vec.begin(), vec.end()),
+                             utils::stats(list.begin(), list.end())}) {
+    EXPECT_EQ(result.count(), vec.size());
+    EXPECT_NEAR(result.mean(), mean, 1e-14 * mean);
+    EXPECT_NEAR(result.variance(), variance, 1e-9 * variance);
+    EXPECT_EQ(result.min(), -5.0);
+    EXPECT_EQ(result.max(), 2e6);
+    EXPECT_EQ(result.argmax(), 54'321);
+  }
+}
+
+TEST(RunningStats, SkipsNaNInExtrema) {
+  const auto nan{std::numeric_limits<float>::quiet_NaN()};
+  std::vector<float> vec(5000, 1.0f);
+  vec[0] = nan;
+  vec[17] = 3.0f;
+  vec[4000] = -2.0f;
+  const auto result{utils::stats(vec.begin(), vec.end())};
+  EXPECT_TRUE(std::isnan(result.mean()));
+  EXPECT_EQ(result.min(), -2.0f);
+  EXPECT_EQ(result.max(), 3.0f);
+  EXPECT_EQ(result.argmax(), 17);
+
+  const std::vector<float> nans(3, nan);
+  EXPECT_FALSE(utils::stats(nans.begin(), nans.end()).has_extrema());
+}
+
+TEST(RunningStats, ChunksAndMergeMatchWholeRange) {
+  std::vector<std::int32_t> vec(50'000);
+  std::mt19937 gen{6};
+  std::uniform_int_distribution<std::int32_t> dist{-1'000'000, 1'000'000};
+  for (auto &v : vec) {
+    v = dist(gen);
+  }
+  const auto whole{utils::stats(vec.begin(), vec.end())};
+
+  utils::running_stats<std::int32_t> streamed;
+  for (std::size_t begin{0}; begin < vec.size(); begin += 777) {
+    streamed.update(vec.begin() + begin, vec.begin() + std::min(vec.size(), begin + 777));
+  }
+  utils::running_stats<std::int32_t> back{30'000};
+  back.update(vec.begin() + 30'000, vec.end());
+  utils::running_stats<std::int32_t> merged;
+  for (std::size_t i{0}; i < 30'000; ++i) {
+    merged.push(vec[i]);
+  }
+  merged.merge(back);
+
+  for (const auto &result : {streamed, merged}) {
+    EXPECT_EQ(result.count(), whole.count());
+    EXPECT_NEAR(result.mean(), whole.mean(), 1e-6);
+    EXPECT_NEAR(result.variance(), whole.variance(), 1e-9 * whole.variance());
+    EXPECT_EQ(result.min(), whole.min());
+    EXPECT_EQ(result.max(), whole.max());
+    EXPECT_EQ(result.argmax(), whole.argmax());
+    EXPECT_EQ(result.offset(), vec.size());
+  }
+}
+
+TEST(RunningStats, ParallelIsIndependentOfThreadCount) {
+  std::mt19937 gen{7};
+  std::normal_distribution<float> dist{0.0f, 10.0f};
+  std::vector<float> vec(200'001);
+  for (auto &v : vec) {
+    v = dist(gen);
+  }
+  const auto sequential{utils::stats(vec.begin(), vec.end())};
+  const auto result{utils::stats(utils::execution::par, vec.begin(), vec.end())};
+  for (const std::size_t threads : {1, 2, 3, 8}) {
+    const auto other{
+        utils::stats(utils::execution::parallel_policy{threads}, vec.begin(), vec.end())};
+    EXPECT_EQ(other.mean(), result.mean());
+    EXPECT_EQ(other.variance(), result.variance());
+  }
+  EXPECT_EQ(result.mean(), sequential.mean());
+  EXPECT_EQ(result.variance(), sequential.variance());
+  EXPECT_EQ(result.min(), sequential.min());
+  EXPECT_EQ(result.argmax(), sequential.argmax());
+  EXPECT_EQ(utils::stats<double>(utils::execution::seq, vec.begin(), vec.end()).count(),
+            vec.size());
+}
+
+TEST(RunningStats, ParallelMatchesSequential) {
+  std::mt19937 gen{8};
+  std::uniform_real_distribution<double> dist{-1e6, 1e5};
+  std::vector<double> vec(1 << 18);
+  for (auto &v : vec) {
+    v = dist(gen);
+  }
+  const auto sequential{utils::stats(vec.begin(), vec.end())};
+  const auto parallel{utils::stats(utils::execution::parallel_policy{4}, vec.begin(), vec.end())};
+  EXPECT_EQ(parallel.mean(), sequential.mean());
+  EXPECT_EQ(parallel.variance(), sequential.variance());
+  EXPECT_EQ(parallel.argmax(), sequential.argmax());
+
+  const std::deque<double> deq(vec.begin(), vec.begin() + 10'000);
+  const auto deq_parallel{utils::stats(utils::execution::par, deq.begin(), deq.end())};
+  EXPECT_EQ(deq_parallel.mean(), utils::stats(deq.begin(), deq.end()).mean());
+  EXPECT_EQ(deq_parallel.variance(), utils::stats(deq.begin(), deq.end()).variance());
+}
+
+/**
+ * quantile_sketch tests.
+ */
+
+TEST(QuantileSketch, EmptySketch) {
+  const utils::quantile_sketch<double> sketch;
+  EXPECT_TRUE(sketch.empty());
+  EXPECT_EQ(sketch.quantile(0.5), 0.0);
+  EXPECT_EQ(sketch.rank(1.0), 0.0);
+}
+
+TEST(QuantileSketch, SmallRangeIsExact) {
+  //! [quantile_sketch_start]
+  const std::vector vec{5.0, 1.0, 4.0, 2.0, 3.0};
+  const auto sketch{utils::make_quantile_sketch(vec.begin(), vec.end())};
+  const auto median{sketch.quantile(0.5)};
+  //! [quantile_sketch_end]
+  EXPECT_EQ(median, 3.0);
+  EXPECT_EQ(sketch.count(), 5);
+  EXPECT_EQ(sketch.quantile(0.0), 1.0);
+  EXPECT_EQ(sketch.quantile(1.0), 5.0);
+  EXPECT_DOUBLE_EQ(sketch.rank(2.0), 0.4);
+}
+
+TEST(QuantileSketch, BoundedRankErrorOnLargeStream) {
+  std::mt19937 gen{12};
+  std::exponential_distribution<double> dist{1.0};
+  std::vector<double> vec(2'000'000);
+  for (auto &v : vec) {
+    v = dist(gen);
+  }
+  vec[123] = std::numeric_limits<double>::quiet_NaN();
+  utils::quantile_sketch<double> sketch;
+  for (std::size_t begin{0}; begin < vec.size(); begin += 4096) {
+    sketch.insert(vec.begin() + begin, vec.begin() + std::min(vec.size(), begin + 4096));
+  }
+  EXPECT_EQ(sketch.count(), vec.size() - 1);
+  vec.erase(vec.begin() + 123);
+  std::sort(vec.begin(), vec.end());
+  const std::vector ranks{0.01, 0.5, 0.9, 0.99, 0.999};
+  std::vector<double> results;
+  sketch.quantiles(ranks.begin(), ranks.end(), std::back_inserter(results));
+  for (std::size_t i{0}; i < ranks.size(); ++i) {
+    const auto position{std::lower_bound(vec.begin(), vec.end(), results[i]) - vec.begin()};
+    EXPECT_NEAR(static_cast<double>(position) / static_cast<double>(vec.size()), ranks[i], 0.02)
+        << "q = " << ranks[i];
+  }
+  EXPECT_EQ(sketch.min(), vec.front());
+  EXPECT_EQ(sketch.max(), vec.back());
+}
+
+TEST(QuantileSketch, MergeMatchesSingleSketch) {
+  std::vector<std::int32_t> vec(300'000);
+  std::iota(vec.begin(), vec.end(), 0);
+  std::shuffle(vec.begin(), vec.end(), std::mt19937{13});
+  auto merged{utils::make_quantile_sketch(vec.begin(), vec.begin() + 100'000)};
+  merged.merge(utils::make_quantile_sketch(vec.begin() + 100'000, vec.end()));
+  EXPECT_EQ(merged.count(), vec.size());
+  EXPECT_EQ(merged.min(), 0);
+  EXPECT_EQ(merged.max(), 299'999);
+  for (const auto q : {0.1, 0.5, 0.99}) {
+    EXPECT_NEAR(merged.quantile(q), q * 300'000, 0.02 * 300'000);
+  }
+}
+
+TEST(QuantileSketch, ShardedSketchMergesOnRead) {
+  utils::sharded_quantile_sketch<double> sketch{200, 4};
+  std::vector<std::thread> threads;
+  for (int t{0}; t < 4; ++t) {
+    threads.emplace_back([&sketch, t] {
+      std::vector<double> batch(1000);
+      for (int i{0}; i < 100; ++i) {
+        std::iota(batch.begin(), batch.end(), (t * 100 + i) * 1000.0);
+        sketch.insert(batch.begin(), batch.end());
+      }
+      sketch.insert(-1.0);
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  const auto snapshot{sketch.snapshot()};
+  EXPECT_EQ(snapshot.count(), 400'004);
+  EXPECT_EQ(snapshot.min(), -1.0);
+  EXPECT_EQ(snapshot.max(), 399'999.0);
+  EXPECT_NEAR(snapshot.quantile(0.5), 200'000.0, 0.02 * 400'000);
+}
@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include <libutils/type_traits.hpp>
+#include <array>
 #include <list>
+#include <string>
 #include <vector>
 
 /**
@@ -31,6 +33,39 @@ TEST(HasPushBack, CustomTypeWithoutPushBack) {
   EXPECT_FALSE(utils::has_push_back_v<Custom>);
 }
 
+/**
+ * IsContiguousIterator tests.
+ */
+
+TEST(IsContiguousIterator, PointerIsContiguous) {
+  EXPECT_TRUE(utils::is_contiguous_iterator_v<int *>);
+  EXPECT_TRUE(utils::is_contiguous_iterator_v<const double *>);
+}
+
+TEST(IsContiguousIterator, VectorIteratorIsContiguous) {
+  EXPECT_TRUE(utils::is_contiguous_iterator_v<std::vector<int>::iterator>);
+  EXPECT_TRUE(
+      utils::is_contiguous_iterator_v<std::vector<float>::const_iterator>);
+}
+
+TEST(IsContiguousIterator, StringIteratorIsContiguous) {
+  EXPECT_TRUE(utils::is_contiguous_iterator_v<std::string::iterator>);
+  EXPECT_TRUE(utils::is_contiguous_iterator_v<std::string::const_iterator>);
+}
+
+TEST(IsContiguousIterator, VectorBoolIteratorIsNotContiguous) {
+  EXPECT_FALSE(utils::is_contiguous_iterator_v<std::vector<bool>::iterator>);
+}
+
+TEST(IsContiguousIterator, ListIteratorIsNotContiguous) {
+  EXPECT_FALSE(utils::is_contiguous_iterator_v<std::list<int>::iterator>);
+}
+
+TEST(IsContiguousIterator, OutputIteratorIsNotContiguous) {
+  EXPECT_FALSE(utils::is_contiguous_iterator_v<
+               std::back_insert_iterator<std::vector<int>>>);
+}
+
 /**
  * HasInsert tests.
  */